@@ -7,6 +7,7 @@
 
 bool CLog::isInitialized;
 int  CLog::theLogLevel;
+FILE* CLog::theOutput = stdout;
 
 // Conditional logger. Replaces printf or std::cout. 
 void CLog::write(int logLevel, const char *szFormat, ...) {
@@ -14,7 +15,7 @@ void CLog::write(int logLevel, const char *szFormat, ...) {
    if (logLevel >= theLogLevel) {
       va_list args;
       va_start(args, szFormat);
-      vprintf(szFormat, args);
+      vfprintf(theOutput, szFormat, args);
       va_end(args);
    }
 }
@@ -30,6 +31,11 @@ bool CLog::setLevel(int logLevel) {
    return true;
 }
 
+// Sets the stream written to.
+void CLog::setOutput(FILE* output) {
+   theOutput = output;
+}
+
 // Ensures the logging level is initialized before the first call.
 void CLog::checkInit(int logLevel) {
    if (!isInitialized) {
@@ -14,8 +14,26 @@
 class CLog {
    public:
       enum { ALL = 0, VERBOSE, METRICS };
+      
+      // Lowest level compiled into the build. Release builds keep METRICS only; the debug build (make csma_sim_debug) 
+      // defines CLOG_RUNTIME_LEVEL to keep every level and select between them at run time.
+#ifdef CLOG_RUNTIME_LEVEL
+      static constexpr int COMPILED_LEVEL = ALL;
+#else
+      static constexpr int COMPILED_LEVEL = METRICS;
+#endif
+      
       static void write(int logLevel, const char *szFormat, ...);
       static bool setLevel(int logLevel);
+      
+      // Sets the stream written to (stdout unless set).
+      static void setOutput(FILE* output);
+      
+      // Returns true if logLevel is compiled in and passes the runtime level. Inline so that CLOG_WRITE() can skip 
+      // evaluating its arguments.
+      static bool isEnabled(int logLevel) {
+         return logLevel >= COMPILED_LEVEL && (!isInitialized || logLevel >= theLogLevel);
+      }
 
    protected:
       static void checkInit(int logLevel);
@@ -25,6 +43,19 @@ class CLog {
       CLog();
       static bool isInitialized;
       static int  theLogLevel;
+      static FILE* theOutput;
 };
 
+// Conditional log front end for the hot paths. logLevel must be a constant: a call site below CLog::COMPILED_LEVEL is 
+// discarded at compile time (whatever the optimization level), arguments included; otherwise the arguments are only 
+// evaluated if the runtime level passes.
+#define CLOG_WRITE(logLevel, ...)                           \
+   do {                                                     \
+      if constexpr ((logLevel) >= CLog::COMPILED_LEVEL) {   \
+         if (CLog::isEnabled(logLevel)) {                   \
+            CLog::write((logLevel), __VA_ARGS__);           \
+         }                                                  \
+      }                                                     \
+   } while (0)
+
 #endif   // __CLOG__
@@ -0,0 +1,58 @@
+/*
+ * Implementation of the allocation counter. In the diagnostic build (COUNT_ALLOCATIONS defined) the global operator 
+ * new is replaced by one that counts the allocations made by each thread.
+ */
+
+#include <cstdlib>   // malloc, free
+#include <new>       // std::bad_alloc
+
+#include "alloccount.h"
+
+// Count of heap allocations made by the calling thread.
+static thread_local unsigned long theThreadAllocationCount = 0;
+
+#ifdef COUNT_ALLOCATIONS
+// Counting replacement of the global allocation functions.
+void* operator new(std::size_t size) {
+   theThreadAllocationCount++;
+   void* memory = std::malloc(size ? size : 1);
+   if (!memory) {
+      throw std::bad_alloc();
+   }
+   return memory;
+}
+
+void* operator new[](std::size_t size) {
+   return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+   std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+   std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+   std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+   std::free(memory);
+}
+#endif   // COUNT_ALLOCATIONS
+
+// Returns true if allocations are being counted (diagnostic build only).
+bool isAllocationCountingEnabled() {
+#ifdef COUNT_ALLOCATIONS
+   return true;
+#else
+   return false;
+#endif
+}
+
+// Returns the count of heap allocations made so far by the calling thread (always 0 outside the diagnostic build).
+unsigned long getThreadAllocationCount() {
+   return theThreadAllocationCount;
+}
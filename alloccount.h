@@ -0,0 +1,16 @@
+/*
+ * Declaration of the allocation counter. In the diagnostic build (COUNT_ALLOCATIONS defined, see make csma_sim_alloc) 
+ * the global operator new is replaced by one that counts the allocations made by each thread. Used to prove that the 
+ * steady-state slot loop does not allocate.
+ */
+
+#ifndef __ALLOCCOUNT_H__
+#define __ALLOCCOUNT_H__
+
+// Returns true if allocations are being counted (diagnostic build only).
+bool isAllocationCountingEnabled();
+
+// Returns the count of heap allocations made so far by the calling thread (always 0 outside the diagnostic build).
+unsigned long getThreadAllocationCount();
+
+#endif   // __ALLOCCOUNT_H__
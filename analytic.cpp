@@ -0,0 +1,763 @@
+/*
+ * Implementation of the AnalyticModel class. The analytic fast path of csma_sim --analytic.
+ */
+
+#include <algorithm>    // std::max, std::min
+#include <chrono>
+#include <cmath>        // exp, fabs, floor, ldexp, lgamma, log, log1p, pow
+#include <iostream>
+
+#include "CLog.h"
+#include "analytic.h"
+#include "protocol.h"
+
+// Generated frame counts less likely than this are left out of the chain.
+static const double ARRIVAL_CUTOFF = 1e-13;
+
+// Limits of the fixed point and of the Gauss-Seidel sweeps of each of its iterations, and the changes below which 
+// each counts as converged.
+static const int MAX_FIXED_POINT_ITERATIONS = 200;
+static const double FIXED_POINT_TOLERANCE = 1e-7;
+static const unsigned long MAX_SOLVER_SWEEPS = 20000;
+static const double SOLVER_TOLERANCE = 1e-12;
+
+// Highest collision stage tracked by the chain (see determineBackoffDueProb()).
+static const int MAX_COLLISION_STAGE = 10;
+
+// Tolerance of the Gauss-Seidel sweeps in the first iteration of the fixed point, and share of the change of its 
+// parameters that the tolerance is narrowed to in the iterations after.
+static const double INITIAL_SOLVER_TOLERANCE = 1e-4;
+static const double SOLVER_TOLERANCE_SHARE = 1e-2;
+
+// Shares of the frames dropped and of the transmission attempts that collide, and mean count of back-offs per frame 
+// transmitted, above which the model is flagged as out of its depth.
+static const double QUEUEING_WARNING_SHARE = 0.05;
+static const double COLLISION_WARNING_SHARE = 0.2;
+static const double BACKOFF_WARNING_COUNT = 2;
+
+// Offered load, in frames generated per frame length by all the nodes together, up to which the model was checked 
+// against the simulator (within 10% on the frames transmitted and 30% on the collisions and drops, for every protocol, 
+// for 6 and 20 nodes, frame lengths of 5 to 20 time slots and buffer depths of 1 and 10).
+static const double VALIDATED_OFFERED_LOAD = 0.15;
+
+// Helper function that returns the probability of count successes in trials Bernoulli trials, given the logs of the 
+// probabilities of success and of failure.
+static double determineBinomialProbability(int trials, int count, double logSuccess, double logFailure) {
+   return exp(lgamma(trials + 1.0) - lgamma(count + 1.0) - lgamma(trials - count + 1.0) 
+              + count * logSuccess + (trials - count) * logFailure);
+}
+
+// AnalyticModel class constructor. CSMA/CD holds the medium for a one slot jam after a collision and CSMA/CA for the 
+// whole frame; the other protocols free it in the next time slot, or hold it for the whole frame with 
+// COLLISION_MODEL=frame.
+AnalyticModel::AnalyticModel(Configuration* configObj) {
+   theConfigObj = configObj;
+   theCsmaType = configObj->getCsmaType();
+   theNodeCount = configObj->getNodeCount();
+   theFrameLength = configObj->getFrameLength();
+   theCollisionLength = 1;
+   if (CSMA_CD == theCsmaType) {
+      theCollisionLength = 2;
+   }
+   else if (CSMA_CA == theCsmaType || FRAME_COLLISIONS == configObj->getCollisionModel()) {
+      theCollisionLength = theFrameLength;
+   }
+   theCollisionBackoffDelay = CSMA_CA == theCsmaType ? 0 : theCollisionLength - 1;
+   theMaxBackoffRetransmitCount = configObj->getMaxBackoffRetransmitCount();
+   theMessageBufferDepth = configObj->getMessageBufferDepth();
+   theProbFrameGeneration = configObj->getProbFrameGeneration();
+   theProbPersistence = P_PERSISTENT == theCsmaType ? configObj->getProbOfPersistance() : 1.0;
+   
+   theCollisionStageCount = std::min(theMaxBackoffRetransmitCount, MAX_COLLISION_STAGE) + 1;
+   thePhaseCount = PHASE_BUSY + (theFrameLength - 1) + theCollisionStageCount * (theCollisionLength + 1);
+   theStateCount = (theNodeCount + 1) * thePhaseCount;
+   
+   theBackoffDueProb = 1;
+   theBackoffShare = 1;
+   theSuccessStartBackoffs = 0;
+   theCollisionStartBackoffs = 0;
+   theSuccessBackoffShare = 1;
+   theCollisionBackoffShare = 1;
+   theQueuedProb = 0;
+   
+   theSuccessRate = 0;
+   theFreshSuccessRate = 0;
+   theColliderRate = 0;
+   theBusySenseRate = 0;
+   theDeferralRate = 0;
+   theDropRate = 0;
+   theMeanHolders = 0;
+   theMeanDelay = 0;
+   theMeanBackoffs = 0;
+   theCollisionShare = 0;
+   theBufferLoad = 0;
+   
+   theFixedPointIterations = 0;
+   theSolverSweeps = 0;
+   theIsFixedPointConverged = false;
+   theIsChainConverged = false;
+   theSolveSeconds = 0;
+}
+
+// Returns true if configObj can be modelled: every node hears every other node on a single channel.
+bool AnalyticModel::isSupported(Configuration* configObj) {
+   return !configObj->isTopologyEnabled() && 1 == configObj->getChannelCount();
+}
+
+// Solves the chain for back-off parameters that are moved halfway to the values its solution implies, until they 
+// stop moving, and derives the expected metrics from the last solution.
+void AnalyticModel::solve() {
+   std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+   tabulateArrivals();
+   
+   // Start with every node in its first back-off stage, and with every state alike (a Gauss-Seidel sweep only keeps 
+   // the probability that flows into a state, so a single starting state would be emptied).
+   theBackoffDueProb = 1 / determineMeanBackoff(0);
+   theDistribution.assign(theStateCount, 1.0 / theStateCount);
+   
+   // The chain changes with the parameters, so it is only solved as closely as they have settled, and to 
+   // SOLVER_TOLERANCE once they stop moving.
+   double solverTolerance = INITIAL_SOLVER_TOLERANCE;
+   theIsFixedPointConverged = false;
+   for (theFixedPointIterations = 1; theFixedPointIterations <= MAX_FIXED_POINT_ITERATIONS;
+        theFixedPointIterations++) {
+      buildChain();
+      theIsChainConverged = solveChain(solverTolerance);
+      double change = updateBackoffParameters();
+      if (change < FIXED_POINT_TOLERANCE && theIsChainConverged) {
+         if (SOLVER_TOLERANCE == solverTolerance) {
+            theIsFixedPointConverged = true;
+            break;
+         }
+         solverTolerance = SOLVER_TOLERANCE;
+      }
+      else {
+         solverTolerance = std::max(SOLVER_TOLERANCE, std::min(solverTolerance, change * SOLVER_TOLERANCE_SHARE));
+      }
+   }
+   theFixedPointIterations = std::min(theFixedPointIterations, MAX_FIXED_POINT_ITERATIONS);
+   
+   // The delay and drops were set by the last update of the parameters.
+   double backoffRate = theColliderRate + theBusySenseRate + theDeferralRate;
+   theMeanBackoffs = theSuccessRate > 0 ? backoffRate / theSuccessRate : 0;
+   double attemptRate = theSuccessRate + theColliderRate + theBusySenseRate;
+   theCollisionShare = attemptRate > 0 ? theColliderRate / attemptRate : 0;
+   
+   theSolveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Prints the expected metrics of every node over one simulation of TIME_SLOT_COUNT time slots, in the format of 
+// printOverallMetrics(). The nodes are alike, so one block stands for them all.
+void AnalyticModel::printMetrics() {
+   unsigned long timeSlots = theConfigObj->getTimeSlotCount();
+   double slotsPerNode = static_cast<double>(timeSlots) / theNodeCount;
+   
+   CLog::write(CLog::METRICS, "[analytic model of %d nodes: %d states, %d fixed-point iterations, %lu solver sweeps, "
+                              "%.3f seconds]\n", 
+                              theNodeCount, 
+                              theStateCount, 
+                              theFixedPointIterations, 
+                              theSolverSweeps, 
+                              theSolveSeconds);
+   CLog::write(CLog::METRICS, "[expected values over one simulation of %lu timeslots]\n", timeSlots);
+   CLog::write(CLog::METRICS, "   [every node]\n");
+   
+   double transmitting = theSuccessRate * theFrameLength * slotsPerNode;
+   CLog::write(CLog::METRICS, "     time slots idle: %.2f (%.4f of clock cycles)\n", 
+                              timeSlots - transmitting, 
+                              (timeSlots - transmitting) / timeSlots);
+   CLog::write(CLog::METRICS, "     time slots transmitting: %.2f (%.4f of clock cycles)\n", 
+                              transmitting, 
+                              transmitting / timeSlots);
+   
+   double generated = theProbFrameGeneration * timeSlots;
+   CLog::write(CLog::METRICS, "     messages generated: %.2f (%.4f of clock cycles)\n", 
+                              generated, 
+                              generated / timeSlots);
+   
+   double attempts = (theSuccessRate + theColliderRate + theBusySenseRate) * slotsPerNode;
+   CLog::write(CLog::METRICS, "     transmission attempts: %.2f\n", 
+                              attempts);
+   
+   double collisions = theColliderRate * slotsPerNode;
+   CLog::write(CLog::METRICS, "     collisions: %.2f (%.4f of transmission attempts)\n", 
+                              collisions, 
+                              theCollisionShare);
+   CLog::write(CLog::METRICS, "                       (%.4f of clock cycles)\n", 
+                              collisions / timeSlots);
+   
+   double dropped = theDropRate * slotsPerNode;
+   CLog::write(CLog::METRICS, "     messages dropped: %.2f (%.4f of messages generated)\n", 
+                              dropped, 
+                              generated > 0 ? dropped / generated : 0.0);
+   
+   double transmitted = theSuccessRate * slotsPerNode;
+   CLog::write(CLog::METRICS, "     messages transmitted: %.2f (%.4f of messages generated)\n", 
+                              transmitted, 
+                              generated > 0 ? transmitted / generated : 0.0);
+   // As in printOverallMetrics(), the waits are divided by the time slots spent transmitting, so the two reports 
+   // compare line by line; the mean delay of a message follows on its own line.
+   double waited = theMeanDelay * transmitted;
+   CLog::write(CLog::METRICS, "     time slots messages waited: %.2f (%.2f per message transmitted)\n", 
+                              waited, 
+                              transmitting > 0 ? waited / transmitting : 0.0);
+   CLog::write(CLog::METRICS, "     mean delay per message transmitted: %.2f\n", 
+                              theMeanDelay);
+   
+   // The maximum and the quantiles need the distribution of the back-offs per frame, which the chain does not keep.
+   CLog::write(CLog::METRICS, "     back-offs per message transmitted: %.2f\n", 
+                              theMeanBackoffs);
+   CLog::write(CLog::METRICS, "\n");
+}
+
+// Prints the column names of the sweep result rows, the columns of printSweepHeader() up to drop_ratio.
+void AnalyticModel::printSweepHeader() {
+   CLog::write(CLog::METRICS, "point,PROTOCOL_TYPE,NODE_COUNT,PROB_FRAME_GENERATION,PROB_PERSISTENCE,FRAME_LENGTH,"
+                              "MAX_RETRANSMIT_ATTEMPTS,offered_load,throughput,mean_delay,collisions_per_attempt,"
+                              "drop_ratio\n");
+}
+
+// Prints the result row of the sweep point pointIndex. The offered load and throughput are in frames' worth of time 
+// slots per time slot, as in printSweepRow().
+void AnalyticModel::printSweepRow(unsigned int pointIndex) {
+   const char* protocolNames[] = { "Non-Persistent", "1-Persistent", "p-Persistent", "CSMA/CD", "CSMA/CA" };
+   double generationRate = theProbFrameGeneration * theNodeCount;
+   CLog::write(CLog::METRICS, "%u,%s,%d,%g,%g,%d,%d,%.6f,%.6f,%.4f,%.6f,%.6f\n", 
+                              pointIndex, 
+                              protocolNames[theCsmaType], 
+                              theNodeCount, 
+                              theConfigObj->getProbFrameGeneration(), 
+                              theConfigObj->getProbOfPersistance(), 
+                              theFrameLength, 
+                              theMaxBackoffRetransmitCount, 
+                              generationRate * theFrameLength, 
+                              theSuccessRate * theFrameLength, 
+                              theMeanDelay, 
+                              theCollisionShare, 
+                              generationRate > 0 ? theDropRate / generationRate : 0.0);
+}
+
+// Prints a warning, led by prefix, for each assumption of the model that the solution breaks.
+void AnalyticModel::printWarnings(std::string prefix) {
+   if (!theIsChainConverged) {
+      std::cout << "WARNING - " << prefix << "the chain was not stationary after " << MAX_SOLVER_SWEEPS
+                << " Gauss-Seidel sweeps; the results are approximate" << std::endl;
+   }
+   if (!theIsFixedPointConverged) {
+      std::cout << "WARNING - " << prefix << "the back-off parameters did not settle within "
+                << MAX_FIXED_POINT_ITERATIONS << " iterations; the results are approximate" << std::endl;
+   }
+   
+   // The queueing takes the time at the head of the buffer to be memoryless, which holds while drops are rare.
+   double generationRate = theNodeCount * theProbFrameGeneration;
+   double dropShare = generationRate > 0 ? theDropRate / generationRate : 0;
+   if (dropShare > QUEUEING_WARNING_SHARE || (theMessageBufferDepth > 1 && theBufferLoad >= 1)) {
+      std::cout << "WARNING - " << prefix << 100 * dropShare << "% of the frames are dropped (buffer load " 
+                << theBufferLoad << "); the delay and drops take the time a frame spends at the head of its buffer " 
+                << "to be memoryless, so they are rough at this load" << std::endl;
+   }
+   
+   // A node that senses the medium often before it transmits draws its back-offs from deep stages, whose long 
+   // windows a single due probability averages away.
+   if (P_PERSISTENT != theCsmaType && theMeanBackoffs > BACKOFF_WARNING_COUNT) {
+      std::cout << "WARNING - " << prefix << "a frame takes " << theMeanBackoffs 
+                << " back-offs on average; the model's memoryless back-off is loose this deep into the back-off " 
+                << "stages, so check the attempts and the delay by simulation" << std::endl;
+   }
+   
+   // The other warnings flag the loads at which a single assumption breaks; beyond the loads the model was checked at, 
+   // they may all hold and the results still be off.
+   double offeredLoad = generationRate * theFrameLength;
+   if (offeredLoad > VALIDATED_OFFERED_LOAD) {
+      std::cout << "WARNING - " << prefix << "the offered load is " << offeredLoad << " frames per frame length, " 
+                << "above the " << VALIDATED_OFFERED_LOAD << " the model is validated to; its collisions and drops " 
+                << "may be off by more than 30%, so check the point by simulation" << std::endl;
+   }
+   
+   // Collisions among more than two nodes correlate the back-offs of the colliding nodes beyond what the collision 
+   // stages follow.
+   if (theCollisionShare > COLLISION_WARNING_SHARE) {
+      std::cout << "WARNING - " << prefix << 100 * theCollisionShare
+                << "% of the transmission attempts collide; the model's memoryless back-off is loose at this load, "
+                << "so check the point by simulation" << std::endl;
+   }
+}
+
+// Tabulates the distribution of the count of frames generated in a time slot by each count of nodes, without the 
+// counts less likely than ARRIVAL_CUTOFF. It is computed in logs, so that it neither underflows nor overflows.
+void AnalyticModel::tabulateArrivals() {
+   double probability = theProbFrameGeneration;
+   theArrivalProbabilities.assign(theNodeCount + 1, std::vector<double>());
+   theArrivalFirsts.assign(theNodeCount + 1, 0);
+   for (int trials = 0; trials <= theNodeCount; trials++) {
+      if (0 == trials || probability <= 0 || probability >= 1) {
+         theArrivalFirsts[trials] = probability >= 1 ? trials : 0;
+         theArrivalProbabilities[trials].assign(1, 1.0);
+         continue;
+      }
+      
+      // Widen the range around the most likely count while the counts are likely enough.
+      double logSuccess = log(probability);
+      double logFailure = log1p(-probability);
+      int mode = std::min(trials, static_cast<int>(floor((trials + 1) * probability)));
+      int first = mode, last = mode;
+      while (first > 0 && determineBinomialProbability(trials, first - 1, logSuccess, logFailure) > ARRIVAL_CUTOFF) {
+         first--;
+      }
+      while (last < trials 
+          && determineBinomialProbability(trials, last + 1, logSuccess, logFailure) > ARRIVAL_CUTOFF) {
+         last++;
+      }
+      
+      std::vector<double>& probabilities = theArrivalProbabilities[trials];
+      double total = 0;
+      for (int count = first; count <= last; count++) {
+         probabilities.push_back(determineBinomialProbability(trials, count, logSuccess, logFailure));
+         total += probabilities.back();
+      }
+      for (unsigned int index = 0; index < probabilities.size(); index++) {
+         probabilities[index] /= total;
+      }
+      theArrivalFirsts[trials] = first;
+   }
+}
+
+// Fills theIncoming, theSelfProbabilities and theStateRates for the current back-off parameters. The transitions are 
+// listed by the state they leave, then sorted (by counting) into rows by the state they enter.
+void AnalyticModel::buildChain() {
+   std::vector<Transition> transitions;
+   theStateRates.assign(theStateCount, StateRates());
+   for (int holderCount = 0; holderCount <= theNodeCount; holderCount++) {
+      for (int phase = 0; phase < thePhaseCount; phase++) {
+         if (isIdlePhase(phase)) {
+            addIdleTransitions(holderCount, phase, transitions);
+         }
+         else {
+            addBusyTransitions(holderCount, phase, transitions);
+         }
+      }
+   }
+   
+   theSelfProbabilities.assign(theStateCount, 0);
+   theIncomingOffsets.assign(theStateCount + 1, 0);
+   for (unsigned long index = 0; index < transitions.size(); index++) {
+      if (transitions[index].fromState == transitions[index].toState) {
+         theSelfProbabilities[transitions[index].toState] += transitions[index].probability;
+      }
+      else {
+         theIncomingOffsets[transitions[index].toState + 1]++;
+      }
+   }
+   for (int state = 0; state < theStateCount; state++) {
+      theIncomingOffsets[state + 1] += theIncomingOffsets[state];
+   }
+   theIncoming.resize(theIncomingOffsets[theStateCount]);
+   std::vector<unsigned long> fill(theIncomingOffsets.begin(), theIncomingOffsets.end() - 1);
+   for (unsigned long index = 0; index < transitions.size(); index++) {
+      if (transitions[index].fromState != transitions[index].toState) {
+         theIncoming[fill[transitions[index].toState]++] = transitions[index];
+      }
+   }
+}
+
+// Adds the transitions and rates of a state with the medium idle. The nodes holding a frame that come due, and the 
+// nodes that generate one, transmit (with PROB_PERSISTENCE for p-persistent): none leaves the medium idle, one starts 
+// a transmit and more collide. After a transmit whose node has another frame queued, that node contends as if its 
+// frame had just been generated.
+void AnalyticModel::addIdleTransitions(int holderCount, int phase, std::vector<Transition>& transitions) {
+   int queuedCount = PHASE_IDLE_AFTER_QUEUED_SUCCESS == phase ? 1 : 0;
+   if (holderCount < queuedCount) {
+      return;
+   }
+   
+   int fromState = getState(holderCount, phase);
+   StateRates& rates = theStateRates[fromState];
+   int stage = getCollisionStage(phase);
+   int nextStage = std::min(stage + 1, theCollisionStageCount - 1);
+   int waitingCount = holderCount - queuedCount;
+   double dueProb = determineDueProb(phase);
+   double persistence = theProbPersistence;
+   double attemptProb = dueProb * persistence;
+   double waitingSilent = pow(1 - attemptProb, waitingCount);
+   double waitingAlone = waitingCount > 0 ? waitingCount * attemptProb * pow(1 - attemptProb, waitingCount - 1) : 0;
+   
+   std::vector<double>& arrivalProbabilities = theArrivalProbabilities[theNodeCount - holderCount];
+   int firstArrivals = theArrivalFirsts[theNodeCount - holderCount];
+   for (unsigned int index = 0; index < arrivalProbabilities.size(); index++) {
+      int arrivals = firstArrivals + index;
+      int freshCount = arrivals + queuedCount;
+      double arrivalProb = arrivalProbabilities[index];
+      double freshSilent = pow(1 - persistence, freshCount);
+      double freshAlone = freshCount > 0 ? freshCount * persistence * pow(1 - persistence, freshCount - 1) : 0;
+      double noneProb = arrivalProb * waitingSilent * freshSilent;
+      double oneProb = arrivalProb * (waitingAlone * freshSilent + waitingSilent * freshAlone);
+      double manyProb = std::max(0.0, arrivalProb - noneProb - oneProb);
+      int nextHolderCount = holderCount + arrivals;
+      
+      if (noneProb > 0) {
+         Transition transition = { fromState, 
+                                   getState(nextHolderCount, stage < 0 ? PHASE_IDLE : getCollisionBackoffPhase(stage)), 
+                                   noneProb };
+         transitions.push_back(transition);
+      }
+      if (oneProb > 0) {
+         if (theFrameLength > 1) {
+            Transition transition = { fromState, getState(nextHolderCount, getSuccessPhase(theFrameLength - 1)), 
+                                      oneProb };
+            transitions.push_back(transition);
+         }
+         else {
+            addSuccessEndTransitions(fromState, nextHolderCount, oneProb, transitions);
+         }
+         rates.successes += oneProb;
+         rates.successBackoffs += oneProb * (nextHolderCount - 1);
+         if (freshCount > 0) {
+            rates.freshSuccesses += arrivalProb * waitingSilent * freshAlone * arrivals / freshCount;
+         }
+      }
+      if (manyProb > 0) {
+         Transition transition = { fromState, 
+                                   theCollisionLength > 1 
+                                      ? getState(nextHolderCount, getCollisionPhase(nextStage, theCollisionLength - 1)) 
+                                      : getState(nextHolderCount, getAfterCollisionPhase(nextStage)), 
+                                   manyProb };
+         transitions.push_back(transition);
+         rates.collisions += manyProb;
+         rates.collisionBackoffs += manyProb * nextHolderCount;
+         if (1 == theCollisionLength) {
+            rates.collisionEndHolders += manyProb * nextHolderCount;
+         }
+      }
+      
+      // The colliders are the transmitters when more than one transmits.
+      rates.colliders += arrivalProb * (waitingCount * attemptProb + freshCount * persistence) - oneProb;
+      rates.deferrals += arrivalProb * (waitingCount * dueProb + freshCount) * (1 - persistence);
+   }
+   rates.colliders = std::max(0.0, rates.colliders);
+}
+
+// Adds the transitions and rates of a state with the medium busy. The nodes that generate a frame, and the nodes 
+// holding one that come due, sense the medium busy; once the last busy time slot is over, the transmitter lets go of 
+// its frame. A 1-persistent (or CSMA/CD) node senses in every busy time slot once it has sensed in one: those that 
+// were in back-off when the medium turned busy have each come due in the time slots so far with the due probability, 
+// and the rest have joined since.
+void AnalyticModel::addBusyTransitions(int holderCount, int phase, std::vector<Transition>& transitions) {
+   int stage = getCollisionStage(phase);
+   bool isSuccess = stage < 0;
+   int busyLeft = isSuccess ? theFrameLength - 1 - (phase - PHASE_BUSY) 
+                            : getAfterCollisionPhase(stage) - phase;
+   if (holderCount < (isSuccess ? 1 : 2)) {
+      return;
+   }
+   
+   int fromState = getState(holderCount, phase);
+   StateRates& rates = theStateRates[fromState];
+   int waitingCount = isSuccess ? holderCount - 1 : holderCount;
+   if (ONE_PERSISTENT == theCsmaType || CSMA_CD == theCsmaType) {
+      int busySlots = (isSuccess ? theFrameLength : theCollisionLength) - busyLeft;
+      double startBackoffs = std::min(static_cast<double>(waitingCount), 
+                                      isSuccess ? theSuccessStartBackoffs : theCollisionStartBackoffs);
+      rates.busySenses = startBackoffs * (1 - pow(1 - theBackoffDueProb, busySlots)) + waitingCount - startBackoffs;
+   }
+   else {
+      rates.busySenses = waitingCount * determineDueProb(phase);
+   }
+   
+   std::vector<double>& arrivalProbabilities = theArrivalProbabilities[theNodeCount - holderCount];
+   int firstArrivals = theArrivalFirsts[theNodeCount - holderCount];
+   for (unsigned int index = 0; index < arrivalProbabilities.size(); index++) {
+      int arrivals = firstArrivals + index;
+      double arrivalProb = arrivalProbabilities[index];
+      int nextHolderCount = holderCount + arrivals;
+      rates.busySenses += arrivalProb * arrivals;
+      
+      if (1 == busyLeft && isSuccess) {
+         addSuccessEndTransitions(fromState, nextHolderCount, arrivalProb, transitions);
+         rates.successEndHolders += arrivalProb * (nextHolderCount - 1);
+      }
+      else if (1 == busyLeft) {
+         Transition transition = { fromState, getState(nextHolderCount, getAfterCollisionPhase(stage)), arrivalProb };
+         transitions.push_back(transition);
+         rates.collisionEndHolders += arrivalProb * nextHolderCount;
+      }
+      else {
+         Transition transition = { fromState, getState(nextHolderCount, phase + 1), arrivalProb };
+         transitions.push_back(transition);
+      }
+   }
+}
+
+// Adds the transitions, of probability probability in all, from fromState to the end of a transmit with 
+// holderCount nodes holding a frame (the transmitter included). The transmitter keeps holding one if it has another 
+// queued.
+void AnalyticModel::addSuccessEndTransitions(int fromState, int holderCount, double probability, 
+                                             std::vector<Transition>& transitions) {
+   if (theQueuedProb < 1) {
+      Transition transition = { fromState, 
+                                getState(holderCount - 1, PHASE_IDLE_AFTER_SUCCESS), 
+                                probability * (1 - theQueuedProb) };
+      transitions.push_back(transition);
+   }
+   if (theQueuedProb > 0) {
+      Transition transition = { fromState, 
+                                getState(holderCount, PHASE_IDLE_AFTER_QUEUED_SUCCESS), 
+                                probability * theQueuedProb };
+      transitions.push_back(transition);
+   }
+}
+
+// Returns the probability that a node holding a frame, and not transmitting it, senses the medium in a time slot of 
+// phase. A node in back-off comes due with theBackoffDueProb; a 1-persistent (or CSMA/CD) node that waited out the 
+// busy medium senses in the first idle time slot, and a p-persistent node that deferred senses in every time slot. 
+// CSMA/CA back-offs are frozen while the medium is busy.
+double AnalyticModel::determineDueProb(int phase) {
+   double waitingShare = 0;
+   switch (theCsmaType) {
+      case ONE_PERSISTENT:
+      case CSMA_CD:
+         if (PHASE_IDLE_AFTER_SUCCESS == phase || PHASE_IDLE_AFTER_QUEUED_SUCCESS == phase) {
+            waitingShare = 1 - theSuccessBackoffShare;
+         }
+         else if (getCollisionStage(phase) >= 0 && getAfterCollisionPhase(getCollisionStage(phase)) == phase) {
+            waitingShare = 1 - theCollisionBackoffShare;
+         }
+         break;
+      case P_PERSISTENT:
+         waitingShare = 1 - theBackoffShare;
+         break;
+      case CSMA_CA:
+         if (!isIdlePhase(phase)) {
+            return 0;
+         }
+         break;
+      default:
+         break;
+   }
+   return waitingShare + (1 - waitingShare) * determineBackoffDueProb(phase);
+}
+
+// Returns the probability that a node in back-off comes due in a time slot of phase. Outside the collision blocks it 
+// is theBackoffDueProb, that of a window of 2 / theBackoffDueProb - 1 time slots. The nodes of a collision draw their 
+// next back-off from a window twice as wide as the last, so each stage of collision doubles that window: the due 
+// probability falls with every collision in a row instead of trapping many nodes in repeated collisions.
+double AnalyticModel::determineBackoffDueProb(int phase) {
+   int stage = getCollisionStage(phase);
+   if (stage < 0) {
+      return theBackoffDueProb;
+   }
+   double window = 2 / theBackoffDueProb - 1;
+   return 2 / (ldexp(window, stage) + 1);
+}
+
+// Runs Gauss-Seidel sweeps on theDistribution until it is (all but) stationary: each state takes the probability 
+// flowing into it from the others, over the probability of leaving it, and the distribution is normalized after each 
+// sweep. The states are swept by ascending count of nodes holding a frame, the way most of the probability flows. 
+// Returns true if the distribution moved by less than tolerance in a sweep.
+bool AnalyticModel::solveChain(double tolerance) {
+   std::vector<double> lastDistribution(theStateCount);
+   for (unsigned long sweep = 0; sweep < MAX_SOLVER_SWEEPS; sweep++) {
+      theSolverSweeps++;
+      lastDistribution = theDistribution;
+      double total = 0;
+      for (int state = 0; state < theStateCount; state++) {
+         double inflow = 0;
+         for (unsigned long index = theIncomingOffsets[state]; index < theIncomingOffsets[state + 1]; index++) {
+            inflow += theDistribution[theIncoming[index].fromState] * theIncoming[index].probability;
+         }
+         
+         // A state that is (all but) never left keeps what it holds.
+         double leaveProb = 1 - theSelfProbabilities[state];
+         theDistribution[state] = leaveProb > 1e-15 ? inflow / leaveProb : theDistribution[state] + inflow;
+         total += theDistribution[state];
+      }
+      
+      double change = 0;
+      for (int state = 0; state < theStateCount; state++) {
+         theDistribution[state] /= total;
+         change += fabs(theDistribution[state] - lastDistribution[state]);
+      }
+      if (change < tolerance) {
+         return true;
+      }
+   }
+   return false;
+}
+
+// Adds up the expected events per time slot over the stationary distribution, and moves the parameters of the fixed 
+// point halfway to the values they imply (undamped, 1-persistent back-offs swing between their stages): 
+//  - the share of the senses ending in a back-off sets the mean back-off, whose inverse is the due probability; 
+//  - the p-persistent nodes in back-off are, by Little's law, the colliders per time slot times the mean back-off, 
+//    out of the nodes holding a frame that are not transmitting it; 
+//  - of the nodes left in back-off when a transmit or collision starts, those that do not come due while it lasts 
+//    are still in back-off, out of the nodes holding a frame when it ends; 
+//  - the time a frame spends at the head of its node's buffer is, by Little's law, the nodes holding a frame over 
+//    the transmits per time slot, and sets the queueing behind it. 
+// Returns the largest change the parameters were due (relative for the due probability and the counts of nodes).
+double AnalyticModel::updateBackoffParameters() {
+   double collisionRate = 0, successBackoffs = 0, collisionBackoffs = 0, successEndHolders = 0;
+   double collisionEndHolders = 0, transmitterCount = 0;
+   theSuccessRate = 0;
+   theFreshSuccessRate = 0;
+   theColliderRate = 0;
+   theBusySenseRate = 0;
+   theDeferralRate = 0;
+   theMeanHolders = 0;
+   for (int state = 0; state < theStateCount; state++) {
+      double stateProb = theDistribution[state];
+      StateRates& rates = theStateRates[state];
+      int phase = state % thePhaseCount;
+      theSuccessRate += stateProb * rates.successes;
+      theFreshSuccessRate += stateProb * rates.freshSuccesses;
+      collisionRate += stateProb * rates.collisions;
+      theColliderRate += stateProb * rates.colliders;
+      theBusySenseRate += stateProb * rates.busySenses;
+      theDeferralRate += stateProb * rates.deferrals;
+      successBackoffs += stateProb * rates.successBackoffs;
+      collisionBackoffs += stateProb * rates.collisionBackoffs;
+      successEndHolders += stateProb * rates.successEndHolders;
+      collisionEndHolders += stateProb * rates.collisionEndHolders;
+      theMeanHolders += stateProb * (state / thePhaseCount);
+      if (phase >= PHASE_BUSY && phase < PHASE_BUSY + theFrameLength - 1) {
+         transmitterCount += stateProb;
+      }
+   }
+   
+   double backoffRate = theColliderRate + theBusySenseRate + theDeferralRate;
+   double senseBackoffShare = backoffRate > 0 ? backoffRate / (backoffRate + theSuccessRate) : 0;
+   // Only the colliders' back-offs wait for the collision to end.
+   if (NON_PERSISTENT == theCsmaType && backoffRate > 0) {
+      theCollisionBackoffDelay = (theCollisionLength - 1) * theColliderRate / backoffRate;
+   }
+   double meanBackoff = determineMeanBackoff(senseBackoffShare);
+   double waitingCount = theMeanHolders - transmitterCount;
+   double backoffDueProb = 1 / meanBackoff;
+   double backoffShare = waitingCount > 0 ? std::min(1.0, theColliderRate * meanBackoff / waitingCount) : 1;
+   double successStartBackoffs = theSuccessRate > 0 ? successBackoffs / theSuccessRate : 0;
+   double collisionStartBackoffs = collisionRate > 0 ? collisionBackoffs / collisionRate : 0;
+   double successBackoffShare = successEndHolders > 0 
+                              ? std::min(1.0, pow(1 - theBackoffDueProb, theFrameLength - 1) 
+                                              * successBackoffs / successEndHolders) 
+                              : 1;
+   double collisionBackoffShare = collisionEndHolders > 0 
+                                ? std::min(1.0, pow(1 - theBackoffDueProb, theCollisionLength - 1) 
+                                                * collisionBackoffs / collisionEndHolders) 
+                                : 1;
+   double headTime = theSuccessRate > 0 ? theMeanHolders / theSuccessRate + 1 - theQueuedProb : 0;
+   double queuedProb = determineQueueing(headTime);
+   
+   double change = fabs(backoffDueProb - theBackoffDueProb) / theBackoffDueProb;
+   change = std::max(change, fabs(backoffShare - theBackoffShare));
+   change = std::max(change, fabs(successStartBackoffs - theSuccessStartBackoffs) / (1 + theSuccessStartBackoffs));
+   change = std::max(change, 
+                     fabs(collisionStartBackoffs - theCollisionStartBackoffs) / (1 + theCollisionStartBackoffs));
+   change = std::max(change, fabs(successBackoffShare - theSuccessBackoffShare));
+   change = std::max(change, fabs(collisionBackoffShare - theCollisionBackoffShare));
+   change = std::max(change, fabs(queuedProb - theQueuedProb));
+   theBackoffDueProb = (theBackoffDueProb + backoffDueProb) / 2;
+   theBackoffShare = (theBackoffShare + backoffShare) / 2;
+   theSuccessStartBackoffs = (theSuccessStartBackoffs + successStartBackoffs) / 2;
+   theCollisionStartBackoffs = (theCollisionStartBackoffs + collisionStartBackoffs) / 2;
+   theSuccessBackoffShare = (theSuccessBackoffShare + successBackoffShare) / 2;
+   theCollisionBackoffShare = (theCollisionBackoffShare + collisionBackoffShare) / 2;
+   theQueuedProb = (theQueuedProb + queuedProb) / 2;
+   return change;
+}
+
+// Sets theMeanDelay, theDropRate and theBufferLoad for the mean time a frame spends at the head of its node's message 
+// buffer (from its generation, or from the end of the transmit ahead of it, to the end of its own transmit), and 
+// returns the probability that a node has another frame queued when its transmit ends. 
+// 
+// With MESSAGE_BUFFER_DEPTH=1 a frame generated at a node holding one replaces it, so the frame transmitted is the 
+// last one generated: its delay is the shorter of the time at the head and the time since the last frame generated, 
+// which is geometric. The frames transmitted in the time slot they were generated in take FRAME_LENGTH; the time at 
+// the head of the others is taken as FRAME_LENGTH plus a geometric wait. 
+// 
+// With a deeper buffer the node is an M/M/1/K queue of MESSAGE_BUFFER_DEPTH frames served in the time at the head: 
+// the frames generated at a full buffer are dropped, and a node leaves a frame behind with the probability that a 
+// frame finds the buffer non-empty.
+double AnalyticModel::determineQueueing(double headTime) {
+   double probability = theProbFrameGeneration;
+   theBufferLoad = probability * headTime;
+   if (1 == theMessageBufferDepth) {
+      theDropRate = probability * theMeanHolders;
+      double laterHeadTime = theSuccessRate > theFreshSuccessRate 
+                           ? (headTime * theSuccessRate - theFrameLength * theFreshSuccessRate) 
+                             / (theSuccessRate - theFreshSuccessRate) 
+                           : theFrameLength;
+      double waitProb = 1 / (std::max(0.0, laterHeadTime - theFrameLength) + 1);
+      double silentProb = pow(1 - probability, theFrameLength) * waitProb / (1 - (1 - waitProb) * (1 - probability));
+      double laterDelay = probability > 0 ? (1 - silentProb) / probability : laterHeadTime;
+      theMeanDelay = theSuccessRate > 0 
+                   ? (theFreshSuccessRate * theFrameLength + (theSuccessRate - theFreshSuccessRate) * laterDelay) 
+                     / theSuccessRate 
+                   : 0;
+      return 0;
+   }
+   
+   // Probabilities of an empty and of a full buffer, and mean count of frames in it.
+   double load = theBufferLoad;
+   int depth = theMessageBufferDepth;
+   double emptyProb = 1.0 / (depth + 1), fullProb = 1.0 / (depth + 1), meanFrames = depth / 2.0;
+   if (fabs(load - 1) > 1e-9) {
+      emptyProb = (1 - load) / (1 - pow(load, depth + 1));
+      fullProb = emptyProb * pow(load, depth);
+      meanFrames = load / (1 - load) - (depth + 1) * pow(load, depth + 1) / (1 - pow(load, depth + 1));
+   }
+   theDropRate = theNodeCount * probability * fullProb;
+   theMeanDelay = probability > 0 ? meanFrames / (probability * (1 - fullProb)) : headTime;
+   return std::max(0.0, std::min(1.0, 1 - emptyProb / (1 - fullProb)));
+}
+
+// Returns the mean back-off, in time slots (idle time slots for CSMA/CA), given the share of senses that end in a 
+// back-off. A frame's k-th back-off is drawn from a window of 2^min(k, MAX_RETRANSMIT_ATTEMPTS) time slots (32 times 
+// that for CSMA/CA), and a frame reaches its k-th back-off with backoffShare^k. A back-off after a collision starts 
+// once the collision is over (the CSMA/CD jam, or the frame with COLLISION_MODEL=frame).
+double AnalyticModel::determineMeanBackoff(double backoffShare) {
+   int lastStage = std::min(theMaxBackoffRetransmitCount, 31);
+   double meanBackoff = 0, reachProb = 1;
+   for (int stage = 0; stage <= lastStage; stage++) {
+      unsigned long window = 1UL << stage;
+      if (CSMA_CA == theCsmaType) {
+         window = std::min(CsmaCaPolicy::CSMA_CA_MIN_WINDOW * window, 1UL << 31);
+      }
+      
+      // The last stage is kept by every frame that reaches it.
+      double stageProb = stage < lastStage ? reachProb * (1 - backoffShare) : reachProb;
+      meanBackoff += stageProb * ((window + 1) / 2.0 + theCollisionBackoffDelay);
+      reachProb *= backoffShare;
+   }
+   return meanBackoff;
+}
+
+// Helper function used to solve the analytic model of configObj, or of every point of its sweep, and print the 
+// results. Returns false if the configuration cannot be modelled.
+bool runAnalyticModel(Configuration* configObj) {
+   if (!AnalyticModel::isSupported(configObj)) {
+      std::cout << "ERROR - --analytic is not supported with TOPOLOGY or CHANNEL_COUNT > 1" << std::endl;
+      return false;
+   }
+   
+   if (!configObj->isSweepEnabled()) {
+      AnalyticModel model(configObj);
+      model.solve();
+      model.printMetrics();
+      model.printWarnings("");
+      return true;
+   }
+   
+   // Each point of a sweep is solved on its own, and reported as a row.
+   std::vector<Configuration> points;
+   if (!configObj->expandSweep(points)) {
+      std::cout << "ERROR - failed to expand the sweep" << std::endl;
+      return false;
+   }
+   CLog::write(CLog::METRICS, "Solving the analytic model at %lu points.\n", points.size());
+   AnalyticModel::printSweepHeader();
+   for (unsigned int pointIndex = 0; pointIndex < points.size(); pointIndex++) {
+      AnalyticModel model(&points[pointIndex]);
+      model.solve();
+      model.printSweepRow(pointIndex);
+      model.printWarnings("point " + std::to_string(pointIndex) + ": ");
+   }
+   return true;
+}
@@ -0,0 +1,246 @@
+/*
+ * Declaration of the AnalyticModel class. The analytic fast path of csma_sim --analytic: a discrete-time Markov chain 
+ * over the aggregate state of the collision domain, solved for its stationary distribution instead of simulating it. 
+ * The state is the count of nodes holding a frame (the transmitter included) and the phase of the medium: idle, idle 
+ * for the first time slot after a transmit (with or without another frame queued at its node), busy with a transmit 
+ * and the count of busy time slots left, or in a collision episode. The phases of a collision episode carry its stage, 
+ * the count of collisions in a row less one, up to 10: busy with the collision, the first idle time slot after it, 
+ * and the idle time slots after that until a node transmits. Every node sees the same medium, so the chain has 
+ * (NODE_COUNT + 1) x (FRAME_LENGTH + 2 + 11 x (FRAME_LENGTH + 1)) states at most, whatever the count of time slots.
+ *
+ * The chain follows the slot kernel's phases: the nodes without a frame each generate one with PROB_FRAME_GENERATION, 
+ * a new frame contends in the time slot it is generated in, and a transmit or collision holds the medium for as long 
+ * as the protocol takes to give up on it (see protocol.h). Two approximations make it aggregate:
+ *
+ *  - a node in binary exponential back-off comes due in each time slot (each idle time slot for CSMA/CA) with a fixed 
+ *    probability, one over the mean back-off, the mean being taken over the back-off stages a frame goes through 
+ *    given the share of its senses that end in a back-off (as in Bianchi's model of 802.11), save in a collision 
+ *    episode, where the window doubles with each stage as the colliders' own windows do; 
+ *  - a node that waits out a busy medium (1-persistent, CSMA/CD and p-persistent) is told apart from one in back-off 
+ *    only by the expected share of each, found from the flows of the chain.
+ *
+ * Both depend on the solution, so the chain is solved again, by Gauss-Seidel sweeps over its sparse transitions warm 
+ * started from the previous solution, until they reach a fixed point. The chain tracks the frame at the head of each 
+ * node's message buffer; the frames behind it are an M/M/1/K queue served in the mean time a frame spends at the head 
+ * (or, with MESSAGE_BUFFER_DEPTH=1, frames that replace the one held), which sets the drops, the delay and whether a 
+ * node has another frame to send when its transmit ends. printWarnings() flags the loads at which these 
+ * approximations stop being close.
+ */
+
+#ifndef __ANALYTIC_H__
+#define __ANALYTIC_H__
+
+#include <string>
+#include <vector>
+
+#include "helpers.h"
+
+class AnalyticModel {
+   public:
+      // Constructor with args. Reads the parameters of the model from configObj, which must be supported.
+      AnalyticModel(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Returns true if configObj can be modelled: every node hears every other node on a single channel.
+      static bool isSupported(Configuration* configObj);
+      
+      // Solves the chain and its fixed point, and derives the expected metrics.
+      void solve();
+      
+      // Prints the expected metrics of every node over one simulation of TIME_SLOT_COUNT time slots, in the format 
+      // of printOverallMetrics().
+      void printMetrics();
+      
+      // Prints the column names of the sweep result rows, the columns of printSweepHeader() up to drop_ratio.
+      static void printSweepHeader();
+      
+      // Prints the result row of the sweep point pointIndex.
+      void printSweepRow(unsigned int pointIndex);
+      
+      // Prints a warning, led by prefix, for each assumption of the model that the solution breaks.
+      void printWarnings(std::string prefix);
+   
+   private:
+      // Phases of the medium. The transmit phases follow, for each count of busy time slots left, then one block of 
+      // phases per collision stage (see getCollisionPhase()).
+      enum {
+         PHASE_IDLE = 0,                     // idle, and idle in the previous time slot
+         PHASE_IDLE_AFTER_SUCCESS,           // idle, first time slot after a transmit
+         PHASE_IDLE_AFTER_QUEUED_SUCCESS,    // idle, first time slot after a transmit whose node has another frame
+         PHASE_BUSY                          // first transmit phase
+      };
+      
+      // Expected events in a time slot spent in one state, over the time slot's arrivals and contention.
+      struct StateRates {
+         double successes;             // transmits started
+         double freshSuccesses;        // transmits started by a node in the time slot its frame was generated in
+         double collisions;            // collisions started
+         double colliders;             // nodes whose transmit collided
+         double busySenses;            // nodes that sensed the medium busy
+         double deferrals;             // p-persistent nodes that found the medium idle and deferred
+         double successBackoffs;       // nodes left in back-off when a transmit starts
+         double collisionBackoffs;     // nodes left in back-off when a collision starts
+         double successEndHolders;     // nodes holding a frame when a transmit ends, bar its own node
+         double collisionEndHolders;   // nodes holding a frame when a collision ends
+      };
+      
+      // One transition of the chain.
+      struct Transition {
+         int fromState;
+         int toState;
+         double probability;
+      };
+      
+      // Returns the state of holderCount nodes holding a frame with the medium in phase.
+      int getState(int holderCount, int phase) { return holderCount * thePhaseCount + phase; }
+      
+      // Returns the phase of a transmit with busyLeft busy time slots left (busyLeft in [1, FRAME_LENGTH - 1]).
+      int getSuccessPhase(int busyLeft) { return PHASE_BUSY + theFrameLength - 1 - busyLeft; }
+      
+      // Returns the phase of a collision of stage stage with busyLeft busy time slots left (busyLeft in 
+      // [1, theCollisionLength - 1]). Each stage has a block of theCollisionLength + 1 phases: the busy time slots of 
+      // the collision, the first idle time slot after it, and the idle time slots after that until a node transmits.
+      int getCollisionPhase(int stage, int busyLeft) {
+         return getCollisionBlock(stage) + theCollisionLength - 1 - busyLeft;
+      }
+      
+      // Returns the phase of the first idle time slot after a collision of stage stage.
+      int getAfterCollisionPhase(int stage) { return getCollisionBlock(stage) + theCollisionLength - 1; }
+      
+      // Returns the phase of the idle time slots after that, until a node transmits.
+      int getCollisionBackoffPhase(int stage) { return getCollisionBlock(stage) + theCollisionLength; }
+      
+      // Returns the first phase of the block of collision stage stage.
+      int getCollisionBlock(int stage) { return PHASE_BUSY + theFrameLength - 1 + stage * (theCollisionLength + 1); }
+      
+      // Returns the collision stage of phase, -1 outside the collision blocks.
+      int getCollisionStage(int phase) {
+         int firstBlock = getCollisionBlock(0);
+         return phase < firstBlock ? -1 : (phase - firstBlock) / (theCollisionLength + 1);
+      }
+      
+      // Returns true if the medium is idle in phase.
+      bool isIdlePhase(int phase) {
+         return phase < PHASE_BUSY 
+             || (phase >= getCollisionBlock(0) && phase >= getAfterCollisionPhase(getCollisionStage(phase)));
+      }
+      
+      // Tabulates the distribution of the count of frames generated in a time slot by each count of nodes.
+      void tabulateArrivals();
+      
+      // Fills theIncoming, theSelfProbabilities and theStateRates for the current back-off parameters.
+      void buildChain();
+      
+      // Adds the transitions and rates of a state with the medium idle.
+      void addIdleTransitions(int holderCount, int phase, std::vector<Transition>& transitions);
+      
+      // Adds the transitions and rates of a state with the medium busy.
+      void addBusyTransitions(int holderCount, int phase, std::vector<Transition>& transitions);
+      
+      // Adds the transitions, of probability probability in all, from fromState to the end of a transmit with 
+      // holderCount nodes holding a frame (the transmitter included).
+      void addSuccessEndTransitions(int fromState, int holderCount, double probability, 
+                                    std::vector<Transition>& transitions);
+      
+      // Returns the probability that a node holding a frame, and not transmitting it, senses the medium in a time 
+      // slot of phase.
+      double determineDueProb(int phase);
+      
+      // Returns the probability that a node in back-off comes due in a time slot of phase.
+      double determineBackoffDueProb(int phase);
+      
+      // Runs Gauss-Seidel sweeps on theDistribution until a sweep changes it by less than tolerance. Returns true if 
+      // it converged.
+      bool solveChain(double tolerance);
+      
+      // Adds up the expected events per time slot over the stationary distribution, and moves the back-off 
+      // parameters halfway to the values they imply. Returns the largest change the parameters were due.
+      double updateBackoffParameters();
+      
+      // Sets theMeanDelay, theDropRate and theBufferLoad for the mean time a frame spends at the head of its node's 
+      // message buffer, and returns the probability that a node has another frame queued when its transmit ends.
+      double determineQueueing(double headTime);
+      
+      // Returns the mean back-off, in time slots (idle time slots for CSMA/CA), given the share of senses that end 
+      // in a back-off.
+      double determineMeanBackoff(double backoffShare);
+      
+      // Configuration shared (read-only) by every point.
+      Configuration* theConfigObj;
+      
+      // Parameters of the model, read once.
+      CSMA_TYPE theCsmaType;
+      int theNodeCount;
+      int theFrameLength;
+      int theCollisionLength;
+      int theMaxBackoffRetransmitCount;
+      int theMessageBufferDepth;
+      double theProbFrameGeneration;
+      double theProbPersistence;
+      
+      // Time slots a back-off waits, on average, for the collision that started it to end (a share of the colliders' 
+      // wait for non-persistent CSMA, whose busy medium also starts back-offs).
+      double theCollisionBackoffDelay;
+      
+      // Count of collision stages, of phases, and of states.
+      int theCollisionStageCount;
+      int thePhaseCount;
+      int theStateCount;
+      
+      // Distribution of the count of frames generated by m nodes, from theArrivalFirsts[m] on.
+      std::vector<std::vector<double> > theArrivalProbabilities;
+      std::vector<int> theArrivalFirsts;
+      
+      // Transitions into each state, in compressed sparse row form (the transitions into state j are 
+      // theIncoming[theIncomingOffsets[j], theIncomingOffsets[j + 1])), with the probability of staying put apart.
+      std::vector<unsigned long> theIncomingOffsets;
+      std::vector<Transition> theIncoming;
+      std::vector<double> theSelfProbabilities;
+      std::vector<StateRates> theStateRates;
+      
+      // Stationary distribution of the chain.
+      std::vector<double> theDistribution;
+      
+      // Parameters of the fixed point: the probability that a node in back-off comes due in a time slot, the share 
+      // of the p-persistent nodes holding a frame that are in back-off, the mean count of nodes in back-off when a 
+      // transmit or collision starts and the share of the nodes holding a frame that are still in back-off when it 
+      // ends, and the probability that a node has another frame queued when its transmit ends.
+      double theBackoffDueProb;
+      double theBackoffShare;
+      double theSuccessStartBackoffs;
+      double theCollisionStartBackoffs;
+      double theSuccessBackoffShare;
+      double theCollisionBackoffShare;
+      double theQueuedProb;
+      
+      // Expected events per time slot, over every node.
+      double theSuccessRate;
+      double theFreshSuccessRate;
+      double theColliderRate;
+      double theBusySenseRate;
+      double theDeferralRate;
+      double theDropRate;
+      
+      // Expected count of nodes holding a frame, mean delay of a frame transmitted and mean count of back-offs it 
+      // took, share of the transmission attempts that collided, and load of each node's message buffer (frames 
+      // generated per frame its node can transmit).
+      double theMeanHolders;
+      double theMeanDelay;
+      double theMeanBackoffs;
+      double theCollisionShare;
+      double theBufferLoad;
+      
+      // Solver statistics.
+      int theFixedPointIterations;
+      unsigned long theSolverSweeps;
+      bool theIsFixedPointConverged;
+      bool theIsChainConverged;
+      double theSolveSeconds;
+};
+
+// Helper function used to solve the analytic model of configObj, or of every point of its sweep, and print the 
+// results. Returns false if the configuration cannot be modelled.
+bool runAnalyticModel(Configuration* configObj);
+
+#endif   // __ANALYTIC_H__
@@ -0,0 +1,314 @@
+/*
+ * This file is the main driver file for csma_sim_bench, the benchmark suite of the simulator's own speed (see make 
+ * bench). Usage: csma_sim_bench <output file> [baseline file]
+ *
+ * The slot kernel, determineNodeStates(), is timed over a matrix of node counts, frame generation probabilities and 
+ * protocols, followed by microbenchmarks of the per-node operations it is built from: carrier sensing, the message 
+ * buffer and the random draws. Every benchmark is one CSV row of the output, identified by its first four columns. 
+ * Given the output of an earlier run as the baseline, each row is also compared to its baseline row on the console.
+ */
+
+#include <algorithm>    // std::max
+#include <chrono>
+#include <cmath>        // exp, log
+#include <cstdio>
+#include <cstdlib>      // atof
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "helpers.h"
+#include "node.h"
+#include "nodestore.h"
+#include "protocol.h"
+
+// Time each benchmark is run for, after its warm-up, in seconds.
+static const double BENCH_MIN_SECONDS = 0.1;
+
+// Time slots (at most) run before the slot kernel is timed, so that the buffers and back-offs settle.
+static const unsigned long BENCH_WARMUP_SLOTS = 2000;
+
+// Seed of every benchmark, so that each run times the same slots.
+static const uint64_t BENCH_SEED = 1;
+
+// The matrix of the slot kernel benchmarks.
+static const int BENCH_NODE_COUNTS[] = { 6, 100, 1000, 10000, 100000 };
+static const float BENCH_LOADS[] = { 0.001f, 0.01f, 0.1f, 0.5f };
+static const CSMA_TYPE BENCH_PROTOCOLS[] = { NON_PERSISTENT, ONE_PERSISTENT, P_PERSISTENT, CSMA_CD, CSMA_CA };
+static const char* BENCH_PROTOCOL_NAMES[] = { "Non-Persistent", "1-Persistent", "p-Persistent", "CSMA/CD", "CSMA/CA" };
+
+// Nodes operated on by the microbenchmarks.
+static const int BENCH_MICRO_NODE_COUNT = 1024;
+
+// Receives the results of the microbenchmarks so that they are not optimized away.
+static volatile unsigned long theBenchSink;
+
+typedef std::chrono::steady_clock BenchClock;
+
+// One row of the results. An iteration is one time slot of the slot kernel, or one operation of a microbenchmark 
+// applied to nodeCount nodes.
+struct BenchResult {
+   std::string benchmark;
+   std::string protocol;
+   int nodeCount;
+   float load;
+   unsigned long iterationCount;
+   double seconds;
+};
+
+// Helper function that returns the seconds since start.
+static double determineElapsedSeconds(BenchClock::time_point start) {
+   return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// Helper function that calls operation (with the iteration index) in batches of batchSize until BENCH_MIN_SECONDS 
+// have passed, and stores the count of calls and the seconds they took in result.
+template <class Operation>
+static void runTimed(Operation operation, unsigned long batchSize, BenchResult& result) {
+   unsigned long iterationIndex = 0;
+   BenchClock::time_point start = BenchClock::now();
+   do {
+      for (unsigned long batchIndex = 0; batchIndex < batchSize; batchIndex++, iterationIndex++) {
+         operation(iterationIndex);
+      }
+      result.seconds = determineElapsedSeconds(start);
+   } while (result.seconds < BENCH_MIN_SECONDS);
+   result.iterationCount = iterationIndex;
+}
+
+// Helper function that returns the configuration of a benchmark. No INI is read: the keys not set here keep their 
+// defaults, and the rest are those of csma_config.ini.
+static Configuration* createBenchConfig(CSMA_TYPE csmaType, int nodeCount, float load) {
+   Configuration* configObj = new Configuration("/dev/null");
+   configObj->setVerboseEnabled(false);
+   configObj->setSimulationCount(1);
+   configObj->setTimeSlotCount(1UL << 40);
+   configObj->setCsmaType(csmaType);
+   configObj->setProbOfPersistance(0.1f);
+   configObj->setNodeCount(nodeCount);
+   configObj->setProbFrameGeneration(load);
+   configObj->setFrameLength(10);
+   configObj->setMaxBackoffRetransmitCount(10);
+   configObj->setSeed(BENCH_SEED);
+   return configObj;
+}
+
+// Times the slot kernel of one protocol, node count and load.
+static BenchResult benchSlotKernel(int protocolIndex, int nodeCount, float load) {
+   BenchResult result = { "slot_kernel", BENCH_PROTOCOL_NAMES[protocolIndex], nodeCount, load, 0, 0 };
+   Configuration* configObj = createBenchConfig(BENCH_PROTOCOLS[protocolIndex], nodeCount, load);
+   seedRandomGenerator(BENCH_SEED, 0);
+   NodeStore nodeStore(configObj);
+   SlotKernel slotKernel = selectSlotKernel(configObj->getCsmaType());
+   
+   // Sized as in Simulation, so that the timed slots do not allocate.
+   SlotScratch scratch;
+   scratch.serviceOrder.reserve(nodeCount);
+   scratch.nodeIndexes.reserve(nodeCount);
+   scratch.dueBits.assign((nodeCount + 63) / 64, 0);
+   scratch.waitingBits.assign((nodeCount + 63) / 64, 0);
+   scratch.arrivalBits.assign((nodeCount + 63) / 64, 0);
+   scratch.persistenceBits.assign((nodeCount + 63) / 64, 0);
+   scratch.isPersistenceDrawn = false;
+   
+   // Warm up for up to BENCH_WARMUP_SLOTS, but no longer than the timed part.
+   unsigned long timeIndex = 0;
+   BenchClock::time_point start = BenchClock::now();
+   while (timeIndex < BENCH_WARMUP_SLOTS && determineElapsedSeconds(start) < BENCH_MIN_SECONDS) {
+      slotKernel(nodeStore, timeIndex++, configObj, scratch);
+   }
+   
+   unsigned long firstTimeIndex = timeIndex;
+   runTimed([&](unsigned long iterationIndex) {
+               slotKernel(nodeStore, firstTimeIndex + iterationIndex, configObj, scratch);
+            },
+            std::max(1, 100000 / nodeCount),
+            result);
+   
+   delete configObj;
+   return result;
+}
+
+// Runs the microbenchmarks, appending their rows to results.
+static void benchMicro(std::vector<BenchResult>& results) {
+   Configuration* configObj = createBenchConfig(NON_PERSISTENT, BENCH_MICRO_NODE_COUNT, 0.01f);
+   seedRandomGenerator(BENCH_SEED, 0);
+   NodeStore nodeStore(configObj);
+   const unsigned long nodeMask = BENCH_MICRO_NODE_COUNT - 1;
+   uint64_t threshold = CounterRng::computeBernoulliThreshold(0.01);
+   
+   // Carrier sensing, as asked by a contending node.
+   BenchResult isMediumIdle = { "is_medium_idle", "-", 1, 0, 0, 0 };
+   runTimed([&](unsigned long iterationIndex) {
+               theBenchSink += nodeStore.getNode(iterationIndex & nodeMask)->isMediumIdle(iterationIndex);
+            },
+            4096,
+            isMediumIdle);
+   results.push_back(isMediumIdle);
+   
+   // A frame arrival buffered and the transmitted frame released, on an emptied buffer.
+   for (int nodeIndex = 0; nodeIndex < BENCH_MICRO_NODE_COUNT; nodeIndex++) {
+      nodeStore.clearMessages(nodeIndex);
+   }
+   BenchResult message = { "message_enqueue_dequeue", "-", 1, 0, 0, 0 };
+   runTimed([&](unsigned long iterationIndex) {
+               Node* nodeObj = nodeStore.getNode(iterationIndex & nodeMask);
+               nodeObj->addMessage(iterationIndex);
+               nodeObj->clearCurrentMessage();
+            },
+            4096,
+            message);
+   results.push_back(message);
+   
+   // A single Bernoulli draw, as for a frame arrival.
+   BenchResult bernoulli = { "rng_bernoulli", "-", 1, 0.01f, 0, 0 };
+   runTimed([&](unsigned long iterationIndex) {
+               theBenchSink += generateBernoulliTrial(threshold, 
+                                                      RNG_ARRIVAL, 
+                                                      iterationIndex & nodeMask, 
+                                                      iterationIndex);
+            },
+            4096,
+            bernoulli);
+   results.push_back(bernoulli);
+   
+   // The Bernoulli draws of every node at once, as for the persistence draws of a time slot.
+   std::vector<uint64_t> bits(BENCH_MICRO_NODE_COUNT / 64);
+   BenchResult bernoulliBatch = { "rng_bernoulli_batch", "-", BENCH_MICRO_NODE_COUNT, 0.01f, 0, 0 };
+   runTimed([&](unsigned long iterationIndex) {
+               generateBernoulliTrials(threshold, RNG_PERSISTENCE, BENCH_MICRO_NODE_COUNT, iterationIndex, &bits[0]);
+               theBenchSink += bits[0];
+            },
+            16,
+            bernoulliBatch);
+   results.push_back(bernoulliBatch);
+   
+   // A back-off drawn from a window of 1024 time slots.
+   BenchResult bounded = { "rng_bounded", "-", 1, 0, 0, 0 };
+   runTimed([&](unsigned long iterationIndex) {
+               theBenchSink += generateRandomIntegerMinToMax(1, 1024, RNG_BACKOFF, iterationIndex & nodeMask,
+                                                             iterationIndex);
+            },
+            4096,
+            bounded);
+   results.push_back(bounded);
+   
+   // The gap to a node's next frame arrival.
+   BenchResult geometric = { "rng_geometric", "-", 1, 0.01f, 0, 0 };
+   runTimed([&](unsigned long iterationIndex) {
+               theBenchSink += generateGeometricInterval(0.01f, RNG_ARRIVAL, iterationIndex & nodeMask, iterationIndex);
+            },
+            4096,
+            geometric);
+   results.push_back(geometric);
+   
+   delete configObj;
+}
+
+// Helper function that returns the columns identifying a row.
+static std::string determineRowKey(const std::string& benchmark, const std::string& protocol, int nodeCount,
+                                   float load) {
+   char text[256];
+   snprintf(text, sizeof(text), "%s,%s,%d,%g", benchmark.c_str(), protocol.c_str(), nodeCount, load);
+   return text;
+}
+
+// Helper function that reads the nanoseconds per iteration of each row of a baseline, keyed by determineRowKey(). 
+// Returns false if the baseline cannot be opened.
+static bool readBaseline(const char* fileName, std::map<std::string, double>& baseline) {
+   std::ifstream fileStream(fileName);
+   if (!fileStream) {
+      return false;
+   }
+   
+   // Skip the header, then take the key and the sixth column (ns_per_iteration) of every row.
+   std::string line;
+   std::getline(fileStream, line);
+   while (std::getline(fileStream, line)) {
+      std::vector<std::string> columns;
+      std::stringstream lineStream(line);
+      std::string column;
+      while (std::getline(lineStream, column, ',')) {
+         columns.push_back(column);
+      }
+      if (columns.size() >= 6) {
+         baseline[columns[0] + "," + columns[1] + "," + columns[2] + "," + columns[3]] = atof(columns[5].c_str());
+      }
+   }
+   return true;
+}
+
+int main(int argc, char* argv[]) {
+   if (argc < 2 || argc > 3) {
+      fprintf(stderr, "Usage: %s <output file> [baseline file]\n", argv[0]);
+      return 1;
+   }
+   
+   std::map<std::string, double> baseline;
+   if (3 == argc && !readBaseline(argv[2], baseline)) {
+      fprintf(stderr, "ERROR - failed to open baseline file: %s\n", argv[2]);
+      return 1;
+   }
+   
+   // Disable the per-slot logging, as a run would.
+   CLog::setLevel(CLog::METRICS);
+   
+   std::vector<BenchResult> results;
+   int protocolCount = sizeof(BENCH_PROTOCOLS) / sizeof(BENCH_PROTOCOLS[0]);
+   int nodeCountCount = sizeof(BENCH_NODE_COUNTS) / sizeof(BENCH_NODE_COUNTS[0]);
+   int loadCount = sizeof(BENCH_LOADS) / sizeof(BENCH_LOADS[0]);
+   for (int protocolIndex = 0; protocolIndex < protocolCount; protocolIndex++) {
+      for (int nodeCountIndex = 0; nodeCountIndex < nodeCountCount; nodeCountIndex++) {
+         for (int loadIndex = 0; loadIndex < loadCount; loadIndex++) {
+            results.push_back(benchSlotKernel(protocolIndex, 
+                                              BENCH_NODE_COUNTS[nodeCountIndex], 
+                                              BENCH_LOADS[loadIndex]));
+            fprintf(stderr, ".");
+         }
+      }
+   }
+   benchMicro(results);
+   fprintf(stderr, "\n");
+   
+   FILE* out = fopen(argv[1], "w");
+   if (NULL == out) {
+      fprintf(stderr, "ERROR - failed to open output file: %s\n", argv[1]);
+      return 1;
+   }
+   
+   // One row per benchmark. Rows are compared on their first four columns, so new benchmarks only add rows.
+   fprintf(out, "benchmark,protocol,nodes,load,iterations,ns_per_iteration,iterations_per_second,ns_per_node\n");
+   double logRatioSum = 0;
+   int comparedCount = 0;
+   for (std::vector<BenchResult>::iterator it = results.begin(); it != results.end(); it++) {
+      double nsPerIteration = 1e9 * it->seconds / it->iterationCount;
+      std::string key = determineRowKey(it->benchmark, it->protocol, it->nodeCount, it->load);
+      fprintf(out, "%s,%lu,%.6g,%.6g,%.6g\n",
+              key.c_str(),
+              it->iterationCount,
+              nsPerIteration,
+              it->iterationCount / it->seconds,
+              nsPerIteration / it->nodeCount);
+      
+      // The ratio is the time of this run over the baseline's: below 1 is faster.
+      std::map<std::string, double>::iterator baselineIt = baseline.find(key);
+      if (baselineIt != baseline.end() && baselineIt->second > 0) {
+         double ratio = nsPerIteration / baselineIt->second;
+         printf("%-60s %12.6g ns -> %12.6g ns  x%.3f\n", key.c_str(), baselineIt->second, nsPerIteration, ratio);
+         logRatioSum += log(ratio);
+         comparedCount++;
+      }
+   }
+   fclose(out);
+   
+   if (comparedCount > 0) {
+      printf("Geometric mean time ratio over %d benchmarks: x%.3f\n", comparedCount, exp(logRatioSum / comparedCount));
+   }
+   printf("Wrote %u benchmarks to %s (batch draws on %s)\n", 
+          static_cast<unsigned int>(results.size()), 
+          argv[1], 
+          CounterRng::getBatchInstructionSet());
+   return 0;
+}
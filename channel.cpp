@@ -0,0 +1,130 @@
+/*
+ * Implementation of the Channel class. A class used to track the state of a shared medium.
+ */
+
+#include <algorithm>    // std::max, std::min
+
+#include "channel.h"
+#include "metric.h"
+
+// Channel class constructor. The medium starts idle.
+Channel::Channel() {
+   theTransmitterCount = 0;
+   theBusyStartTime = 0;
+   theBusyEndTime = 0;
+   thePastBusySlots = 0;
+   theContenderCount = 0;
+   theStartedTransmitCount = 0;
+   theCompletedTransmitCount = 0;
+   theCollidedTransmitCount = 0;
+}
+
+// Records that a node started, at currentTime, a transmit that completes at timeOfCompletion. The medium is sensed 
+// busy from the next time slot until the completion frees it.
+void Channel::startTransmit(long currentTime, long timeOfCompletion) {
+   theTransmitterCount++;
+   theStartedTransmitCount++;
+   occupy(currentTime + 1, timeOfCompletion);
+}
+
+// Records that a node completed its transmit on the medium.
+void Channel::completeTransmit() {
+   theTransmitterCount--;
+   theCompletedTransmitCount++;
+}
+
+// Records that the contenders colliding at currentTime keep the medium busy until endTime, and clears them. Protocols 
+// that detect the collision in the time slot it happens in pass currentTime + 1, which leaves the medium idle.
+void Channel::startCollision(long currentTime, long endTime) {
+   theCollidedTransmitCount += theContenderCount;
+   theContenderCount = 0;
+   occupy(currentTime + 1, endTime);
+}
+
+// Returns the idle-slot clock at currentTime: the count of time slots [0, currentTime] with the medium idle.
+long Channel::countIdleSlots(long currentTime) {
+   long currentBusySlots = std::max(0L, std::min(currentTime + 1, theBusyEndTime) - theBusyStartTime);
+   return currentTime + 1 - thePastBusySlots - currentBusySlots;
+}
+
+// Returns the earliest time after currentTime at which the idle-slot clock reaches idleSlotCount, assuming the medium 
+// is idle after the busy period already known. idleSlotCount must be past the clock at currentTime.
+long Channel::predictIdleSlotTime(long idleSlotCount, long currentTime) {
+   long remainingSlots = idleSlotCount - countIdleSlots(currentTime);
+   
+   // The first idle time slot to come, past the latest busy period if it is still going on.
+   long nextIdleTime = std::max(currentTime + 1, theBusyStartTime <= currentTime + 1 ? theBusyEndTime : 0L);
+   return nextIdleTime + remainingSlots - 1;
+}
+
+// Marks the medium busy in the time slots [startTime, endTime). On a shared channel busy periods never overlap, as 
+// nothing starts on a busy medium; the medium a node hears under a topology can be occupied again before it is 
+// released (by a neighbour hidden from the first transmitter), so a period that overlaps or abuts the latest one 
+// extends it.
+void Channel::occupy(long startTime, long endTime) {
+   if (endTime <= startTime) {
+      return;
+   }
+   else if (startTime <= theBusyEndTime) {
+      theBusyEndTime = std::max(theBusyEndTime, endTime);
+      return;
+   }
+   
+   thePastBusySlots += theBusyEndTime - theBusyStartTime;
+   theBusyStartTime = startTime;
+   theBusyEndTime = endTime;
+}
+
+// Getter for theTransmitterCount.
+int Channel::getTransmitterCount() {
+   return theTransmitterCount;
+}
+
+// Getter for theStartedTransmitCount.
+uint64_t Channel::getStartedTransmitCount() {
+   return theStartedTransmitCount;
+}
+
+// Getter for theCompletedTransmitCount.
+uint64_t Channel::getCompletedTransmitCount() {
+   return theCompletedTransmitCount;
+}
+
+// Getter for theCollidedTransmitCount.
+uint64_t Channel::getCollidedTransmitCount() {
+   return theCollidedTransmitCount;
+}
+
+// Stores the counts of the medium over the timeSlotCount time slots of a replication in channelMetric, at the end of 
+// the replication.
+void Channel::collectMetric(Metric& channelMetric, long timeSlotCount) {
+   long idleSlotCount = countIdleSlots(timeSlotCount - 1);
+   channelMetric.setCountOfTransmissionAttempts(theStartedTransmitCount + theCollidedTransmitCount);
+   channelMetric.setCountOfCollisions(theCollidedTransmitCount);
+   channelMetric.setCountOfMessagesTransmitted(theCompletedTransmitCount);
+   channelMetric.setClockCyclesIdle(idleSlotCount);
+   channelMetric.setClockCyclesTransmitting(timeSlotCount - idleSlotCount);
+}
+
+// Appends the state of the medium to state, for a checkpoint. Checkpoints fall between time slots, when there are no 
+// contenders.
+void Channel::saveState(StateBuffer& state) {
+   state.appendValue(theTransmitterCount);
+   state.appendValue(theBusyStartTime);
+   state.appendValue(theBusyEndTime);
+   state.appendValue(thePastBusySlots);
+   state.appendValue(theStartedTransmitCount);
+   state.appendValue(theCompletedTransmitCount);
+   state.appendValue(theCollidedTransmitCount);
+}
+
+// Reads back the state saved by saveState(). Returns false if state is too short.
+bool Channel::restoreState(StateBuffer& state) {
+   return state.readValue(theTransmitterCount)
+       && state.readValue(theBusyStartTime)
+       && state.readValue(theBusyEndTime)
+       && state.readValue(thePastBusySlots)
+       && state.readValue(theStartedTransmitCount)
+       && state.readValue(theCompletedTransmitCount)
+       && state.readValue(theCollidedTransmitCount);
+}
@@ -0,0 +1,108 @@
+/*
+ * Declaration of the Channel class. A class used to track the state of a shared medium so that carrier sensing is 
+ * answered in constant time instead of by scanning every node. With CHANNEL_COUNT > 1 the store holds one per channel, 
+ * each with its own contention and collisions.
+ *
+ * Besides the transmitters, the channel keeps the latest period in which the medium is busy (a transmit, or a 
+ * collision for the protocols that do not abort one in its first slot) and the total of the earlier ones. This is 
+ * enough to answer the idle-slot clock, the count of time slots in which the medium was sensed idle, that CSMA/CA 
+ * back-offs count down on.
+ *
+ * The channel also counts the transmits started, completed and collided on it, for the per-channel report.
+ *
+ * With a TOPOLOGY, there is one Channel per node instead: the medium as that node hears it, occupied by the transmits 
+ * of the node and its neighbours only (see NodeStore::occupyMedium()).
+ */
+
+#ifndef __CHANNEL_H__
+#define __CHANNEL_H__
+
+#include <stdint.h>
+
+#include "statebuffer.h"
+
+// Forward declaration. Resolves circular dependency issues.
+class Metric;
+
+class Channel {
+   public:
+      // Overwrite the default constructor.
+      Channel();
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Records that a node started, at currentTime, a transmit that completes at timeOfCompletion.
+      void startTransmit(long currentTime, long timeOfCompletion);
+      
+      // Records that a node completed its transmit on the medium.
+      void completeTransmit();
+      
+      // Records that a node wants to transmit on the medium in the current time slot.
+      void addContender() { theContenderCount++; }
+      
+      // Returns the count of nodes that want to transmit on the medium in the current time slot.
+      int getContenderCount() { return theContenderCount; }
+      
+      // Clears the count of contenders, once the one contender has started its transmit.
+      void clearContenders() { theContenderCount = 0; }
+      
+      // Records that the contenders colliding at currentTime keep the medium busy until endTime, and clears them.
+      void startCollision(long currentTime, long endTime);
+      
+      // Returns true if the medium is sensed idle at currentTime. Defined inline as it is checked for every 
+      // contending node.
+      bool isIdle(long currentTime) { return 0 == theTransmitterCount && currentTime >= theBusyEndTime; }
+      
+      // Returns the idle-slot clock at currentTime: the count of time slots [0, currentTime] with the medium idle.
+      long countIdleSlots(long currentTime);
+      
+      // Returns the earliest time after currentTime at which the idle-slot clock reaches idleSlotCount, assuming the 
+      // medium is idle after the busy period already known.
+      long predictIdleSlotTime(long idleSlotCount, long currentTime);
+      
+      // Getter for theTransmitterCount.
+      int getTransmitterCount();
+      
+      // Getter for theStartedTransmitCount.
+      uint64_t getStartedTransmitCount();
+      
+      // Getter for theCompletedTransmitCount.
+      uint64_t getCompletedTransmitCount();
+      
+      // Getter for theCollidedTransmitCount.
+      uint64_t getCollidedTransmitCount();
+      
+      // Stores the counts of the medium (transmits started and collided, completed and collided, and the time slots it 
+      // was sensed idle and busy) over the timeSlotCount time slots of a replication in channelMetric.
+      void collectMetric(Metric& channelMetric, long timeSlotCount);
+      
+      // Appends the state of the medium to state, for a checkpoint.
+      void saveState(StateBuffer& state);
+      
+      // Reads back the state saved by saveState(). Returns false if state is too short.
+      bool restoreState(StateBuffer& state);
+   
+   private:
+      // Marks the medium busy in the time slots [startTime, endTime).
+      void occupy(long startTime, long endTime);
+      
+      // Count of nodes currently transmitting on the medium.
+      int theTransmitterCount;
+      
+      // Latest busy period of the medium, [theBusyStartTime, theBusyEndTime).
+      long theBusyStartTime;
+      long theBusyEndTime;
+      
+      // Count of time slots in the busy periods before the latest one.
+      long thePastBusySlots;
+      
+      // Count of nodes that want to transmit on the medium in the current time slot.
+      int theContenderCount;
+      
+      // Counts of the transmits started, completed and collided (one per colliding node) on the medium.
+      uint64_t theStartedTransmitCount;
+      uint64_t theCompletedTransmitCount;
+      uint64_t theCollidedTransmitCount;
+};
+
+#endif   // __CHANNEL_H__
@@ -0,0 +1,213 @@
+/*
+ * Implementation of the checkpoint classes. Used to save a run in flight and to resume it exactly.
+ */
+
+#include <cstdio>       // fopen, fwrite, rename, snprintf
+#include <fstream>
+#include <iterator>     // std::istreambuf_iterator
+#include <unistd.h>     // fsync
+
+#include "checkpoint.h"
+
+// Magic at the start of every checkpoint file. Version 2 credits a transmit's time slots to the metrics when it 
+// starts, so the metrics of a version 1 replication cannot be carried on.
+static const char CHECKPOINT_MAGIC[8] = { 'C', 'S', 'M', 'A', 'C', 'K', 'P', '2' };
+
+/**********************************************
+ * Checkpoint
+ *******************/
+
+// Checkpoint class constructor with args. Every key that changes the results (or the layout of the saved state) is 
+// part of the fingerprint; THREAD_COUNT, SHUFFLE_NODES and the logging and trace keys are free to change on resume.
+Checkpoint::Checkpoint(Configuration* configObj) {
+   char text[1024];
+   snprintf(text, sizeof(text), "SEED=%llu SIMULATION_COUNT=%u TIME_SLOT_COUNT=%lu PROTOCOL_TYPE=%d NODE_COUNT=%d "
+                                "PROB_FRAME_GENERATION=%.9g PROB_PERSISTENCE=%.9g FRAME_LENGTH=%d "
+                                "MAX_RETRANSMIT_ATTEMPTS=%d ENGINE=%d PACKED_NODE_STATES=%d MESSAGE_BUFFER_DEPTH=%d "
+                                "ARRIVAL_MODEL=%d RESULT_FORMAT=%d STOP_RELATIVE_HALF_WIDTH=%.9g STOP_CONFIDENCE=%.9g "
+                                "STOP_MIN_SIMULATIONS=%u CHANNEL_COUNT=%d CHANNEL_SELECTION=%d TOPOLOGY=%d "
+                                "TOPOLOGY_RANGE=%.9g COLLISION_MODEL=%d STOP_STATISTICS=",
+            static_cast<unsigned long long>(configObj->getSeed()),
+            configObj->getSimulationCount(),
+            configObj->getTimeSlotCount(),
+            configObj->getCsmaType(),
+            configObj->getNodeCount(),
+            configObj->getProbFrameGeneration(),
+            configObj->getProbOfPersistance(),
+            configObj->getFrameLength(),
+            configObj->getMaxBackoffRetransmitCount(),
+            configObj->getEngineType(),
+            configObj->getPackedNodeStatesEnabled(),
+            configObj->getMessageBufferDepth(),
+            configObj->getArrivalModel(),
+            configObj->getResultFormat(),
+            configObj->getStopRelativeHalfWidth(),
+            configObj->getStopConfidence(),
+            configObj->getStopMinSimulationCount(),
+            configObj->getChannelCount(),
+            configObj->getChannelSelection(),
+            configObj->getTopologyType(),
+            configObj->getTopologyRange(),
+            configObj->getCollisionModel());
+   theConfigFingerprint = text;
+   
+   std::vector<STOP_STATISTIC> statistics = configObj->getStopStatistics();
+   for (unsigned int statisticIndex = 0; statisticIndex < statistics.size(); statisticIndex++) {
+      snprintf(text, sizeof(text), "%d,", statistics[statisticIndex]);
+      theConfigFingerprint += text;
+   }
+   theConfigFingerprint += " TOPOLOGY_FILE=" + configObj->getTopologyFile();
+}
+
+// Getter for theRunState.
+StateBuffer& Checkpoint::getRunState() {
+   return theRunState;
+}
+
+// Getter for theReplicationStates.
+std::map<unsigned int, StateBuffer>& Checkpoint::getReplicationStates() {
+   return theReplicationStates;
+}
+
+// Returns the saved state of replication simIndex, or NULL if it was not in flight.
+StateBuffer* Checkpoint::findReplicationState(unsigned int simIndex) {
+   std::map<unsigned int, StateBuffer>::iterator it = theReplicationStates.find(simIndex);
+   return it == theReplicationStates.end() ? NULL : &it->second;
+}
+
+// Writes the checkpoint to fileName, atomically: the file is written under a temporary name, synced to the disk and 
+// renamed over fileName.
+bool Checkpoint::writeFile(std::string fileName) {
+   std::string temporaryFileName = fileName + ".tmp";
+   FILE* file = fopen(temporaryFileName.c_str(), "wb");
+   if (NULL == file) {
+      std::cout << "ERROR - failed to open checkpoint file: " << temporaryFileName << std::endl;
+      return false;
+   }
+   
+   // The header is small; the states are written straight from their buffers.
+   StateBuffer header;
+   header.appendBytes(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+   header.appendVector(std::vector<char>(theConfigFingerprint.begin(), theConfigFingerprint.end()));
+   header.appendValue<uint64_t>(theRunState.getBytes().size());
+   header.appendValue<uint64_t>(theReplicationStates.size());
+   bool isWritten = header.getBytes().size() == fwrite(header.getBytes().data(), 1, header.getBytes().size(), file)
+                 && theRunState.getBytes().size() == fwrite(theRunState.getBytes().data(),
+                                                            1,
+                                                            theRunState.getBytes().size(),
+                                                            file);
+   for (std::map<unsigned int, StateBuffer>::iterator it = theReplicationStates.begin();
+        isWritten && it != theReplicationStates.end();
+        it++) {
+      StateBuffer replicationHeader;
+      replicationHeader.appendValue<uint32_t>(it->first);
+      replicationHeader.appendValue<uint64_t>(it->second.getBytes().size());
+      isWritten = replicationHeader.getBytes().size() == fwrite(replicationHeader.getBytes().data(),
+                                                                1,
+                                                                replicationHeader.getBytes().size(),
+                                                                file)
+               && it->second.getBytes().size() == fwrite(it->second.getBytes().data(),
+                                                         1,
+                                                         it->second.getBytes().size(),
+                                                         file);
+   }
+   isWritten = isWritten && 0 == fflush(file) && 0 == fsync(fileno(file));
+   isWritten = (0 == fclose(file)) && isWritten;
+   
+   if (!isWritten || 0 != rename(temporaryFileName.c_str(), fileName.c_str())) {
+      std::cout << "ERROR - failed to write checkpoint file: " << fileName << std::endl;
+      remove(temporaryFileName.c_str());
+      return false;
+   }
+   return true;
+}
+
+// Reads the checkpoint from fileName. Returns false if it cannot be read, or was taken under a configuration that 
+// produces different results.
+bool Checkpoint::readFile(std::string fileName) {
+   std::ifstream fileStream(fileName.c_str(), std::ios::binary);
+   if (!fileStream) {
+      std::cout << "ERROR - failed to open checkpoint file: " << fileName << std::endl;
+      return false;
+   }
+   StateBuffer contents;
+   contents.getBytes().assign(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+   
+   char magic[sizeof(CHECKPOINT_MAGIC)];
+   std::vector<char> fingerprint;
+   uint64_t runStateSize = 0, replicationCount = 0;
+   if (!contents.readBytes(magic, sizeof(magic))
+    || 0 != memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic))
+    || !contents.readVector(fingerprint)
+    || !contents.readValue(runStateSize)
+    || !contents.readValue(replicationCount)) {
+      std::cout << "ERROR - invalid checkpoint file: " << fileName << std::endl;
+      return false;
+   }
+   if (std::string(fingerprint.begin(), fingerprint.end()) != theConfigFingerprint) {
+      std::cout << "ERROR - checkpoint file " << fileName << " was taken under a different configuration: "
+                << std::string(fingerprint.begin(), fingerprint.end()) << std::endl;
+      return false;
+   }
+   
+   bool isRead = contents.readBuffer(theRunState, runStateSize);
+   for (uint64_t replicationIndex = 0; isRead && replicationIndex < replicationCount; replicationIndex++) {
+      uint32_t simIndex = 0;
+      uint64_t replicationStateSize = 0;
+      isRead = contents.readValue(simIndex)
+            && contents.readValue(replicationStateSize)
+            && contents.readBuffer(theReplicationStates[simIndex], replicationStateSize);
+   }
+   if (!isRead) {
+      std::cout << "ERROR - truncated checkpoint file: " << fileName << std::endl;
+      return false;
+   }
+   return true;
+}
+
+/**********************************************
+ * Checkpointer
+ *******************/
+
+// Checkpointer class constructor with args.
+Checkpointer::Checkpointer(unsigned int workerCount) 
+   : theGeneration(0) {
+   theActiveWorkerCount = workerCount;
+   theWaitingWorkerCount = 0;
+   theReplicationStates = NULL;
+}
+
+// Hands over the saved state of replication simIndex for the requested checkpoint, and brings workerGeneration up to 
+// date.
+void Checkpointer::depositSnapshot(unsigned int& workerGeneration, unsigned int simIndex, 
+                                   StateBuffer& replicationState) {
+   std::lock_guard<std::mutex> lock(theMutex);
+   workerGeneration = theGeneration;
+   (*theReplicationStates)[simIndex].swap(replicationState);
+   theWaitingWorkerCount--;
+   theCondition.notify_all();
+}
+
+// Marks a worker (whose last deposit was for workerGeneration) as out of replications, so that it no longer holds up 
+// the checkpoints.
+void Checkpointer::retireWorker(unsigned int workerGeneration) {
+   std::lock_guard<std::mutex> lock(theMutex);
+   theActiveWorkerCount--;
+   if (NULL != theReplicationStates && workerGeneration != theGeneration) {
+      theWaitingWorkerCount--;
+   }
+   theCondition.notify_all();
+}
+
+// Requests a snapshot from every worker still running and waits for them, moving the states into 
+// replicationStates. A worker between replications answers at the first time slot of its next one.
+void Checkpointer::collectSnapshots(std::map<unsigned int, StateBuffer>& replicationStates) {
+   std::unique_lock<std::mutex> lock(theMutex);
+   theReplicationStates = &replicationStates;
+   theWaitingWorkerCount = theActiveWorkerCount;
+   theGeneration++;
+   while (0 != theWaitingWorkerCount) {
+      theCondition.wait(lock);
+   }
+   theReplicationStates = NULL;
+}
@@ -0,0 +1,117 @@
+/*
+ * Declaration of the checkpoint classes. With CHECKPOINT_FILE configured, a background thread periodically writes 
+ * out everything a run has in flight, so that a crashed or preempted run can be resumed (RESUME=true) and finish 
+ * exactly as it would have uninterrupted.
+ *
+ * Every random draw is a pure function of the seed, the replication and the draw's position (see rng.h), so there is 
+ * no generator state to save: a replication is captured by its NodeStore (node state, message buffers, metrics and 
+ * channel), its engine state and the time slot it reached. To take a checkpoint the writer thread raises a request 
+ * that each worker polls once per time slot; at the next slot boundary the worker serializes its replication into a 
+ * StateBuffer (a flat copy of the store's arrays) and carries on. Once every worker has answered, the reduced state 
+ * of the runner (totals, replications awaiting reduction, stopping rule, result file length) is serialized under 
+ * the result mutex, and the file is written without holding up the workers. It is written to a temporary file, 
+ * synced and renamed over CHECKPOINT_FILE, so a crash while writing leaves the previous checkpoint intact.
+ *
+ * Workers answer at different time slots, so a replication saved mid-way may have been reduced by the time the 
+ * runner state is taken, and one started after its worker answered is not saved at all. Neither matters on resume: 
+ * saved replications that were already reduced are ignored, and missing ones are rerun from their first time slot 
+ * with the same draws.
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "helpers.h"
+#include "statebuffer.h"
+
+// A checkpoint of a run: the reduced state of the runner and the state of each replication in flight, keyed by 
+// replication index. Tied to the configuration it was taken under.
+class Checkpoint {
+   public:
+      // Constructor with args.
+      Checkpoint(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Getter for theRunState.
+      StateBuffer& getRunState();
+      
+      // Getter for theReplicationStates.
+      std::map<unsigned int, StateBuffer>& getReplicationStates();
+      
+      // Returns the saved state of replication simIndex, or NULL if it was not in flight.
+      StateBuffer* findReplicationState(unsigned int simIndex);
+      
+      // Writes the checkpoint to fileName, atomically. Returns false (leaving any previous file) on failure.
+      bool writeFile(std::string fileName);
+      
+      // Reads the checkpoint from fileName. Returns false if it cannot be read, or was taken under a configuration 
+      // that produces different results.
+      bool readFile(std::string fileName);
+   
+   private:
+      // The configuration keys that change the results, in text.
+      std::string theConfigFingerprint;
+      
+      // Reduced state of the runner.
+      StateBuffer theRunState;
+      
+      // State of each replication in flight.
+      std::map<unsigned int, StateBuffer> theReplicationStates;
+};
+
+// Coordinates the workers, which save their replications when asked, with the thread taking the checkpoints.
+class Checkpointer {
+   public:
+      // Constructor with args.
+      Checkpointer(unsigned int workerCount);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Returns true if a snapshot of the worker's replication has been requested since the last one it deposited 
+      // (workerGeneration). Defined inline as it is polled in every time slot.
+      bool isSnapshotRequested(unsigned int workerGeneration) {
+         return theGeneration.load(std::memory_order_relaxed) != workerGeneration;
+      }
+      
+      // Hands over the saved state of replication simIndex for the requested checkpoint, and brings workerGeneration 
+      // up to date.
+      void depositSnapshot(unsigned int& workerGeneration, unsigned int simIndex, StateBuffer& replicationState);
+      
+      // Marks a worker (whose last deposit was for workerGeneration) as out of replications, so that it no longer 
+      // holds up the checkpoints.
+      void retireWorker(unsigned int workerGeneration);
+      
+      // Requests a snapshot from every worker still running and waits for them, moving the states into 
+      // replicationStates.
+      void collectSnapshots(std::map<unsigned int, StateBuffer>& replicationStates);
+   
+   private:
+      // Count of checkpoints requested.
+      std::atomic<unsigned int> theGeneration;
+      
+      // Guards the members below.
+      std::mutex theMutex;
+      
+      // Signalled when a worker answers a request or retires.
+      std::condition_variable theCondition;
+      
+      // Count of workers still running replications.
+      unsigned int theActiveWorkerCount;
+      
+      // Count of workers yet to answer the current request.
+      unsigned int theWaitingWorkerCount;
+      
+      // Receives the snapshots of the current request.
+      std::map<unsigned int, StateBuffer>* theReplicationStates;
+};
+
+#endif   // __CHECKPOINT_H__
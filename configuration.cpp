@@ -2,13 +2,43 @@
  * Implementation of the Configuration class. A class used to initialize the system's configuration.
  */
 
+#include <climits>   // ULONG_MAX
+#include <cmath>     // floor
+#include <cstdio>    // snprintf
+#include <ctime>
 #include <fstream>
+#include <sstream>
 #include <string.h>  // strtok
 
 #include "configuration.h"
+#include "rng.h"
 
 // Configuration class constructor with args.
 Configuration::Configuration(std::string configurationIni) {
+   // Defaults for the optional keys.
+   theThreadCount = 0;
+   theEngineType = SLOT_ENGINE;
+   thePackedNodeStatesEnabled = false;
+   theShuffleNodesEnabled = false;
+   theMessageBufferDepth = 10;
+   theSeed = time(NULL);
+   theArrivalModel = GEOMETRIC_ARRIVALS;
+   theCollisionModel = SLOT_COLLISIONS;
+   theResultFormat = TEXT_RESULTS;
+   theTraceFirstSlot = 0;
+   theTraceLastSlot = ULONG_MAX;
+   theStopRelativeHalfWidth = 0.05;
+   theStopConfidence = 0.95;
+   theStopMinSimulationCount = 5;
+   theCheckpointInterval = 600;
+   theResumeEnabled = false;
+   theChannelCount = 1;
+   theChannelSelection = STATIC_CHANNELS;
+   theTopologyType = FULL_TOPOLOGY;
+   theTopologyRange = 1.5;
+   theFrameGenerationThreshold = 0;
+   thePersistenceThreshold = 0;
+   
    // Open the file.
    std::ifstream fileStream(configurationIni.c_str());
    
@@ -50,10 +80,10 @@ bool Configuration::setVerboseEnabled(bool isEnabled) {
 }
 
 // Setter for theSimulationCount.
-bool Configuration::setSimulationCount(unsigned int count) {
-   // Validate the input.
-   if (count > 100) {
-      std::cout << "ERROR - invalid theSimulationCount value: " << count << "; Valid if [1, 100]" << std::endl;
+bool Configuration::setSimulationCount(unsigned long count) {
+   // Validate the input. The replication takes 28 bits of the random draws' counter.
+   if (count > (1UL << 28)) {
+      std::cout << "ERROR - invalid theSimulationCount value: " << count << "; Valid if [1, 268435456]" << std::endl;
       return false;
    }
    
@@ -63,9 +93,9 @@ bool Configuration::setSimulationCount(unsigned int count) {
 
 // Setter for theTimeSlotCount.
 bool Configuration::setTimeSlotCount(unsigned long count) {
-   // Validate the input.
-   if (count > 2500000) {
-      std::cout << "ERROR - invalid theTimeSlotCount value: " << count << "; Valid if [1, 2500000]" << std::endl;
+   // Validate the input. Bounded random draws take further counter blocks 2^48 time slots apart.
+   if (count > (1UL << 48)) {
+      std::cout << "ERROR - invalid theTimeSlotCount value: " << count << "; Valid if [1, 281474976710656]" << std::endl;
       return false;
    }
    
@@ -76,7 +106,8 @@ bool Configuration::setTimeSlotCount(unsigned long count) {
 // Setter for theSimType.
 bool Configuration::setCsmaType(CSMA_TYPE csmaType) {
    // Validate the input.
-   if (csmaType != NON_PERSISTENT && csmaType != ONE_PERSISTENT && csmaType != P_PERSISTENT) {
+   if (csmaType != NON_PERSISTENT && csmaType != ONE_PERSISTENT && csmaType != P_PERSISTENT 
+    && csmaType != CSMA_CD && csmaType != CSMA_CA) {
       std::cout << "ERROR - unrecognized PROTOCOL_TYPE: " << csmaType << std::endl;
       return false;
    }
@@ -94,14 +125,15 @@ bool Configuration::setProbOfPersistance(float probability) {
    }
    
    theProbabilityOfPersistance = probability;
+   thePersistenceThreshold = CounterRng::computeBernoulliThreshold(probability);
    return true;
 }
 
 // Setter for theNodeCount.
 bool Configuration::setNodeCount(int count) {
    // Validate the input.
-   if (0 > count || count > 100) {
-      std::cout << "ERROR - invalid theNodeCount value: " << count << "; Valid if [0, 100]" << std::endl;
+   if (1 > count || count > (1 << 24)) {
+      std::cout << "ERROR - invalid theNodeCount value: " << count << "; Valid if [1, 16777216]" << std::endl;
       return false;
    }
    
@@ -118,6 +150,7 @@ bool Configuration::setProbFrameGeneration(float probability) {
    }
    
    theProbFrameGeneration = probability;
+   theFrameGenerationThreshold = CounterRng::computeBernoulliThreshold(probability);
    return true;
 }
 
@@ -145,6 +178,320 @@ bool Configuration::setMaxBackoffRetransmitCount(int count) {
    return true;
 }
 
+// Setter for theThreadCount.
+bool Configuration::setThreadCount(unsigned int count) {
+   // Validate the input.
+   if (count > 1024) {
+      std::cout << "ERROR - invalid theThreadCount value: " << count << "; Valid if [0, 1024]" << std::endl;
+      return false;
+   }
+   
+   theThreadCount = count;
+   return true;
+}
+
+// Setter for theEngineType.
+bool Configuration::setEngineType(ENGINE_TYPE engineType) {
+   // Validate the input.
+   if (engineType != SLOT_ENGINE && engineType != EVENT_ENGINE && engineType != LANE_ENGINE) {
+      std::cout << "ERROR - unrecognized ENGINE: " << engineType << std::endl;
+      return false;
+   }
+   
+   theEngineType = engineType;
+   return true;
+}
+
+// Setter for thePackedNodeStatesEnabled.
+bool Configuration::setPackedNodeStatesEnabled(bool isEnabled) {
+   thePackedNodeStatesEnabled = isEnabled;
+   return true;
+}
+
+// Setter for theShuffleNodesEnabled.
+bool Configuration::setShuffleNodesEnabled(bool isEnabled) {
+   theShuffleNodesEnabled = isEnabled;
+   return true;
+}
+
+// Setter for theMessageBufferDepth.
+bool Configuration::setMessageBufferDepth(int depth) {
+   // Validate the input.
+   if (1 > depth || depth > 65536) {
+      std::cout << "ERROR - invalid theMessageBufferDepth value: " << depth << "; Valid if [1, 65536]" << std::endl;
+      return false;
+   }
+   
+   theMessageBufferDepth = depth;
+   return true;
+}
+
+// Setter for theSeed.
+bool Configuration::setSeed(uint64_t seed) {
+   theSeed = seed;
+   return true;
+}
+
+// Setter for theArrivalModel.
+bool Configuration::setArrivalModel(ARRIVAL_MODEL arrivalModel) {
+   // Validate the input.
+   if (arrivalModel != GEOMETRIC_ARRIVALS && arrivalModel != BERNOULLI_ARRIVALS) {
+      std::cout << "ERROR - unrecognized ARRIVAL_MODEL: " << arrivalModel << std::endl;
+      return false;
+   }
+   
+   theArrivalModel = arrivalModel;
+   return true;
+}
+
+// Setter for theCollisionModel.
+bool Configuration::setCollisionModel(COLLISION_MODEL collisionModel) {
+   // Validate the input.
+   if (collisionModel != SLOT_COLLISIONS && collisionModel != FRAME_COLLISIONS) {
+      std::cout << "ERROR - unrecognized COLLISION_MODEL: " << collisionModel << std::endl;
+      return false;
+   }
+   
+   theCollisionModel = collisionModel;
+   return true;
+}
+
+// Setter for theResultFormat.
+bool Configuration::setResultFormat(RESULT_FORMAT resultFormat) {
+   // Validate the input.
+   if (resultFormat != TEXT_RESULTS && resultFormat != CSV_RESULTS 
+    && resultFormat != JSONL_RESULTS && resultFormat != BINARY_RESULTS) {
+      std::cout << "ERROR - unrecognized RESULT_FORMAT: " << resultFormat << std::endl;
+      return false;
+   }
+   
+   theResultFormat = resultFormat;
+   return true;
+}
+
+// Setter for theResultFile.
+bool Configuration::setResultFile(std::string resultFile) {
+   // Validate the input.
+   if (resultFile.empty()) {
+      std::cout << "ERROR - invalid theResultFile value: empty" << std::endl;
+      return false;
+   }
+   
+   theResultFile = resultFile;
+   return true;
+}
+
+// Setter for theTraceFile.
+bool Configuration::setTraceFile(std::string traceFile) {
+   // Validate the input.
+   if (traceFile.empty()) {
+      std::cout << "ERROR - invalid theTraceFile value: empty" << std::endl;
+      return false;
+   }
+   
+   theTraceFile = traceFile;
+   return true;
+}
+
+// Setter for theTraceNodes.
+bool Configuration::setTraceNodes(std::vector<int> nodes) {
+   // Validate the input.
+   for (std::vector<int>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      if (*it < 0) {
+         std::cout << "ERROR - invalid theTraceNodes value: " << *it << "; Valid if >= 0" << std::endl;
+         return false;
+      }
+   }
+   
+   theTraceNodes = nodes;
+   return true;
+}
+
+// Setter for theTraceFirstSlot and theTraceLastSlot.
+bool Configuration::setTraceSlots(unsigned long firstSlot, unsigned long lastSlot) {
+   // Validate the input.
+   if (firstSlot > lastSlot) {
+      std::cout << "ERROR - invalid TRACE_SLOTS value: " << firstSlot << ":" << lastSlot 
+                << "; Valid if start <= stop" << std::endl;
+      return false;
+   }
+   
+   theTraceFirstSlot = firstSlot;
+   theTraceLastSlot = lastSlot;
+   return true;
+}
+
+// Setter for theStopStatistics.
+bool Configuration::setStopStatistics(std::vector<STOP_STATISTIC> statistics) {
+   // Validate the input.
+   for (std::vector<STOP_STATISTIC>::iterator it = statistics.begin(); it != statistics.end(); ++it) {
+      if (*it < OFFERED_LOAD_STATISTIC || *it > DROP_RATIO_STATISTIC) {
+         std::cout << "ERROR - unrecognized STOP_STATISTICS value: " << *it << std::endl;
+         return false;
+      }
+   }
+   
+   theStopStatistics = statistics;
+   return true;
+}
+
+// Setter for theStopRelativeHalfWidth.
+bool Configuration::setStopRelativeHalfWidth(double halfWidth) {
+   // Validate the input.
+   if (0 >= halfWidth) {
+      std::cout << "ERROR - invalid theStopRelativeHalfWidth value: " << halfWidth << "; Valid if > 0" << std::endl;
+      return false;
+   }
+   
+   theStopRelativeHalfWidth = halfWidth;
+   return true;
+}
+
+// Setter for theStopConfidence.
+bool Configuration::setStopConfidence(double confidence) {
+   // Validate the input.
+   if (0 >= confidence || confidence >= 1.0) {
+      std::cout << "ERROR - invalid theStopConfidence value: " << confidence << "; Valid if (0, 1)" << std::endl;
+      return false;
+   }
+   
+   theStopConfidence = confidence;
+   return true;
+}
+
+// Setter for theStopMinSimulationCount.
+bool Configuration::setStopMinSimulationCount(unsigned int count) {
+   // Validate the input. A variance needs at least two replications.
+   if (2 > count) {
+      std::cout << "ERROR - invalid theStopMinSimulationCount value: " << count << "; Valid if >= 2" << std::endl;
+      return false;
+   }
+   
+   theStopMinSimulationCount = count;
+   return true;
+}
+
+// Setter for theCheckpointFile.
+bool Configuration::setCheckpointFile(std::string checkpointFile) {
+   // Validate the input.
+   if (checkpointFile.empty()) {
+      std::cout << "ERROR - invalid theCheckpointFile value: empty" << std::endl;
+      return false;
+   }
+   
+   theCheckpointFile = checkpointFile;
+   return true;
+}
+
+// Setter for theCheckpointInterval.
+bool Configuration::setCheckpointInterval(unsigned int seconds) {
+   // Validate the input.
+   if (0 == seconds) {
+      std::cout << "ERROR - invalid theCheckpointInterval value: " << seconds << "; Valid if > 0" << std::endl;
+      return false;
+   }
+   
+   theCheckpointInterval = seconds;
+   return true;
+}
+
+// Setter for theResumeEnabled.
+bool Configuration::setResumeEnabled(bool isEnabled) {
+   theResumeEnabled = isEnabled;
+   return true;
+}
+
+// Setter for theChannelCount.
+bool Configuration::setChannelCount(int count) {
+   // Validate the input.
+   if (count < 1 || count > 65535) {
+      std::cout << "ERROR - invalid theChannelCount value: " << count << "; Valid if [1, 65535]" << std::endl;
+      return false;
+   }
+   
+   theChannelCount = count;
+   return true;
+}
+
+// Setter for theChannelSelection.
+bool Configuration::setChannelSelection(CHANNEL_SELECTION selection) {
+   // Validate the input.
+   if (selection != STATIC_CHANNELS && selection != RANDOM_CHANNELS) {
+      std::cout << "ERROR - unrecognized CHANNEL_SELECTION: " << selection << std::endl;
+      return false;
+   }
+   
+   theChannelSelection = selection;
+   return true;
+}
+
+// Setter for theTopologyType.
+bool Configuration::setTopologyType(TOPOLOGY_TYPE topologyType) {
+   // Validate the input.
+   if (topologyType != FULL_TOPOLOGY && topologyType != GRID_TOPOLOGY 
+    && topologyType != GEOMETRIC_TOPOLOGY && topologyType != FILE_TOPOLOGY) {
+      std::cout << "ERROR - unrecognized TOPOLOGY: " << topologyType << std::endl;
+      return false;
+   }
+   
+   theTopologyType = topologyType;
+   return true;
+}
+
+// Setter for theTopologyRange.
+bool Configuration::setTopologyRange(double range) {
+   // Validate the input.
+   if (!(range > 0)) {
+      std::cout << "ERROR - invalid theTopologyRange value: " << range << "; Valid if > 0" << std::endl;
+      return false;
+   }
+   
+   theTopologyRange = range;
+   return true;
+}
+
+// Setter for theTopologyFile.
+bool Configuration::setTopologyFile(std::string topologyFile) {
+   // Validate the input.
+   if (topologyFile.empty()) {
+      std::cout << "ERROR - invalid theTopologyFile value: empty" << std::endl;
+      return false;
+   }
+   
+   theTopologyFile = topologyFile;
+   return true;
+}
+
+// Builds theTopology for the node count, from the TOPOLOGY keys. Nothing is built for TOPOLOGY=full. Returns false if 
+// the topology cannot be built or is combined with several channels.
+bool Configuration::buildTopology() {
+   if (FULL_TOPOLOGY == theTopologyType) {
+      return true;
+   }
+   else if (theChannelCount > 1) {
+      std::cout << "ERROR - TOPOLOGY is not supported with CHANNEL_COUNT > 1" << std::endl;
+      return false;
+   }
+   
+   switch (theTopologyType) {
+      case GRID_TOPOLOGY:
+         theTopology.buildGrid(theNodeCount, theTopologyRange);
+         break;
+      case GEOMETRIC_TOPOLOGY:
+         theTopology.buildGeometric(theNodeCount, theTopologyRange, theSeed);
+         break;
+      case FILE_TOPOLOGY:
+         if (theTopologyFile.empty()) {
+            std::cout << "ERROR - TOPOLOGY=file requires a TOPOLOGY_FILE" << std::endl;
+            return false;
+         }
+         return theTopology.loadFile(theTopologyFile, theNodeCount);
+      case FULL_TOPOLOGY:
+         break;
+   }
+   return true;
+}
+
 // Getter for theVerboseEnabled.
 bool Configuration::getVerboseEnabled() {
    return theVerboseEnabled;
@@ -190,14 +537,359 @@ int Configuration::getMaxBackoffRetransmitCount() {
    return theMaxBackoffRetransmitCount;
 }
 
+// Getter for theThreadCount.
+unsigned int Configuration::getThreadCount() {
+   return theThreadCount;
+}
+
+// Getter for theEngineType.
+ENGINE_TYPE Configuration::getEngineType() {
+   return theEngineType;
+}
+
+// Getter for thePackedNodeStatesEnabled.
+bool Configuration::getPackedNodeStatesEnabled() {
+   return thePackedNodeStatesEnabled;
+}
+
+// Getter for theShuffleNodesEnabled.
+bool Configuration::getShuffleNodesEnabled() {
+   return theShuffleNodesEnabled;
+}
+
+// Getter for theMessageBufferDepth.
+int Configuration::getMessageBufferDepth() {
+   return theMessageBufferDepth;
+}
+
+// Getter for theSeed.
+uint64_t Configuration::getSeed() {
+   return theSeed;
+}
+
+// Getter for theArrivalModel.
+ARRIVAL_MODEL Configuration::getArrivalModel() {
+   return theArrivalModel;
+}
+
+// Getter for theCollisionModel.
+COLLISION_MODEL Configuration::getCollisionModel() {
+   return theCollisionModel;
+}
+
+// Getter for theResultFormat.
+RESULT_FORMAT Configuration::getResultFormat() {
+   return theResultFormat;
+}
+
+// Getter for theResultFile. Defaults to csma_results with the extension of the format.
+std::string Configuration::getResultFile() {
+   if (!theResultFile.empty()) {
+      return theResultFile;
+   }
+   else if (CSV_RESULTS == theResultFormat) {
+      return "csma_results.csv";
+   }
+   else if (JSONL_RESULTS == theResultFormat) {
+      return "csma_results.jsonl";
+   }
+   return "csma_results.bin";
+}
+
+// Getter for theTraceFile.
+std::string Configuration::getTraceFile() {
+   return theTraceFile;
+}
+
+// Getter for theTraceNodes.
+std::vector<int> Configuration::getTraceNodes() {
+   return theTraceNodes;
+}
+
+// Getter for theTraceFirstSlot.
+unsigned long Configuration::getTraceFirstSlot() {
+   return theTraceFirstSlot;
+}
+
+// Getter for theTraceLastSlot.
+unsigned long Configuration::getTraceLastSlot() {
+   return theTraceLastSlot;
+}
+
+// Getter for theStopStatistics.
+std::vector<STOP_STATISTIC> Configuration::getStopStatistics() {
+   return theStopStatistics;
+}
+
+// Getter for theStopRelativeHalfWidth.
+double Configuration::getStopRelativeHalfWidth() {
+   return theStopRelativeHalfWidth;
+}
+
+// Getter for theStopConfidence.
+double Configuration::getStopConfidence() {
+   return theStopConfidence;
+}
+
+// Getter for theStopMinSimulationCount.
+unsigned int Configuration::getStopMinSimulationCount() {
+   return theStopMinSimulationCount;
+}
+
+// Returns true if STOP_STATISTICS was configured, making SIMULATION_COUNT a cap rather than a count.
+bool Configuration::isStoppingEnabled() {
+   return !theStopStatistics.empty();
+}
+
+// Getter for theCheckpointFile.
+std::string Configuration::getCheckpointFile() {
+   return theCheckpointFile;
+}
+
+// Getter for theCheckpointInterval.
+unsigned int Configuration::getCheckpointInterval() {
+   return theCheckpointInterval;
+}
+
+// Getter for theResumeEnabled.
+bool Configuration::getResumeEnabled() {
+   return theResumeEnabled;
+}
+
+// Getter for theChannelCount.
+int Configuration::getChannelCount() {
+   return theChannelCount;
+}
+
+// Getter for theChannelSelection.
+CHANNEL_SELECTION Configuration::getChannelSelection() {
+   return theChannelSelection;
+}
+
+// Getter for theTopologyType.
+TOPOLOGY_TYPE Configuration::getTopologyType() {
+   return theTopologyType;
+}
+
+// Getter for theTopologyRange.
+double Configuration::getTopologyRange() {
+   return theTopologyRange;
+}
+
+// Getter for theTopologyFile.
+std::string Configuration::getTopologyFile() {
+   return theTopologyFile;
+}
+
+// Returns true if TOPOLOGY is other than full.
+bool Configuration::isTopologyEnabled() {
+   return FULL_TOPOLOGY != theTopologyType;
+}
+
+// Getter for theTopology.
+Topology& Configuration::getTopology() {
+   return theTopology;
+}
+
+// Returns true if CHECKPOINT_FILE was configured.
+bool Configuration::isCheckpointEnabled() {
+   return !theCheckpointFile.empty();
+}
+
+// Getter for theFrameGenerationThreshold.
+uint64_t Configuration::getFrameGenerationThreshold() {
+   return theFrameGenerationThreshold;
+}
+
+// Getter for thePersistenceThreshold.
+uint64_t Configuration::getPersistenceThreshold() {
+   return thePersistenceThreshold;
+}
+
+// Returns true if the INI declared at least one SWEEP_ key.
+bool Configuration::isSweepEnabled() {
+   return !theSweepDimensions.empty();
+}
+
+// Fills points with one copy of this configuration per combination of the swept values, the first swept key varying 
+// slowest. Every value goes through updateConfig(), so it is validated exactly as if it had been written in the INI. 
+// The points share this configuration's topology, unless they sweep the node count.
+bool Configuration::expandSweep(std::vector<Configuration>& points) {
+   points.clear();
+   points.push_back(*this);
+   for (unsigned int dimension = 0; dimension < theSweepDimensions.size(); dimension++) {
+      const std::string& key = theSweepDimensions[dimension].first;
+      const std::vector<std::string>& values = theSweepDimensions[dimension].second;
+      
+      std::vector<Configuration> expandedPoints;
+      expandedPoints.reserve(points.size() * values.size());
+      for (unsigned int pointIndex = 0; pointIndex < points.size(); pointIndex++) {
+         for (unsigned int valueIndex = 0; valueIndex < values.size(); valueIndex++) {
+            expandedPoints.push_back(points[pointIndex]);
+            if (!expandedPoints.back().updateConfig(key, values[valueIndex])) {
+               std::cout << "ERROR - invalid SWEEP_" << key << " value: " << values[valueIndex] << std::endl;
+               return false;
+            }
+         }
+      }
+      points.swap(expandedPoints);
+   }
+   
+   // A point with its own node count needs its own topology.
+   for (unsigned int pointIndex = 0; pointIndex < points.size(); pointIndex++) {
+      Configuration& point = points[pointIndex];
+      if (point.isTopologyEnabled() && point.getTopology().getNodeCount() != point.getNodeCount() 
+       && !point.buildTopology()) {
+         return false;
+      }
+   }
+   return true;
+}
+
 /**********************************************
  * Helper functions
  *******************/
 
+// Helper function that records the values of a SWEEP_ key, given as a list a,b,c (optionally in parentheses) or a 
+// range (start:stop:step, inclusive of stop).
+bool Configuration::addSweepDimension(std::string key, std::string value) {
+   // Validate the key.
+   if ("PROB_FRAME_GENERATION" != key && "NODE_COUNT" != key && "PROTOCOL_TYPE" != key 
+    && "PROB_PERSISTENCE" != key && "FRAME_LENGTH" != key && "MAX_RETRANSMIT_ATTEMPTS" != key) {
+      std::cout << "ERROR - unrecognized sweep key: SWEEP_" << key << std::endl;
+      return false;
+   }
+   
+   std::vector<std::string> values;
+   if (std::string::npos != value.find(':')) {
+      // Translate string as a numeric range.
+      double start = 0, stop = 0, step = 0;
+      if (3 != sscanf(value.c_str(), "%lf:%lf:%lf", &start, &stop, &step) || step <= 0 || stop < start) {
+         std::cout << "ERROR - invalid SWEEP_" << key << " range: " << value << "; expected start:stop:step" << std::endl;
+         return false;
+      }
+      
+      // The small tolerance keeps stop in the range despite rounding in the step.
+      unsigned long count = static_cast<unsigned long>(std::floor((stop - start) / step + 1e-9)) + 1;
+      for (unsigned long index = 0; index < count; index++) {
+         char buffer[32];
+         snprintf(buffer, sizeof(buffer), "%.10g", start + index * step);
+         values.push_back(buffer);
+      }
+   }
+   else {
+      // Translate string as a comma-separated list, without its parentheses.
+      bool isOpened = !value.empty() && '(' == value[0];
+      bool isClosed = !value.empty() && ')' == value[value.size() - 1];
+      if (isOpened != isClosed || (isOpened && value.size() < 2)) {
+         std::cout << "ERROR - invalid SWEEP_" << key << " list: " << value << "; expected a,b,c or (a,b,c)" 
+                   << std::endl;
+         return false;
+      }
+      if (isOpened) {
+         value = value.substr(1, value.size() - 2);
+      }
+      std::stringstream valueStream(value);
+      std::string item;
+      while (std::getline(valueStream, item, ',')) {
+         if (!item.empty()) {
+            values.push_back(item);
+         }
+      }
+   }
+   
+   if (values.empty()) {
+      std::cout << "ERROR - no values for SWEEP_" << key << std::endl;
+      return false;
+   }
+   
+   theSweepDimensions.push_back(std::make_pair(key, values));
+   return true;
+}
+
+// Helper function that parses the TRACE_NODES list (a,b,c with a-b ranges).
+bool Configuration::parseTraceNodes(std::string value) {
+   std::vector<int> nodes;
+   std::stringstream valueStream(value);
+   std::string item;
+   while (std::getline(valueStream, item, ',')) {
+      if (item.empty()) {
+         continue;
+      }
+
+      int first = 0, last = 0;
+      char trailing = 0;
+      if (2 == sscanf(item.c_str(), "%d-%d%c", &first, &last, &trailing)) {
+         // Translate string as an inclusive range of nodes.
+         if (last < first) {
+            std::cout << "ERROR - invalid TRACE_NODES range: " << item << "; expected first-last" << std::endl;
+            return false;
+         }
+         for (int node = first; node <= last; node++) {
+            nodes.push_back(node);
+         }
+      }
+      else if (1 == sscanf(item.c_str(), "%d%c", &first, &trailing)) {
+         nodes.push_back(first);
+      }
+      else {
+         std::cout << "ERROR - invalid TRACE_NODES value: " << item << std::endl;
+         return false;
+      }
+   }
+
+   return setTraceNodes(nodes);
+}
+
+// Helper function that parses the TRACE_SLOTS window (start:stop, either side may be empty).
+bool Configuration::parseTraceSlots(std::string value) {
+   size_t separator = value.find(':');
+   if (std::string::npos == separator) {
+      std::cout << "ERROR - invalid TRACE_SLOTS value: " << value << "; expected start:stop" << std::endl;
+      return false;
+   }
+
+   std::string first = value.substr(0, separator);
+   std::string last = value.substr(separator + 1);
+   return setTraceSlots(first.empty() ? 0 : strtoul(first.c_str(), NULL, 10),
+                        last.empty() ? ULONG_MAX : strtoul(last.c_str(), NULL, 10));
+}
+
+// Helper function that parses the STOP_STATISTICS list (names of the sweep row columns).
+bool Configuration::parseStopStatistics(std::string value) {
+   std::vector<STOP_STATISTIC> statistics;
+   std::stringstream valueStream(value);
+   std::string item;
+   while (std::getline(valueStream, item, ',')) {
+      // Translate string as enum.
+      if ("offered_load" == item) {
+         statistics.push_back(OFFERED_LOAD_STATISTIC);
+      }
+      else if ("throughput" == item) {
+         statistics.push_back(THROUGHPUT_STATISTIC);
+      }
+      else if ("mean_delay" == item) {
+         statistics.push_back(MEAN_DELAY_STATISTIC);
+      }
+      else if ("collisions_per_attempt" == item) {
+         statistics.push_back(COLLISION_RATIO_STATISTIC);
+      }
+      else if ("drop_ratio" == item) {
+         statistics.push_back(DROP_RATIO_STATISTIC);
+      }
+      else if (!item.empty()) {
+         std::cout << "ERROR - unrecognized STOP_STATISTICS value: " << item << std::endl;
+         return false;
+      }
+   }
+   
+   return setStopStatistics(statistics);
+}
+
 // Helper function that checks if a line is blank, comment or category.
 bool Configuration::checkLineForConfigurationString(std::string line) {
    // Get the first character of the string.
-   int index = line.find_first_not_of(" \t");
+   std::string::size_type index = line.find_first_not_of(" \t");
    
    // Check if the line is empty.
    if (std::string::npos == index) {
@@ -229,7 +921,10 @@ void Configuration::getConfigKeyAndValue(char* line, std::string& key, std::stri
 
 // Helper function that sets the member variables based on a key/value from the INI file.
 bool Configuration::updateConfig(std::string key, std::string value) {
-   if ("VERBOSE_LOGGING" == key) {
+   if (0 == key.compare(0, 6, "SWEEP_")) {
+      return addSweepDimension(key.substr(6), value);
+   }
+   else if ("VERBOSE_LOGGING" == key) {
       // Translate string as bool.
       if ("true" == value) {
          return setVerboseEnabled(true);
@@ -258,6 +953,12 @@ bool Configuration::updateConfig(std::string key, std::string value) {
       else if ("p-Persistent" == value) {
          return setCsmaType(P_PERSISTENT);
       }
+      else if ("CSMA/CD" == value) {
+         return setCsmaType(CSMA_CD);
+      }
+      else if ("CSMA/CA" == value) {
+         return setCsmaType(CSMA_CA);
+      }
 
       std::cout << "ERROR - unrecognized PROTOCOL_TYPE value: " << value << std::endl;
       return false;
@@ -277,6 +978,177 @@ bool Configuration::updateConfig(std::string key, std::string value) {
    else if ("MAX_RETRANSMIT_ATTEMPTS" == key) {
       return setMaxBackoffRetransmitCount(atoi(value.c_str()));
    }
+   else if ("THREAD_COUNT" == key) {
+      return setThreadCount(strtoul(value.c_str(), NULL, 0));
+   }
+   else if ("ENGINE" == key) {
+      // Translate string as enum.
+      if ("slot" == value) {
+         return setEngineType(SLOT_ENGINE);
+      }
+      else if ("event" == value) {
+         return setEngineType(EVENT_ENGINE);
+      }
+      else if ("lanes" == value) {
+         return setEngineType(LANE_ENGINE);
+      }
+      
+      std::cout << "ERROR - unrecognized ENGINE value: " << value << std::endl;
+      return false;
+   }
+   else if ("PACKED_NODE_STATES" == key) {
+      // Translate string as bool.
+      if ("true" == value) {
+         return setPackedNodeStatesEnabled(true);
+      }
+      else if ("false" == value) {
+         return setPackedNodeStatesEnabled(false);
+      }
+      
+      std::cout << "ERROR - unrecognized PACKED_NODE_STATES value: " << value << std::endl;
+      return false;
+   }
+   else if ("SHUFFLE_NODES" == key) {
+      // Translate string as bool.
+      if ("true" == value) {
+         return setShuffleNodesEnabled(true);
+      }
+      else if ("false" == value) {
+         return setShuffleNodesEnabled(false);
+      }
+      
+      std::cout << "ERROR - unrecognized SHUFFLE_NODES value: " << value << std::endl;
+      return false;
+   }
+   else if ("MESSAGE_BUFFER_DEPTH" == key) {
+      return setMessageBufferDepth(atoi(value.c_str()));
+   }
+   else if ("SEED" == key) {
+      return setSeed(strtoull(value.c_str(), NULL, 0));
+   }
+   else if ("ARRIVAL_MODEL" == key) {
+      // Translate string as enum.
+      if ("geometric" == value) {
+         return setArrivalModel(GEOMETRIC_ARRIVALS);
+      }
+      else if ("bernoulli" == value) {
+         return setArrivalModel(BERNOULLI_ARRIVALS);
+      }
+      
+      std::cout << "ERROR - unrecognized ARRIVAL_MODEL value: " << value << std::endl;
+      return false;
+   }
+   else if ("COLLISION_MODEL" == key) {
+      // Translate string as enum.
+      if ("slot" == value) {
+         return setCollisionModel(SLOT_COLLISIONS);
+      }
+      else if ("frame" == value) {
+         return setCollisionModel(FRAME_COLLISIONS);
+      }
+      
+      std::cout << "ERROR - unrecognized COLLISION_MODEL value: " << value << std::endl;
+      return false;
+   }
+   else if ("RESULT_FORMAT" == key) {
+      // Translate string as enum.
+      if ("text" == value) {
+         return setResultFormat(TEXT_RESULTS);
+      }
+      else if ("csv" == value) {
+         return setResultFormat(CSV_RESULTS);
+      }
+      else if ("jsonl" == value) {
+         return setResultFormat(JSONL_RESULTS);
+      }
+      else if ("binary" == value) {
+         return setResultFormat(BINARY_RESULTS);
+      }
+      
+      std::cout << "ERROR - unrecognized RESULT_FORMAT value: " << value << std::endl;
+      return false;
+   }
+   else if ("RESULT_FILE" == key) {
+      return setResultFile(value);
+   }
+   else if ("TRACE_FILE" == key) {
+      return setTraceFile(value);
+   }
+   else if ("TRACE_NODES" == key) {
+      return parseTraceNodes(value);
+   }
+   else if ("TRACE_SLOTS" == key) {
+      return parseTraceSlots(value);
+   }
+   else if ("STOP_STATISTICS" == key) {
+      return parseStopStatistics(value);
+   }
+   else if ("STOP_RELATIVE_HALF_WIDTH" == key) {
+      return setStopRelativeHalfWidth(atof(value.c_str()));
+   }
+   else if ("STOP_CONFIDENCE" == key) {
+      return setStopConfidence(atof(value.c_str()));
+   }
+   else if ("STOP_MIN_SIMULATIONS" == key) {
+      return setStopMinSimulationCount(strtoul(value.c_str(), NULL, 0));
+   }
+   else if ("CHECKPOINT_FILE" == key) {
+      return setCheckpointFile(value);
+   }
+   else if ("CHECKPOINT_INTERVAL" == key) {
+      return setCheckpointInterval(strtoul(value.c_str(), NULL, 0));
+   }
+   else if ("RESUME" == key) {
+      // Translate string as bool.
+      if ("true" == value) {
+         return setResumeEnabled(true);
+      }
+      else if ("false" == value) {
+         return setResumeEnabled(false);
+      }
+      
+      std::cout << "ERROR - unrecognized RESUME value: " << value << std::endl;
+      return false;
+   }
+   else if ("CHANNEL_COUNT" == key) {
+      return setChannelCount(atoi(value.c_str()));
+   }
+   else if ("CHANNEL_SELECTION" == key) {
+      // Translate string as enum.
+      if ("static" == value) {
+         return setChannelSelection(STATIC_CHANNELS);
+      }
+      else if ("random" == value) {
+         return setChannelSelection(RANDOM_CHANNELS);
+      }
+      
+      std::cout << "ERROR - unrecognized CHANNEL_SELECTION value: " << value << std::endl;
+      return false;
+   }
+   else if ("TOPOLOGY" == key) {
+      // Translate string as enum.
+      if ("full" == value) {
+         return setTopologyType(FULL_TOPOLOGY);
+      }
+      else if ("grid" == value) {
+         return setTopologyType(GRID_TOPOLOGY);
+      }
+      else if ("geometric" == value) {
+         return setTopologyType(GEOMETRIC_TOPOLOGY);
+      }
+      else if ("file" == value) {
+         return setTopologyType(FILE_TOPOLOGY);
+      }
+      
+      std::cout << "ERROR - unrecognized TOPOLOGY value: " << value << std::endl;
+      return false;
+   }
+   else if ("TOPOLOGY_RANGE" == key) {
+      return setTopologyRange(atof(value.c_str()));
+   }
+   else if ("TOPOLOGY_FILE" == key) {
+      return setTopologyFile(value);
+   }
    
    // Unexpected key, error.
    std::cout << "ERROR - unrecognized key: " << key << std::endl;
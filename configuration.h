@@ -5,21 +5,79 @@
 #ifndef __CONFIGURATION_H__
 #define __CONFIGURATION_H__
 
+#include <stdint.h>
+#include <string>
+#include <utility>   // std::pair
+#include <vector>
+
 #include "helpers.h"
+#include "topology.h"
 
 // Enum representing the protocol type.
 typedef enum CSMA_TYPE {
    NON_PERSISTENT = 0,
    ONE_PERSISTENT,
-   P_PERSISTENT
+   P_PERSISTENT,
+   CSMA_CD,          // 1-persistent with collision detection (a collision is aborted after a one slot jam)
+   CSMA_CA           // 802.11-style collision avoidance (back-offs count down idle time slots only)
 } CSMA_TYPE;
 
+// Enum representing the engine used to advance the simulation.
+typedef enum ENGINE_TYPE {
+   SLOT_ENGINE = 0,     // steps every time slot
+   EVENT_ENGINE,        // jumps between the time slots in which a node has something to do
+   LANE_ENGINE          // steps LANE_COUNT replications together, one per vector lane (see laneengine.h)
+} ENGINE_TYPE;
+
+// Enum representing how frame arrivals are drawn.
+typedef enum ARRIVAL_MODEL {
+   GEOMETRIC_ARRIVALS = 0,    // each node's next arrival is sampled from the geometric gap between arrivals
+   BERNOULLI_ARRIVALS         // every node draws a Bernoulli trial in every time slot (batched across nodes)
+} ARRIVAL_MODEL;
+
+// Enum representing how long a collision holds the medium for the protocols without collision detection.
+typedef enum COLLISION_MODEL {
+   SLOT_COLLISIONS = 0,    // a collision is given up on in the time slot it happens in
+   FRAME_COLLISIONS        // colliding frames are sent whole, holding the medium for FRAME_LENGTH
+} COLLISION_MODEL;
+
+// Enum representing how the nodes are assigned to the channels.
+typedef enum CHANNEL_SELECTION {
+   STATIC_CHANNELS = 0,    // node i always uses channel i % CHANNEL_COUNT
+   RANDOM_CHANNELS         // a node draws a channel for each frame, kept until the frame is transmitted
+} CHANNEL_SELECTION;
+
+// Enum representing which nodes hear each other (see topology.h).
+typedef enum TOPOLOGY_TYPE {
+   FULL_TOPOLOGY = 0,      // every node hears every other node
+   GRID_TOPOLOGY,          // nodes on a square grid, linked within TOPOLOGY_RANGE
+   GEOMETRIC_TOPOLOGY,     // nodes placed at random, linked within TOPOLOGY_RANGE
+   FILE_TOPOLOGY           // links read from TOPOLOGY_FILE
+} TOPOLOGY_TYPE;
+
+// Enum representing the format the results are written in.
+typedef enum RESULT_FORMAT {
+   TEXT_RESULTS = 0,    // human-readable reports
+   CSV_RESULTS,         // comma-separated rows
+   JSONL_RESULTS,       // one JSON object per line
+   BINARY_RESULTS       // packed records
+} RESULT_FORMAT;
+
+// Enum representing the per-replication statistics that can end the replications early (STOP_STATISTICS).
+typedef enum STOP_STATISTIC {
+   OFFERED_LOAD_STATISTIC = 0,   // frames' worth of time slots generated per time slot
+   THROUGHPUT_STATISTIC,         // frames' worth of time slots transmitted per time slot
+   MEAN_DELAY_STATISTIC,         // time slots waited per message transmitted
+   COLLISION_RATIO_STATISTIC,    // collisions per transmission attempt
+   DROP_RATIO_STATISTIC          // messages dropped per message generated
+} STOP_STATISTIC;
+
 class Configuration {
    public:
       // Constructor with args.
       Configuration(std::string configurationIni);
    
-      // Destructor not declared since the default will suffice.
+      // Destructor not declared since the default will suffice. Copies are used as the points of a sweep.
    
 	   /*
        * SETTERS
@@ -28,7 +86,7 @@ class Configuration {
       bool setVerboseEnabled(bool isEnabled);
       
       // Setter for theSimulationCount.
-      bool setSimulationCount(unsigned int count);
+      bool setSimulationCount(unsigned long count);
       
       // Setter for theTimeSlotCount.
       bool setTimeSlotCount(unsigned long count);
@@ -51,6 +109,84 @@ class Configuration {
       // Setter for theMaxBackoffRetransmitCount.
       bool setMaxBackoffRetransmitCount(int count);
    
+      // Setter for theThreadCount.
+      bool setThreadCount(unsigned int count);
+   
+      // Setter for theEngineType.
+      bool setEngineType(ENGINE_TYPE engineType);
+   
+      // Setter for thePackedNodeStatesEnabled.
+      bool setPackedNodeStatesEnabled(bool isEnabled);
+   
+      // Setter for theShuffleNodesEnabled.
+      bool setShuffleNodesEnabled(bool isEnabled);
+   
+      // Setter for theMessageBufferDepth.
+      bool setMessageBufferDepth(int depth);
+   
+      // Setter for theSeed.
+      bool setSeed(uint64_t seed);
+   
+      // Setter for theArrivalModel.
+      bool setArrivalModel(ARRIVAL_MODEL arrivalModel);
+   
+      // Setter for theCollisionModel.
+      bool setCollisionModel(COLLISION_MODEL collisionModel);
+   
+      // Setter for theResultFormat.
+      bool setResultFormat(RESULT_FORMAT resultFormat);
+   
+      // Setter for theResultFile.
+      bool setResultFile(std::string resultFile);
+   
+      // Setter for theTraceFile.
+      bool setTraceFile(std::string traceFile);
+   
+      // Setter for theTraceNodes.
+      bool setTraceNodes(std::vector<int> nodes);
+   
+      // Setter for theTraceFirstSlot and theTraceLastSlot.
+      bool setTraceSlots(unsigned long firstSlot, unsigned long lastSlot);
+   
+      // Setter for theStopStatistics.
+      bool setStopStatistics(std::vector<STOP_STATISTIC> statistics);
+   
+      // Setter for theStopRelativeHalfWidth.
+      bool setStopRelativeHalfWidth(double halfWidth);
+   
+      // Setter for theStopConfidence.
+      bool setStopConfidence(double confidence);
+   
+      // Setter for theStopMinSimulationCount.
+      bool setStopMinSimulationCount(unsigned int count);
+   
+      // Setter for theCheckpointFile.
+      bool setCheckpointFile(std::string checkpointFile);
+   
+      // Setter for theCheckpointInterval.
+      bool setCheckpointInterval(unsigned int seconds);
+   
+      // Setter for theResumeEnabled.
+      bool setResumeEnabled(bool isEnabled);
+   
+      // Setter for theChannelCount.
+      bool setChannelCount(int count);
+   
+      // Setter for theChannelSelection.
+      bool setChannelSelection(CHANNEL_SELECTION selection);
+      
+      // Setter for theTopologyType.
+      bool setTopologyType(TOPOLOGY_TYPE topologyType);
+      
+      // Setter for theTopologyRange.
+      bool setTopologyRange(double range);
+      
+      // Setter for theTopologyFile.
+      bool setTopologyFile(std::string topologyFile);
+      
+      // Builds theTopology for the node count, from the TOPOLOGY keys. Returns false if it cannot be built.
+      bool buildTopology();
+   
       /*
        * GETTERS
        */
@@ -81,6 +217,109 @@ class Configuration {
       // Getter for theMaxBackoffRetransmitCount.
       int getMaxBackoffRetransmitCount();
    
+      // Getter for theThreadCount.
+      unsigned int getThreadCount();
+   
+      // Getter for theEngineType.
+      ENGINE_TYPE getEngineType();
+   
+      // Getter for thePackedNodeStatesEnabled.
+      bool getPackedNodeStatesEnabled();
+   
+      // Getter for theShuffleNodesEnabled.
+      bool getShuffleNodesEnabled();
+   
+      // Getter for theMessageBufferDepth.
+      int getMessageBufferDepth();
+   
+      // Getter for theSeed.
+      uint64_t getSeed();
+   
+      // Getter for theArrivalModel.
+      ARRIVAL_MODEL getArrivalModel();
+   
+      // Getter for theCollisionModel.
+      COLLISION_MODEL getCollisionModel();
+   
+      // Getter for theResultFormat.
+      RESULT_FORMAT getResultFormat();
+   
+      // Getter for theResultFile.
+      std::string getResultFile();
+   
+      // Getter for theTraceFile.
+      std::string getTraceFile();
+   
+      // Getter for theTraceNodes.
+      std::vector<int> getTraceNodes();
+   
+      // Getter for theTraceFirstSlot.
+      unsigned long getTraceFirstSlot();
+   
+      // Getter for theTraceLastSlot.
+      unsigned long getTraceLastSlot();
+   
+      // Getter for theStopStatistics.
+      std::vector<STOP_STATISTIC> getStopStatistics();
+   
+      // Getter for theStopRelativeHalfWidth.
+      double getStopRelativeHalfWidth();
+   
+      // Getter for theStopConfidence.
+      double getStopConfidence();
+   
+      // Getter for theStopMinSimulationCount.
+      unsigned int getStopMinSimulationCount();
+   
+      // Returns true if STOP_STATISTICS was configured, making SIMULATION_COUNT a cap rather than a count.
+      bool isStoppingEnabled();
+   
+      // Getter for theCheckpointFile.
+      std::string getCheckpointFile();
+   
+      // Getter for theCheckpointInterval.
+      unsigned int getCheckpointInterval();
+   
+      // Getter for theResumeEnabled.
+      bool getResumeEnabled();
+   
+      // Getter for theChannelCount.
+      int getChannelCount();
+   
+      // Getter for theChannelSelection.
+      CHANNEL_SELECTION getChannelSelection();
+      
+      // Getter for theTopologyType.
+      TOPOLOGY_TYPE getTopologyType();
+      
+      // Getter for theTopologyRange.
+      double getTopologyRange();
+      
+      // Getter for theTopologyFile.
+      std::string getTopologyFile();
+      
+      // Returns true if TOPOLOGY is other than full.
+      bool isTopologyEnabled();
+      
+      // Getter for theTopology. Only built when isTopologyEnabled().
+      Topology& getTopology();
+   
+      // Returns true if CHECKPOINT_FILE was configured.
+      bool isCheckpointEnabled();
+   
+      // Returns true if the INI declared at least one SWEEP_ key.
+      bool isSweepEnabled();
+   
+      // Fills points with one copy of this configuration per combination of the swept values, the first swept key 
+      // varying slowest. Returns false if any swept value is invalid or a point's topology cannot be built.
+      bool expandSweep(std::vector<Configuration>& points);
+   
+      // Getter for theFrameGenerationThreshold.
+      uint64_t getFrameGenerationThreshold();
+   
+      // Getter for thePersistenceThreshold.
+      uint64_t getPersistenceThreshold();
+   
    private:
       // Stores the status of verbose logging, true or false.
       bool theVerboseEnabled;
@@ -109,6 +348,107 @@ class Configuration {
       // Stores the maximum backoff retransmit count.
       int theMaxBackoffRetransmitCount;
       
+      // Stores the count of worker threads used to run replications. A value of 0 uses every hardware thread.
+      unsigned int theThreadCount;
+      
+      // Stores the engine used to advance the simulation.
+      ENGINE_TYPE theEngineType;
+      
+      // Stores whether node states are packed 2 bits per node (for very large node counts).
+      bool thePackedNodeStatesEnabled;
+      
+      // Stores whether the nodes are serviced in a shuffled order each time slot.
+      bool theShuffleNodesEnabled;
+      
+      // Stores the count of messages each node can buffer before the newest buffered message is dropped.
+      int theMessageBufferDepth;
+      
+      // Stores the seed every random draw is keyed to. Defaults to the start time when not configured.
+      uint64_t theSeed;
+      
+      // Stores how frame arrivals are drawn.
+      ARRIVAL_MODEL theArrivalModel;
+      
+      // Stores how long a collision holds the medium for the protocols without collision detection.
+      COLLISION_MODEL theCollisionModel;
+      
+      // Stores the format the results are written in.
+      RESULT_FORMAT theResultFormat;
+      
+      // Stores the file the machine-readable results are written to ("-" for stdout). Empty until configured, 
+      // which selects a name from the format.
+      std::string theResultFile;
+      
+      // Stores the file the binary event trace is written to. Empty disables tracing.
+      std::string theTraceFile;
+      
+      // Stores the nodes whose events are traced. Empty traces every node.
+      std::vector<int> theTraceNodes;
+      
+      // Stores the window of time slots traced, inclusive.
+      unsigned long theTraceFirstSlot;
+      unsigned long theTraceLastSlot;
+      
+      // Stores the statistics whose confidence intervals end the replications early. Empty runs every replication.
+      std::vector<STOP_STATISTIC> theStopStatistics;
+      
+      // Stores the target half-width of the confidence intervals, relative to their means.
+      double theStopRelativeHalfWidth;
+      
+      // Stores the confidence level of the intervals.
+      double theStopConfidence;
+      
+      // Stores the count of replications run before the intervals are first checked.
+      unsigned int theStopMinSimulationCount;
+      
+      // Stores the file the run is checkpointed to. Empty disables checkpoints.
+      std::string theCheckpointFile;
+      
+      // Stores the seconds between checkpoints.
+      unsigned int theCheckpointInterval;
+      
+      // Stores whether the run resumes from theCheckpointFile, when it exists.
+      bool theResumeEnabled;
+      
+      // Stores the count of independent channels the nodes are spread over.
+      int theChannelCount;
+      
+      // Stores how the nodes are assigned to the channels.
+      CHANNEL_SELECTION theChannelSelection;
+      
+      // Stores which nodes hear each other.
+      TOPOLOGY_TYPE theTopologyType;
+      
+      // Stores the distance, in grid spacings, within which two nodes of a grid or geometric topology hear each other.
+      double theTopologyRange;
+      
+      // Stores the file the links of TOPOLOGY=file are read from.
+      std::string theTopologyFile;
+      
+      // Stores the carrier-sense graph built from the keys above, shared read-only by every replication.
+      Topology theTopology;
+      
+      // Stores theProbFrameGeneration as a Bernoulli threshold for CounterRng::generateBernoulli().
+      uint64_t theFrameGenerationThreshold;
+      
+      // Stores theProbabilityOfPersistance as a Bernoulli threshold for CounterRng::generateBernoulli().
+      uint64_t thePersistenceThreshold;
+      
+      // Stores the swept keys, in INI order, with the values each takes.
+      std::vector<std::pair<std::string, std::vector<std::string> > > theSweepDimensions;
+      
+      // Helper function that records the values of a SWEEP_ key, given as a list (a,b,c) or a range (start:stop:step).
+      bool addSweepDimension(std::string key, std::string value);
+      
+      // Helper function that parses the TRACE_NODES list (a,b,c with a-b ranges).
+      bool parseTraceNodes(std::string value);
+      
+      // Helper function that parses the TRACE_SLOTS window (start:stop, either side may be empty).
+      bool parseTraceSlots(std::string value);
+      
+      // Helper function that parses the STOP_STATISTICS list (names of the sweep row columns).
+      bool parseStopStatistics(std::string value);
+      
       // Helper function that checks if a line is blank, comment or category.
       bool checkLineForConfigurationString(std::string line);
    
@@ -0,0 +1,292 @@
+/*
+ * Implementation of the EventEngine class. A discrete-event alternative to stepping determineNodeStates() through 
+ * every time slot.
+ */
+
+#include <algorithm>    // std::min, std::push_heap, std::pop_heap
+
+#include "eventengine.h"
+#include "nodestore.h"
+#include "profiler.h"
+#include "protocol.h"
+
+// EventEngine class constructor with args.
+EventEngine::EventEngine(Configuration* configObj) {
+   theConfigObj = configObj;
+   theTimeSlotCount = 0;
+   theNodeStore = NULL;
+   
+   // Resolve the protocol once instead of in every time slot.
+   switch (configObj->getCsmaType()) {
+      case NON_PERSISTENT:
+         theTimeSlotProcessor = &EventEngine::processTimeSlot<NonPersistentPolicy>;
+         break;
+      case ONE_PERSISTENT:
+         theTimeSlotProcessor = &EventEngine::processTimeSlot<OnePersistentPolicy>;
+         break;
+      case P_PERSISTENT:
+         theTimeSlotProcessor = &EventEngine::processTimeSlot<PPersistentPolicy>;
+         break;
+      case CSMA_CD:
+         theTimeSlotProcessor = &EventEngine::processTimeSlot<CsmaCdPolicy>;
+         break;
+      case CSMA_CA:
+         theTimeSlotProcessor = &EventEngine::processTimeSlot<CsmaCaPolicy>;
+         break;
+   }
+   
+   // Size every buffer once. A node has at most a frame arrival plus either a back-off expiry or a transmit 
+   // completion pending, so two events per node keep the event heap from ever reallocating.
+   int nodeCount = configObj->getNodeCount();
+   theEventHeap.reserve(2 * nodeCount);
+   theLastVisitTimes.resize(nodeCount);
+   theTransmittingSlots.resize(nodeCount);
+   theDueNodes.reserve(nodeCount);
+   theTransmittingNodes.reserve(nodeCount);
+}
+
+// Prepares a replication of the nodes in nodeStore, queueing their first frame arrivals.
+void EventEngine::start(NodeStore& nodeStore) {
+   // Reset the state left over from any previous replication.
+   int nodeCount = nodeStore.getNodeCount();
+   theNodeStore = &nodeStore;
+   theTimeSlotCount = theConfigObj->getTimeSlotCount();
+   
+   theEventHeap.clear();
+   theLastVisitTimes.assign(nodeCount, -1);
+   theTransmittingSlots.assign(nodeCount, 0);
+   
+   // Every node starts idle, so the first events are the first frame arrivals (drawn by the store).
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      scheduleEvent(nodeStore.getNextArrivalTime(nodeIndex), nodeIndex);
+   }
+}
+
+// Runs the next time slot in which something happens, jumping straight from one event time to the next. Returns 
+// false once there is none left.
+bool EventEngine::processNextTimeSlot() {
+   if (theEventHeap.empty()) {
+      return false;
+   }
+   
+   // Gather the nodes due in this time slot, once each.
+   profilePhase(PHASE_SCHEDULING);
+   unsigned long currentTime = theEventHeap.front().time;
+   theDueNodes.clear();
+   while (!theEventHeap.empty() && currentTime == theEventHeap.front().time) {
+      int nodeIndex = theEventHeap.front().nodeIndex;
+      std::pop_heap(theEventHeap.begin(), theEventHeap.end(), std::greater<Event>());
+      theEventHeap.pop_back();
+      
+      if (theLastVisitTimes[nodeIndex] != static_cast<long>(currentTime)) {
+         theLastVisitTimes[nodeIndex] = currentTime;
+         theDueNodes.push_back(theNodeStore->getNode(nodeIndex));
+      }
+   }
+   
+   CLOG_WRITE(CLog::VERBOSE, "---- event timeIndex: %lu ----\n", currentTime);
+   traceSlot(currentTime);
+   (this->*theTimeSlotProcessor)(currentTime);
+   profileSlotEnd();
+   return true;
+}
+
+// Accounts, after the last time slot, for the time slots every node spent idle and transmitting.
+void EventEngine::finish() {
+   // Every time slot that a node did not spend transmitting was spent idle (waiting or backed-off).
+   for (int nodeIndex = 0; nodeIndex < theNodeStore->getNodeCount(); nodeIndex++) {
+      Metric* nodeMetric = theNodeStore->getNode(nodeIndex)->theNodeMetric;
+      nodeMetric->setClockCyclesTransmitting(theTransmittingSlots[nodeIndex]);
+      nodeMetric->setClockCyclesIdle(theTimeSlotCount - theTransmittingSlots[nodeIndex]);
+   }
+}
+
+// Appends the pending events and per-node accounting to state, between two time slots.
+void EventEngine::saveState(StateBuffer& state) {
+   state.appendVector(theEventHeap);
+   state.appendVector(theLastVisitTimes);
+   state.appendVector(theTransmittingSlots);
+}
+
+// Resumes a replication of the nodes in nodeStore (restored from the same checkpoint) from the state saved by 
+// saveState(), in place of start(). The heap is restored in its saved order, so the events pop in the same order. 
+// Returns false if state is too short.
+bool EventEngine::restoreState(NodeStore& nodeStore, StateBuffer& state) {
+   theNodeStore = &nodeStore;
+   theTimeSlotCount = theConfigObj->getTimeSlotCount();
+   return state.readVector(theEventHeap) 
+       && state.readVector(theLastVisitTimes) 
+       && state.readVector(theTransmittingSlots);
+}
+
+// Queues a visit of nodeIndex at time, ignoring times past the end of the simulation.
+void EventEngine::scheduleEvent(unsigned long time, int nodeIndex) {
+   if (time < theTimeSlotCount) {
+      Event event;
+      event.time = time;
+      event.nodeIndex = nodeIndex;
+      theEventHeap.push_back(event);
+      std::push_heap(theEventHeap.begin(), theEventHeap.end(), std::greater<Event>());
+   }
+}
+
+// Runs the completion, generation, contention and collision phases of determineNodeStates() for the nodes that are 
+// due in currentTime, for the protocol of Policy. Nodes that are not due would only have counted an idle or 
+// transmitting slot.
+template <class Policy>
+void EventEngine::processTimeSlot(unsigned long currentTime) {
+   // Check if any due node has completed its transmission. With a topology, a frame its receiver did not get is 
+   // retransmitted instead.
+   profilePhase(PHASE_COMPLETION);
+   ProtocolContext context = { theNodeStore, theConfigObj, NULL };
+   for (std::vector<Node*>::iterator it = theDueNodes.begin(); it != theDueNodes.end(); it++) {
+      if (TRANSMITTING != (*it)->getNodeState() 
+       || static_cast<long>(currentTime) != (*it)->getTimeOfTransmitCompletion()) {
+         continue;
+      }
+      
+      if (theNodeStore->isFrameReceived((*it)->getInternalAddress())) {
+         if (!(*it)->completeMessageTransmit(currentTime)) {
+               std::cout << "WARNING - failed to complete message transmit for node " 
+                         << (*it)->getInternalAddress() 
+                         << std::endl;
+         }
+      }
+      else if ((*it)->abortMessageTransmit()) {
+         // The receiver heard another transmitter during the frame (topology only); back off as after any collision.
+         backoffNode(*it, Policy::onCollision(context, *it, currentTime));
+         
+         CLOG_WRITE(CLog::VERBOSE, 
+                    "collision occurred at the receiver of node %d, next transmit at time %ld\n", 
+                    (*it)->getInternalAddress(), 
+                    (*it)->getNextAttemptedTransmitTime());
+         traceEvent(TRACE_COLLISION, (*it)->getInternalAddress(), (*it)->getNextAttemptedTransmitTime());
+         
+         // Update the metric. The attempt was counted when the transmit started.
+         (*it)->theNodeMetric->incrementCountOfCollisions();
+      }
+   }
+   
+   // Check if any due node generates a message.
+   profilePhase(PHASE_GENERATION);
+   for (std::vector<Node*>::iterator it = theDueNodes.begin(); it != theDueNodes.end(); it++) {
+      int nodeIndex = (*it)->getInternalAddress();
+      if (static_cast<long>(currentTime) == theNodeStore->getNextArrivalTime(nodeIndex)) {
+         CLOG_WRITE(CLog::VERBOSE, "node %d generating a message\n", nodeIndex);
+         traceEvent(TRACE_GENERATE, nodeIndex);
+         
+         // Load the message.
+         if (!(*it)->addMessage(currentTime)) {
+            std::cout << "ERROR - failed to add message" << std::endl;  
+         }
+         
+         theNodeStore->scheduleNextArrival(nodeIndex, currentTime);
+         scheduleEvent(theNodeStore->getNextArrivalTime(nodeIndex), nodeIndex);
+      }
+   }
+   
+   // The protocol's decisions are taken by Policy. The p-persistence draws are taken one node at a time.
+   profilePhase(PHASE_CONTENTION);
+   
+   // Check if any due node will attempt to transmit.
+   theTransmittingNodes.clear();
+   for (std::vector<Node*>::iterator it = theDueNodes.begin(); it != theDueNodes.end(); it++) {
+      if (TRANSMITTING == (*it)->getNodeState()) {
+         // Visited for a frame arrival while transmitting; nothing else to do.
+         continue;
+      }
+      else if (BACKED_OFF == (*it)->getNodeState() 
+            && static_cast<long>(currentTime) != (*it)->getNextAttemptedTransmitTime()) {
+         // Visited for a frame arrival while backed-off; the back-off continues.
+         continue;
+      }
+      else if (BACKED_OFF == (*it)->getNodeState() && !Policy::isBackoffExpired(context, *it, currentTime)) {
+         // The back-off was pushed out by a busy medium; visit the node at its new time.
+         scheduleEvent((*it)->getNextAttemptedTransmitTime(), (*it)->getInternalAddress());
+         continue;
+      }
+      else if (BACKED_OFF != (*it)->getNodeState() && !(*it)->hasMessage()) {
+         // Idle node with nothing to send.
+         continue;
+      }
+      
+      // The node is at the end of its back-off or is idle with a message. An idle node contends for its frame on the 
+      // channel selected for it now. The state of a channel only depends on the completion phase, so it is the same 
+      // for every due node on it.
+      if (BACKED_OFF != (*it)->getNodeState()) {
+         theNodeStore->selectChannel((*it)->getInternalAddress(), currentTime);
+      }
+      if (theNodeStore->getNodeChannel((*it)->getInternalAddress()).isIdle(currentTime)) {
+         // The node transmits here if the medium is idle, unless the protocol defers (p-persistence).
+         long deferredTransmitTime = Policy::onIdleWithFrame(context, *it, currentTime);
+         if (TRANSMIT_NOW == deferredTransmitTime) {
+            theTransmittingNodes.push_back(*it);
+         }
+         else {
+            // Backed-off until the deferred time and check again.
+            backoffNode(*it, deferredTransmitTime);
+         }
+      }
+      else {
+         // Medium is not idle. Determine the duration of the back-off.
+         backoffNode(*it, Policy::onBusy(context, *it, currentTime));
+         (*it)->theNodeMetric->incrementCountOfTransmissionAttempts();
+      }
+   }
+   
+   // Determine, channel by channel, if a node can transmit or if a collision occurred. Each channel first counts 
+   // the nodes that want to transmit on it.
+   profilePhase(PHASE_RESOLUTION);
+   for (std::vector<Node*>::iterator it = theTransmittingNodes.begin(); it != theTransmittingNodes.end(); it++) {
+      theNodeStore->getNodeChannel((*it)->getInternalAddress()).addContender();
+   }
+   for (std::vector<Node*>::iterator it = theTransmittingNodes.begin(); it != theTransmittingNodes.end(); it++) {
+      Channel& channel = theNodeStore->getNodeChannel((*it)->getInternalAddress());
+      if (1 == channel.getContenderCount()) {
+         // Alone on its channel.
+         channel.clearContenders();
+         if (!(*it)->startMessageTransmit(currentTime)) {
+            std::cout << "ERROR - failed to start transmit of message" << std::endl;  
+            continue;
+         }
+         
+         // The whole frame is accounted for now, cut short by the end of the simulation.
+         unsigned long completionTime = (*it)->getTimeOfTransmitCompletion();
+         theTransmittingSlots[(*it)->getInternalAddress()] += std::min(completionTime, theTimeSlotCount) - currentTime;
+         scheduleEvent(completionTime, (*it)->getInternalAddress());
+         
+         // Update the metric.
+         (*it)->theNodeMetric->incrementCountOfTransmissionAttempts();
+      }
+      else {
+         // The collision holds the channel for as long as the protocol takes to give up on it. It is started by the 
+         // first of the colliding nodes, which clears the channel's contenders.
+         if (0 < channel.getContenderCount()) {
+            channel.startCollision(currentTime, Policy::determineCollisionEndTime(context, currentTime));
+         }
+         
+         // Collision occurred for each node that tried to transmit on the channel.
+         backoffNode(*it, Policy::onCollision(context, *it, currentTime));
+         
+         CLOG_WRITE(CLog::VERBOSE, 
+                    "collision occurred for node %d, next transmit at time %ld\n", 
+                    (*it)->getInternalAddress(), 
+                    (*it)->getNextAttemptedTransmitTime());
+         traceEvent(TRACE_COLLISION, (*it)->getInternalAddress(), (*it)->getNextAttemptedTransmitTime());
+         
+         // Update the metrics.
+         (*it)->theNodeMetric->incrementCountOfCollisions();
+         (*it)->theNodeMetric->incrementCountOfTransmissionAttempts();
+      }
+   }
+}
+
+// Backs off the node until timeOfNextTransmitAttempt and schedules the visit at that time.
+void EventEngine::backoffNode(Node* nodeObj, long timeOfNextTransmitAttempt) {
+   if (!nodeObj->backoffFromTransmit(timeOfNextTransmitAttempt)) {
+      std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
+      return;
+   }
+   
+   scheduleEvent(timeOfNextTransmitAttempt, nodeObj->getInternalAddress());
+}
@@ -0,0 +1,90 @@
+/*
+ * Declaration of the EventEngine class. A discrete-event alternative to stepping determineNodeStates() through every 
+ * time slot. Only the time slots in which some node has a frame arrival, a back-off expiry or a transmit completion 
+ * are visited; every other slot leaves each node idle, waiting out a back-off or transmitting, all of which are 
+ * accounted for in bulk.
+ */
+
+#ifndef __EVENTENGINE_H__
+#define __EVENTENGINE_H__
+
+#include <functional>   // std::greater
+#include <vector>
+
+#include "helpers.h"
+#include "statebuffer.h"
+
+class EventEngine {
+   public:
+      // Constructor with args. Sizes every buffer for the configured node count so that run() never allocates.
+      EventEngine(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Prepares a replication of the nodes in nodeStore, queueing their first frame arrivals.
+      void start(NodeStore& nodeStore);
+      
+      // Runs the next time slot in which something happens. Returns false once there is none left.
+      bool processNextTimeSlot();
+      
+      // Accounts, after the last time slot, for the time slots every node spent idle and transmitting.
+      void finish();
+      
+      // Appends the pending events and per-node accounting to state, between two time slots.
+      void saveState(StateBuffer& state);
+      
+      // Resumes a replication of the nodes in nodeStore (restored from the same checkpoint) from the state saved by 
+      // saveState(), in place of start(). Returns false if state is too short.
+      bool restoreState(NodeStore& nodeStore, StateBuffer& state);
+   
+   private:
+      // A time slot in which a node must be visited. Ordered by time so the heap yields the earliest first.
+      struct Event {
+         unsigned long time;
+         int nodeIndex;
+         
+         bool operator>(const Event& other) const {
+            return time > other.time || (time == other.time && nodeIndex > other.nodeIndex);
+         }
+      };
+      
+      // Queues a visit of nodeIndex at time, ignoring times past the end of the simulation.
+      void scheduleEvent(unsigned long time, int nodeIndex);
+      
+      // Runs the completion, generation, contention and collision phases of determineNodeStates() for the nodes 
+      // that are due in currentTime, for the protocol of Policy (see protocol.h).
+      template <class Policy>
+      void processTimeSlot(unsigned long currentTime);
+      
+      // Backs off the node until timeOfNextTransmitAttempt and schedules the visit at that time.
+      void backoffNode(Node* nodeObj, long timeOfNextTransmitAttempt);
+      
+      // Configuration shared (read-only) by every replication.
+      Configuration* theConfigObj;
+      
+      // processTimeSlot() for the configured protocol, selected once.
+      void (EventEngine::*theTimeSlotProcessor)(unsigned long currentTime);
+      
+      // Count of time slots in the simulation.
+      unsigned long theTimeSlotCount;
+      
+      // Nodes of the current replication.
+      NodeStore* theNodeStore;
+      
+      // Pending node visits, kept as a min-heap (std::push_heap/std::pop_heap) in storage reserved up front.
+      std::vector<Event> theEventHeap;
+      
+      // Per-node time of the last visit, used to visit a node once per slot when several of its events coincide.
+      std::vector<long> theLastVisitTimes;
+      
+      // Per-node count of time slots spent transmitting, accumulated as whole frames when each transmit starts.
+      std::vector<unsigned long> theTransmittingSlots;
+      
+      // Scratch list of nodes due in the current time slot.
+      std::vector<Node*> theDueNodes;
+      
+      // Scratch list of nodes that intend to transmit in the current time slot.
+      std::vector<Node*> theTransmittingNodes;
+};
+
+#endif   // __EVENTENGINE_H__
@@ -2,216 +2,348 @@
  * Implementation of helper functions that belong to no class.
  */
 
-#include <algorithm>    // random_shuffle
+#include <algorithm>    // std::swap
+#include <cmath>        // log, log1p, floor
 
 #include "helpers.h"
+#include "nodestore.h"
+#include "profiler.h"
+#include "protocol.h"
 
-// Helper function that loops through each node and determines the state of each node based on the current configuration.
+// Random number generator of the calling thread. It holds only the key of the replication being run, every draw is 
+// computed from the key and the draw's identity, so results never depend on which thread runs a replication.
+static thread_local CounterRng theRandomGenerator;
+
+// Helper function that takes the transmit decision of a node in the contention pass of determineNodeStates(), for the 
+// protocol of Policy: a backed-off node whose next attempt is due (see SlotScratch::dueBits) or a node waiting on the 
+// medium with a message (SlotScratch::waitingBits). With isStatusReported, it also logs and traces a transmitting or 
+// backed-off node, which is otherwise never visited.
+template <class Policy>
+static void contendNode(ProtocolContext& context, int nodeIndex, unsigned long currentTime, bool isStatusReported) {
+   NodeStore& nodeStore = *context.nodeStore;
+   SlotScratch& scratch = *context.scratch;
+   Node* nodeObj = nodeStore.getNode(nodeIndex);
+   int word = nodeIndex >> 6;
+   uint64_t bit = 1ULL << (nodeIndex & 63);
+   if (isStatusReported) {
+      if (0 != (nodeStore.getTransmittingBits(word) & bit)) {
+         // No need to consider transmitting again if already transmitting.
+         CLOG_WRITE(CLog::VERBOSE, "node %d is transmitting\n", nodeIndex);
+         traceEvent(TRACE_TRANSMITTING, nodeIndex);
+         return;
+      }
+      else if (0 != (nodeStore.getBackedOffBits(word) & bit)) {
+         CLOG_WRITE(CLog::VERBOSE, "node %d is backed-off\n", nodeIndex);
+         traceEvent(TRACE_BACKED_OFF, nodeIndex);
+      }
+   }
+   
+   if (0 != (scratch.dueBits[word] & bit)) {
+      if (!Policy::isBackoffExpired(context, nodeObj, currentTime)) {
+         return;
+      }
+      
+      CLOG_WRITE(CLog::VERBOSE, "now is node %d's next attempted transmit time\n", nodeIndex);
+      traceEvent(TRACE_ATTEMPT_DUE, nodeIndex);
+      // Check if the medium is idle for a transmission. Nothing starts transmitting until the contention pass is 
+      // over, so every node senses its channel as it was after the completion pass.
+      if (nodeStore.getNodeChannel(nodeIndex).isIdle(currentTime)) {
+         CLOG_WRITE(CLog::VERBOSE, "medium is idle for retransmit attempt\n");
+         traceEvent(TRACE_RETRANSMIT_IDLE, nodeIndex);
+         // The node transmits here if the medium is idle, unless the protocol defers (p-persistence).
+         long deferredTransmitTime = Policy::onIdleWithFrame(context, nodeObj, currentTime);
+         if (TRANSMIT_NOW == deferredTransmitTime) {
+            nodeStore.markContender(nodeIndex);
+         }
+         else if (!nodeObj->backoffFromTransmit(deferredTransmitTime)) {
+            // Backed-off until the deferred time and check again.
+            std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
+         }
+      }
+      else {
+         // Medium is not idle. Continue the back-off.
+         CLOG_WRITE(CLog::VERBOSE, "medium is NOT idle for retransmit attempt\n");
+         traceEvent(TRACE_RETRANSMIT_BUSY, nodeIndex);
+         if (!nodeObj->backoffFromTransmit(Policy::onBusy(context, nodeObj, currentTime))) {
+            std::cout << "ERROR - failed to continue back-off from transmit of message" << std::endl;
+         }
+         
+         // Update the metric.
+         nodeObj->theNodeMetric->incrementCountOfTransmissionAttempts();
+      }
+   }
+   else if (0 != (scratch.waitingBits[word] & bit)) {
+      // The idle node has a message, contended for on the channel selected for it now.
+      nodeStore.selectChannel(nodeIndex, currentTime);
+      if (nodeStore.getNodeChannel(nodeIndex).isIdle(currentTime)) {
+         // The node transmits here if the medium is idle, unless the protocol defers (p-persistence).
+         long deferredTransmitTime = Policy::onIdleWithFrame(context, nodeObj, currentTime);
+         if (TRANSMIT_NOW == deferredTransmitTime) {
+            // Transmit the message.
+            CLOG_WRITE(CLog::VERBOSE, "medium is idle for transmit so node will transmit\n");
+            traceEvent(TRACE_TRANSMIT_IDLE, nodeIndex);
+            nodeStore.markContender(nodeIndex);
+         }
+         else if (!nodeObj->backoffFromTransmit(deferredTransmitTime)) {
+            // Backoff until the deferred time and do it again.
+            std::cout << "ERROR - failed to continue back-off from transmit of message" << std::endl;
+         }
+      }
+      else {
+         // Medium is NOT idle. Determine the duration of the back-off.
+         CLOG_WRITE(CLog::VERBOSE, "medium is NOT idle for retransmit attempt\n");
+         traceEvent(TRACE_TRANSMIT_BUSY, nodeIndex);
+         long nextAttemptedTransmitTime = Policy::onBusy(context, nodeObj, currentTime);
+
+         // Execute the back-off.
+         if (!nodeObj->backoffFromTransmit(nextAttemptedTransmitTime)) {
+            std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
+         }
+         
+         // Update the metric.
+         nodeObj->theNodeMetric->incrementCountOfTransmissionAttempts();
+      }
+   }
+}
+
+// Helper function that loops through each node and determines the state of each node, for the protocol of Policy.
 // A decision was made to not verify that the objects are not null to speed up the application. This is risky and not 
 // suitable for any sort of commercial product.
-void determineNodeStates(std::vector<Node*> nodeVector, unsigned int currentTime, Configuration* configObj) {
+template <class Policy>
+void determineNodeStates(NodeStore& nodeStore, unsigned long currentTime, Configuration* configObj, SlotScratch& scratch) {
    /* 
-    * Shuffle the order of the node vector so that the nodes are being serviced in a "random" order. 
-    * This will help prevent service biases.
+    * Optionally shuffle the order in which the nodes are serviced so that they are serviced in a "random" order. 
+    * Every decision below is taken against the channel snapshot that follows the completion pass and every random 
+    * draw is keyed by node and time slot, so the service order never changes the outcome of the time slot; the 
+    * shuffle only orders the time slot's trace events as earlier traces did, and is off by default.
     */
-   std::random_shuffle(nodeVector.begin(), nodeVector.end());
+   profilePhase(PHASE_SCHEDULING);
+   std::vector<int>& serviceOrder = scratch.serviceOrder;
+   if (configObj->getShuffleNodesEnabled()) {
+      serviceOrder.resize(nodeStore.getNodeCount());
+      for (unsigned int nodeIndex = 0; nodeIndex < serviceOrder.size(); nodeIndex++) {
+         serviceOrder[nodeIndex] = nodeIndex;
+      }
+      shuffleNodes(serviceOrder, currentTime);
+   }
    
-   // Loop through each node to check if any transmits concluded.
-   for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-      // Check if current node is transmitting and has completed its transmission.
-      if (TRANSMITTING == (*it)->getNodeState() && currentTime == (*it)->getTimeOfTransmitCompletion()) {
-         if (!(*it)->completeMessageTransmit(currentTime)) {
+   // The protocol's decisions are taken by Policy.
+   ProtocolContext context = { &nodeStore, configObj, &scratch };
+   
+   // Check if any transmits concluded. The completion times are scanned in the store, only the transmitting nodes 
+   // whose completion time is now are visited.
+   profilePhase(PHASE_COMPLETION);
+   std::vector<int>& nodeIndexes = scratch.nodeIndexes;
+   nodeStore.collectCompletedTransmits(currentTime, nodeIndexes);
+   for (std::vector<int>::iterator it = nodeIndexes.begin(); it != nodeIndexes.end(); it++) {
+      Node* nodeObj = nodeStore.getNode(*it);
+      if (nodeStore.isFrameReceived(*it)) {
+         if (!nodeObj->completeMessageTransmit(currentTime)) {
                std::cout << "WARNING - failed to complete message transmit for node " 
-                         << (*it)->getInternalAddress() 
+                         << nodeObj->getInternalAddress() 
                          << std::endl;
          }
       }
+      else if (nodeObj->abortMessageTransmit()) {
+         // The receiver heard another transmitter during the frame (topology only). The sender learns of the 
+         // collision now, as the acknowledgement fails to arrive, and backs off as after any collision.
+         if (!nodeObj->backoffFromTransmit(Policy::onCollision(context, nodeObj, currentTime))) {
+            std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
+         }
+         
+         CLOG_WRITE(CLog::VERBOSE, 
+                    "collision occurred at the receiver of node %d, next transmit at time %ld\n", 
+                    nodeObj->getInternalAddress(), 
+                    nodeObj->getNextAttemptedTransmitTime());
+         traceEvent(TRACE_COLLISION, nodeObj->getInternalAddress(), nodeObj->getNextAttemptedTransmitTime());
+         
+         // Update the metric. The attempt was counted when the transmit started.
+         nodeObj->theNodeMetric->incrementCountOfCollisions();
+      }
    }
    
-   // Loop through each node to check if any nodes will generate a message.
-   for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-      // Determine if node should try to transmit - based on the porbability of frame generation.
-      if (generateRandomFloatZeroToOne() > (1 - configObj->getProbFrameGeneration())) {
-         // Initialize the message.
-         // TODO: give destination address a real value if it gets implemented
-         CLog::write(CLog::VERBOSE, "node %d generating a message\n", (*it)->getInternalAddress());
-         Message* message = new Message((*it)->getInternalAddress(),    // sender's address
-                                     0,                                 // destination's address
-                                     configObj->getFrameLength(),       // size
-                                     currentTime);                      // time of message creation
-         
-         // Load the message.
-         if (!(*it)->addMessage(message)) {
-            std::cout << "ERROR - failed to add message" << std::endl;  
+   // Load a message on each node with a frame arrival now. The arrivals are either drawn for every node in one batch 
+   // or, by default, kept in the store as each node's next arrival time so that time slots without an arrival cost a 
+   // single compare.
+   profilePhase(PHASE_GENERATION);
+   if (BERNOULLI_ARRIVALS == configObj->getArrivalModel()) {
+      generateBernoulliTrials(configObj->getFrameGenerationThreshold(), 
+                              RNG_ARRIVAL, 
+                              nodeStore.getNodeCount(), 
+                              currentTime, 
+                              &scratch.arrivalBits[0]);
+      nodeIndexes.clear();
+      for (unsigned int word = 0; word < scratch.arrivalBits.size(); word++) {
+         for (uint64_t arrivalBits = scratch.arrivalBits[word]; 0 != arrivalBits; arrivalBits &= arrivalBits - 1) {
+            nodeIndexes.push_back((word << 6) + __builtin_ctzll(arrivalBits));
          }
       }
    }
-               
-   // Determine the type of backoff.
-   CSMA_TYPE csmaType = configObj->getCsmaType();
+   else {
+      nodeStore.collectDueArrivals(currentTime, nodeIndexes);
+   }
+   for (std::vector<int>::iterator it = nodeIndexes.begin(); it != nodeIndexes.end(); it++) {
+      CLOG_WRITE(CLog::VERBOSE, "node %d generating a message\n", *it);
+      traceEvent(TRACE_GENERATE, *it);
+      
+      // Load the message. Only its creation time is kept; the sender is the node and the size is the frame length.
+      if (!nodeStore.getNode(*it)->addMessage(currentTime)) {
+         std::cout << "ERROR - failed to add message" << std::endl;  
+      }
+      if (GEOMETRIC_ARRIVALS == configObj->getArrivalModel()) {
+         nodeStore.scheduleNextArrival(*it, currentTime);
+      }
+   }
    
-   // Save off a list of nodes that intend to tranmist this time slot.
-   std::vector<Node*> transmittingNodes;
+   profilePhase(PHASE_CONTENTION);
    
-   // Loop through each node to check if any new transmissions will begin.
-   for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-      // Check if current node is transmitting.
-      if (TRANSMITTING == (*it)->getNodeState()) {
-         // No need to consider transmitting again if already transmitting.
-         CLog::write(CLog::VERBOSE, "node %d is transmitting\n", (*it)->getInternalAddress());
-                  
-         // Update the metric.
-         (*it)->theNodeMetric->incrementClockCyclesTransmitting();
-         
-         continue;
-      }
-      // Check if current node is transmitting.
-      else if (BACKED_OFF == (*it)->getNodeState()) {
-         CLog::write(CLog::VERBOSE, "node %d is backed-off\n", (*it)->getInternalAddress());
-         if (currentTime == (*it)->getNextAttemptedTransmitTime()) {
-            CLog::write(CLog::VERBOSE, "now is node %d's next attempted transmit time\n", (*it)->getInternalAddress());
-            // Check if the medium is idle for a transmission.
-            if ((*it)->isMediumIdle(nodeVector)) {
-               CLog::write(CLog::VERBOSE, "medium is idle for retransmit attempt\n");
-               // The node transmits here if the medium is idle and (with probability p if a p-persistence CSMA is used).
-               if (P_PERSISTENT == csmaType) {
-                  if (generateRandomFloatZeroToOne() > (1 - configObj->getProbOfPersistance())) {
-                     // p-Persistence node transmitting with probability p.
-                     transmittingNodes.push_back(*it);
-                  }
-                  else {
-                     // Backed-off with probability (1 - p) until next cycle and check again.
-                     if (!(*it)->backoffFromTransmit(currentTime + 1)) {
-                        std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
-                     }
-         
-                     // Update the metric.
-                     (*it)->theNodeMetric->incrementClockCyclesIdle();
-                  }
-               }
-               // Medium is idle and a CSMA protocol other than p-Persistent was chosen so transmit immediately.
-               else {
-                  transmittingNodes.push_back(*it);
-               }
-            }
-            else {
-               // Medium is not idle. Continue the back-off.
-               CLog::write(CLog::VERBOSE, "medium is NOT idle for retransmit attempt\n");
-               int nextAttemptedTransmitTime = (*it)->determineBackoffEndTime(currentTime, configObj);
-               if (!(*it)->backoffFromTransmit(nextAttemptedTransmitTime)) {
-                  std::cout << "ERROR - failed to continue back-off from transmit of message" << std::endl;
-               }
-               
-               // Update the metric.
-               (*it)->theNodeMetric->incrementClockCyclesIdle();
-               (*it)->theNodeMetric->incrementCountOfTransmissionAttempts();
-            }
-         }
-         else {         
-            // Update the metric.
-            (*it)->theNodeMetric->incrementClockCyclesIdle();
-         }
-         
-         // Check next node.
-         continue;
+   // The p-persistence draws are only taken if some node needs one this time slot.
+   scratch.isPersistenceDrawn = false;
+   
+   // Nodes that intend to transmit this time slot are flagged in the store's contention bits. Only the nodes with a 
+   // decision to take are visited, from the store's masks; every other node carries on idle, backed-off or 
+   // transmitting, and costs nothing as the time slots are accounted per transmit. They are only visited to report 
+   // them when tracing or logging.
+   bool isStatusReported = Tracer::isEnabled() || CLog::isEnabled(CLog::VERBOSE);
+   int attemptCount = nodeStore.collectAttemptBits(currentTime, scratch.dueBits, scratch.waitingBits);
+   if (configObj->getShuffleNodesEnabled()) {
+      for (std::vector<int>::iterator it = serviceOrder.begin(); it != serviceOrder.end(); it++) {
+         contendNode<Policy>(context, *it, currentTime, isStatusReported);
       }
-         
-      // Check if the idle node has a message to determine if it should start a transmission.
-      if ((*it)->hasMessage()) {
-         if ((*it)->isMediumIdle(nodeVector)) {
-            // If this is a p-persistent system another check is required.
-            if (P_PERSISTENT == csmaType) {
-               if (generateRandomFloatZeroToOne() > (1 - configObj->getProbOfPersistance())) {
-                  CLog::write(CLog::VERBOSE, 
-                              "medium is idle for retransmit attempt and p-persistent node %d will attempt to transmit\n", 
-                                    (*it)->getInternalAddress());
-                  transmittingNodes.push_back(*it);
-               }
-               else {
-                  // Backoff until next timeslot and do it again.
-                  CLog::write(CLog::VERBOSE, 
-                              "p-persistance node %d will wait until next time cycle and try again\n", 
-                              (*it)->getInternalAddress());
-                  if (!(*it)->backoffFromTransmit(currentTime + 1)) {
-                     std::cout << "ERROR - failed to continue back-off from transmit of message" << std::endl;
-                  }
-                  
-                  // Update the metric.
-                  (*it)->theNodeMetric->incrementClockCyclesIdle();
-               }
-            }
-            // Every other CSMA type will transmit immediately given an idle system.
-            else {
-               // Transmit the message.
-               CLog::write(CLog::VERBOSE, "medium is idle for transmit so node will transmit\n");
-               transmittingNodes.push_back(*it);
-            }
+   }
+   else if (0 != attemptCount || isStatusReported) {
+      for (unsigned int word = 0; word < scratch.dueBits.size(); word++) {
+         uint64_t visitBits = scratch.dueBits[word] | scratch.waitingBits[word];
+         if (isStatusReported) {
+            visitBits |= nodeStore.getTransmittingBits(word) | nodeStore.getBackedOffBits(word);
          }
-         else {
-            // Medium is NOT idle. Determine the duration of the back-off.
-            CLog::write(CLog::VERBOSE, "medium is NOT idle for retransmit attempt\n");
-            int nextAttemptedTransmitTime = (*it)->determineBackoffEndTime(currentTime, configObj);
-
-            // Execute the back-off.
-            if (!(*it)->backoffFromTransmit(nextAttemptedTransmitTime)) {
-               std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
-            }
-            
-            // Update the metric.
-            (*it)->theNodeMetric->incrementCountOfTransmissionAttempts();
-            (*it)->theNodeMetric->incrementClockCyclesIdle();
+         for (; 0 != visitBits; visitBits &= visitBits - 1) {
+            contendNode<Policy>(context, (word << 6) + __builtin_ctzll(visitBits), currentTime, isStatusReported);
          }
       }
-      else {
-         // Node is idle so metrics are only needed to update the metric.
-         (*it)->theNodeMetric->incrementClockCyclesIdle();
-      }
    }
    
-   // Determine if a node can transmit or if a collision occurred.
-   if (0 == transmittingNodes.size()) {
-      // Nothing to do.
+   // Determine, channel by channel, if a node can transmit or if a collision occurred. Each channel first counts 
+   // the nodes that want to transmit on it.
+   profilePhase(PHASE_RESOLUTION);
+   nodeStore.takeContenders(nodeIndexes);
+   for (std::vector<int>::iterator it = nodeIndexes.begin(); it != nodeIndexes.end(); it++) {
+      nodeStore.getNodeChannel(*it).addContender();
    }
-   else if (1 == transmittingNodes.size()) {
-      if (!transmittingNodes[0]->startMessageTransmit(currentTime)) {
-         std::cout << "ERROR - failed to start transmit of message" << std::endl;  
+   for (std::vector<int>::iterator it = nodeIndexes.begin(); it != nodeIndexes.end(); it++) {
+      Node* nodeObj = nodeStore.getNode(*it);
+      Channel& channel = nodeStore.getNodeChannel(*it);
+      if (1 == channel.getContenderCount()) {
+         // Alone on its channel.
+         channel.clearContenders();
+         if (!nodeObj->startMessageTransmit(currentTime)) {
+            std::cout << "ERROR - failed to start transmit of message" << std::endl;  
+         }
+         else {
+            // Update the metric, with every time slot of the transmit at once.
+            nodeStore.creditTransmittingSlots(*it, currentTime, nodeObj->getTimeOfTransmitCompletion());
+            nodeObj->theNodeMetric->incrementCountOfTransmissionAttempts();
+         }
       }
       else {
-         // Update the metric.
-         transmittingNodes[0]->theNodeMetric->incrementClockCyclesTransmitting();
-         transmittingNodes[0]->theNodeMetric->incrementCountOfTransmissionAttempts();
-      }
-   }
-   else {
-      // Collision occurred for each node that tried to transmit.
-      for (std::vector<Node*>::iterator it = transmittingNodes.begin(); it != transmittingNodes.end(); it++) {
-         int nextAttemptedTransmitTime = (*it)->determineEndOfBinaryExpBackoff(currentTime, configObj);
+         // The collision holds the channel for as long as the protocol takes to give up on it. It is started by the 
+         // first of the colliding nodes, which clears the channel's contenders.
+         if (0 < channel.getContenderCount()) {
+            channel.startCollision(currentTime, Policy::determineCollisionEndTime(context, currentTime));
+         }
+         
+         // Collision occurred for each node that tried to transmit on the channel.
+         long nextAttemptedTransmitTime = Policy::onCollision(context, nodeObj, currentTime);
          
          // Execute the back-off.
-         if (!(*it)->backoffFromTransmit(nextAttemptedTransmitTime)) {
+         if (!nodeObj->backoffFromTransmit(nextAttemptedTransmitTime)) {
             std::cout << "ERROR - failed to back-off from transmit of message" << std::endl;
          }
          
-         CLog::write(CLog::VERBOSE, 
-                     "collision occurred for node %d, next transmit at time %d\n", 
-                     (*it)->getInternalAddress(), 
-                     (*it)->getNextAttemptedTransmitTime());
+         CLOG_WRITE(CLog::VERBOSE, 
+                    "collision occurred for node %d, next transmit at time %ld\n", 
+                    nodeObj->getInternalAddress(), 
+                    nodeObj->getNextAttemptedTransmitTime());
+         traceEvent(TRACE_COLLISION, nodeObj->getInternalAddress(), nodeObj->getNextAttemptedTransmitTime());
          
          // Update the metrics.
-         (*it)->theNodeMetric->incrementCountOfCollisions();
-         (*it)->theNodeMetric->incrementClockCyclesIdle();
-         (*it)->theNodeMetric->incrementCountOfTransmissionAttempts();
+         nodeObj->theNodeMetric->incrementCountOfCollisions();
+         nodeObj->theNodeMetric->incrementCountOfTransmissionAttempts();
       }
    }
+   profileSlotEnd();
+}
+
+// Helper function that returns determineNodeStates() instantiated for the protocol, so that the protocol is resolved 
+// once per run instead of in every time slot.
+SlotKernel selectSlotKernel(CSMA_TYPE csmaType) {
+   switch (csmaType) {
+      case NON_PERSISTENT:
+         return &determineNodeStates<NonPersistentPolicy>;
+      case ONE_PERSISTENT:
+         return &determineNodeStates<OnePersistentPolicy>;
+      case P_PERSISTENT:
+         return &determineNodeStates<PPersistentPolicy>;
+      case CSMA_CD:
+         return &determineNodeStates<CsmaCdPolicy>;
+      case CSMA_CA:
+         return &determineNodeStates<CsmaCaPolicy>;
+   }
+   return NULL;
+}
+
+// Helper function used to key the calling thread's random number generator to a seed and replication.
+void seedRandomGenerator(uint64_t seed, unsigned int replication) {
+   theRandomGenerator.setKey(seed, replication);
+}
+
+// Helper function used to run a Bernoulli trial with the probability encoded by threshold (see 
+// CounterRng::computeBernoulliThreshold()). The draw is identified by its purpose, the node and the time slot.
+bool generateBernoulliTrial(uint64_t threshold, RNG_PURPOSE purpose, int nodeIndex, unsigned long timeSlot) {
+   return theRandomGenerator.generateBernoulli(nodeIndex, purpose, timeSlot, threshold);
 }
 
-// Helper function used to generate a random float [0.0, 1.0].
-float generateRandomFloatZeroToOne() {
-   return static_cast<float>(rand())/static_cast<float>(RAND_MAX);  
+// Helper function used to run the Bernoulli trial of every node [0, nodeCount) for a purpose and time slot at once. 
+// Bit i of bits (64 nodes per word) is set when node i succeeds, exactly as generateBernoulliTrial() would for node i.
+void generateBernoulliTrials(uint64_t threshold, RNG_PURPOSE purpose, int nodeCount, unsigned long timeSlot, 
+                             uint64_t* bits) {
+   theRandomGenerator.generateBernoulliBatch(purpose, timeSlot, threshold, nodeCount, bits);
 }
 
-// Helper function used to generate a random integer between minimum and maximum.
-// Note that this function is not perfect and can be biased towards a non-uniform distrution.
-int generateRandomIntegerMinToMax(unsigned int min, unsigned int max) {
-   return (rand() % static_cast<unsigned int>(max)) + min;
+// Helper function used to generate an unbiased random integer [min, max]. The draw is identified by its purpose, 
+// the node and the time slot.
+unsigned int generateRandomIntegerMinToMax(unsigned int min, unsigned int max, 
+                                           RNG_PURPOSE purpose, int nodeIndex, unsigned long timeSlot) {
+   return min + theRandomGenerator.generateBounded(nodeIndex, purpose, timeSlot, max - min + 1);
+}
+
+// Helper function used to generate the count of Bernoulli(probability) trials up to and including the first success. 
+// Returns 0 when no success can occur (probability of 0). Sampled by inversion, so one draw replaces the per-slot 
+// trials up to the next success.
+unsigned long generateGeometricInterval(float probability, RNG_PURPOSE purpose, int nodeIndex, unsigned long timeSlot) {
+   if (probability <= 0) {
+      return 0;
+   }
+   else if (probability >= 1) {
+      return 1;
+   }
+   
+   // Uniform on (0, 1], never 0 so that the log is finite.
+   double uniform = theRandomGenerator.generateUnitInterval(nodeIndex, purpose, timeSlot);
+   double interval = std::floor(std::log(uniform) / std::log1p(-static_cast<double>(probability))) + 1.0;
+   
+   // Clamp intervals that exceed any simulation length.
+   if (interval > 4e18) {
+      return 0;
+   }
+   return static_cast<unsigned long>(interval);
+}
+
+// Helper function used to shuffle the indexes of the nodes serviced in a time slot (Fisher-Yates). The i-th swap draws 
+// from stream i so that the shuffle never consumes a node's own draws.
+void shuffleNodes(std::vector<int>& nodeIndexes, unsigned long timeSlot) {
+   for (unsigned int index = nodeIndexes.size(); index > 1; index--) {
+      unsigned int swapIndex = theRandomGenerator.generateBounded(index - 1, RNG_SHUFFLE, timeSlot, index);
+      std::swap(nodeIndexes[index - 1], nodeIndexes[swapIndex]);
+   }
 }
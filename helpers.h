@@ -6,27 +6,72 @@
 #define __HELPERS_H__
 
 #include <iostream>
-#include <cstdlib>   // atof, atoi, exit, rand
+#include <cstdlib>   // atof, atoi, exit
+#include <stdint.h>
 #include <vector>
 
 #include "configuration.h"
 #include "node.h"
-#include "message.h"
 #include "metric.h"
 #include "CLog.h"
+#include "trace.h"
+#include "rng.h"
 
 // Forward declarations. Resolves circular dependency issues.
 class Configuration;
 class Node;
-class Message;
+class NodeStore;
 
-// Helper function that loops through each node and determines the state of each node based on the current configuration.
-void determineNodeStates(std::vector<Node*> nodeVector, unsigned int currentTime, Configuration* configObj);
+// Scratch buffers reused by determineNodeStates() from one time slot to the next so that the steady-state slot loop 
+// never allocates. Owned by the Simulation that runs the time slots.
+struct SlotScratch {
+   // Indexes of the nodes in the (shuffled) order they are serviced, with SHUFFLE_NODES only.
+   std::vector<int> serviceOrder;
+   
+   // Indexes of the nodes completing a transmit, then of the nodes contending for the medium.
+   std::vector<int> nodeIndexes;
+   
+   // Masks (one bit per node) of the backed-off nodes whose next attempt is due, and of the nodes waiting on the 
+   // medium with a message (see NodeStore::collectAttemptBits()).
+   std::vector<uint64_t> dueBits;
+   std::vector<uint64_t> waitingBits;
+   
+   // Batched Bernoulli draws of every node (one bit per node) for frame arrivals and for p-persistence.
+   std::vector<uint64_t> arrivalBits;
+   std::vector<uint64_t> persistenceBits;
+   
+   // True once persistenceBits holds the draws of the current time slot.
+   bool isPersistenceDrawn;
+};
 
-// Helper function used to generate a random float [0.0, 1.0].
-float generateRandomFloatZeroToOne();
+// Helper function that loops through each node and determines the state of each node, for the protocol of Policy (see 
+// protocol.h, whose selectSlotKernel() picks the instantiation).
+template <class Policy>
+void determineNodeStates(NodeStore& nodeStore, unsigned long currentTime, Configuration* configObj, SlotScratch& scratch);
 
-// Helper function used to generate a random integer between minimum and maximum.
-int generateRandomIntegerMinToMax(unsigned int min, unsigned int max);
+// Helper function used to key the calling thread's random number generator to a seed and replication.
+void seedRandomGenerator(uint64_t seed, unsigned int replication);
+
+// Helper function used to run a Bernoulli trial with the probability encoded by threshold (see 
+// CounterRng::computeBernoulliThreshold()). The draw is identified by its purpose, the node and the time slot.
+bool generateBernoulliTrial(uint64_t threshold, RNG_PURPOSE purpose, int nodeIndex, unsigned long timeSlot);
+
+// Helper function used to run the Bernoulli trial of every node [0, nodeCount) for a purpose and time slot at once. 
+// Bit i of bits (64 nodes per word) is set when node i succeeds, exactly as generateBernoulliTrial() would for node i.
+void generateBernoulliTrials(uint64_t threshold, RNG_PURPOSE purpose, int nodeCount, unsigned long timeSlot, 
+                             uint64_t* bits);
+
+// Helper function used to generate an unbiased random integer [min, max]. The draw is identified by its purpose, 
+// the node and the time slot.
+unsigned int generateRandomIntegerMinToMax(unsigned int min, unsigned int max, 
+                                           RNG_PURPOSE purpose, int nodeIndex, unsigned long timeSlot);
+
+// Helper function used to generate the count of Bernoulli(probability) trials up to and including the first success. 
+// Returns 0 when no success can occur (probability of 0). The draw is identified by its purpose, the node and the time 
+// slot.
+unsigned long generateGeometricInterval(float probability, RNG_PURPOSE purpose, int nodeIndex, unsigned long timeSlot);
+
+// Helper function used to shuffle the indexes of the nodes serviced in a time slot.
+void shuffleNodes(std::vector<int>& nodeIndexes, unsigned long timeSlot);
 
 #endif // __HELPERS_H__
@@ -0,0 +1,106 @@
+/*
+ * Implementation of the Histogram class. A log-bucketed histogram of unsigned 64-bit values.
+ */
+
+#include <cmath>        // ceil
+
+#include "histogram.h"
+
+// Helper function that returns the index of the bucket holding value.
+static inline unsigned int determineBucketIndex(uint64_t value) {
+   if (value < HISTOGRAM_SUB_BUCKET_COUNT) {
+      return static_cast<unsigned int>(value);
+   }
+   
+   // value is in [2^exponent, 2^(exponent + 1)), split into HISTOGRAM_SUB_BUCKET_COUNT buckets.
+   int exponent = 63 - __builtin_clzll(value);
+   int shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+   return static_cast<unsigned int>((shift + 1) * HISTOGRAM_SUB_BUCKET_COUNT
+                                    + ((value >> shift) - HISTOGRAM_SUB_BUCKET_COUNT));
+}
+
+// Helper function that returns the highest value held by bucket bucketIndex.
+static inline uint64_t determineBucketHighestValue(unsigned int bucketIndex) {
+   if (bucketIndex < HISTOGRAM_SUB_BUCKET_COUNT) {
+      return bucketIndex;
+   }
+   
+   int shift = bucketIndex / HISTOGRAM_SUB_BUCKET_COUNT - 1;
+   uint64_t lowestValue = (HISTOGRAM_SUB_BUCKET_COUNT + bucketIndex % HISTOGRAM_SUB_BUCKET_COUNT) << shift;
+   return lowestValue + ((1ULL << shift) - 1);
+}
+
+// Histogram class constructor.
+Histogram::Histogram() {
+   theTotalCount = 0;
+}
+
+// Adds one value.
+void Histogram::recordValue(uint64_t value) {
+   unsigned int bucketIndex = determineBucketIndex(value);
+   if (bucketIndex >= theCounts.size()) {
+      theCounts.resize(bucketIndex + 1, 0);
+   }
+   theCounts[bucketIndex]++;
+   theTotalCount++;
+}
+
+// Sizes the counts up to the bucket of highestValue, so that recording values up to it never allocates. Within the 
+// capacity the counts already had (a histogram reset by assignment keeps it), nothing is allocated here either.
+void Histogram::reserveValues(uint64_t highestValue) {
+   unsigned int bucketCount = determineBucketIndex(highestValue) + 1;
+   if (bucketCount > theCounts.size()) {
+      theCounts.resize(bucketCount, 0);
+   }
+}
+
+// Returns the count of buckets that hold the values up to highestValue.
+unsigned int Histogram::determineBucketCount(uint64_t highestValue) {
+   return determineBucketIndex(highestValue) + 1;
+}
+
+// Adds the counts of otherHistogram.
+void Histogram::merge(Histogram& otherHistogram) {
+   if (otherHistogram.theCounts.size() > theCounts.size()) {
+      theCounts.resize(otherHistogram.theCounts.size(), 0);
+   }
+   for (unsigned int bucketIndex = 0; bucketIndex < otherHistogram.theCounts.size(); bucketIndex++) {
+      theCounts[bucketIndex] += otherHistogram.theCounts[bucketIndex];
+   }
+   theTotalCount += otherHistogram.theTotalCount;
+}
+
+// Getter for theTotalCount.
+uint64_t Histogram::getTotalCount() {
+   return theTotalCount;
+}
+
+// Returns the value below or at which a fraction quantile of the values fall: the highest value of the bucket holding 
+// the value of rank ceil(quantile * count).
+uint64_t Histogram::getValueAtQuantile(double quantile) {
+   if (0 == theTotalCount) {
+      return 0;
+   }
+   
+   double rank = ceil(quantile * static_cast<double>(theTotalCount));
+   uint64_t targetCount = rank < 1 ? 1 : static_cast<uint64_t>(rank);
+   uint64_t cumulativeCount = 0;
+   for (unsigned int bucketIndex = 0; bucketIndex < theCounts.size(); bucketIndex++) {
+      cumulativeCount += theCounts[bucketIndex];
+      if (cumulativeCount >= targetCount) {
+         return determineBucketHighestValue(bucketIndex);
+      }
+   }
+   return determineBucketHighestValue(theCounts.size() - 1);
+}
+
+// Appends the counts to state, for a checkpoint.
+void Histogram::saveState(StateBuffer& state) {
+   state.appendVector(theCounts);
+   state.appendValue(theTotalCount);
+}
+
+// Reads back counts saved by saveState(). Returns false if state is too short.
+bool Histogram::restoreState(StateBuffer& state) {
+   return state.readVector(theCounts) && state.readValue(theTotalCount);
+}
@@ -0,0 +1,65 @@
+/*
+ * Declaration of the Histogram class. A log-bucketed (HDR-style) histogram of unsigned 64-bit values, used to keep the 
+ * distribution of the message delays and retransmission counts without storing every sample.
+ *
+ * Values below 2 * HISTOGRAM_SUB_BUCKET_COUNT each have their own bucket. Above that, every power of two is split into 
+ * HISTOGRAM_SUB_BUCKET_COUNT linear buckets, so a value is known to within 1/HISTOGRAM_SUB_BUCKET_COUNT of itself. A 
+ * value's bucket is found from its leading bit in O(1), and the counts are only grown up to the highest bucket yet 
+ * recorded, so a node whose frames wait a few dozen time slots holds a few dozen counters, unless reserveValues() 
+ * sized them ahead so that recording never allocates. Histograms merge by adding their counts, which is how the 
+ * replications (from any thread) are aggregated.
+ */
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "statebuffer.h"
+
+// Bits of the linear buckets per power of two, and their count.
+static const int HISTOGRAM_SUB_BUCKET_BITS = 5;
+static const uint64_t HISTOGRAM_SUB_BUCKET_COUNT = 1ULL << HISTOGRAM_SUB_BUCKET_BITS;
+
+class Histogram {
+   public:
+      // Overwrite the default constructor.
+      Histogram();
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Adds one value.
+      void recordValue(uint64_t value);
+      
+      // Sizes the counts up to the bucket of highestValue, so that recording values up to it never allocates.
+      void reserveValues(uint64_t highestValue);
+      
+      // Returns the count of buckets that hold the values up to highestValue.
+      static unsigned int determineBucketCount(uint64_t highestValue);
+      
+      // Adds the counts of otherHistogram.
+      void merge(Histogram& otherHistogram);
+      
+      // Getter for theTotalCount.
+      uint64_t getTotalCount();
+      
+      // Returns the value below or at which a fraction quantile of the values fall, as the highest value of its 
+      // bucket. 0 if the histogram is empty.
+      uint64_t getValueAtQuantile(double quantile);
+      
+      // Appends the counts to state, for a checkpoint.
+      void saveState(StateBuffer& state);
+      
+      // Reads back counts saved by saveState(). Returns false if state is too short.
+      bool restoreState(StateBuffer& state);
+   
+   private:
+      // Count of values recorded in each bucket. Grown on demand up to the highest bucket recorded.
+      std::vector<uint64_t> theCounts;
+      
+      // Count of values recorded.
+      uint64_t theTotalCount;
+};
+
+#endif   // __HISTOGRAM_H__
@@ -0,0 +1,474 @@
+/*
+ * Implementation of the LaneEngine class. Runs LANE_COUNT replications of the same configuration side by side, one 
+ * per lane of a vector register.
+ */
+
+#include <algorithm>    // std::min, std::min_element
+#include <climits>      // LONG_MAX
+#include <cstring>      // memcpy
+#include <immintrin.h>
+
+#include "laneengine.h"
+#include "profiler.h"
+#include "protocol.h"
+
+// Scans the next event times of nodeCount nodes, LANE_COUNT lanes each: sets bit l of dueMasks[i] if node i of lane l 
+// is due at currentTime, and returns the earliest of the other times.
+typedef long (*LaneScanKernel)(const long* times, int nodeCount, long currentTime, uint8_t* dueMasks);
+
+// Helper function that scans the lanes one at a time, on CPUs without AVX2.
+static long scanLanesScalar(const long* times, int nodeCount, long currentTime, uint8_t* dueMasks) {
+   long earliestTime = LONG_MAX;
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      const long* nodeTimes = times + static_cast<size_t>(nodeIndex) * LANE_COUNT;
+      uint8_t dueMask = 0;
+      for (int lane = 0; lane < LANE_COUNT; lane++) {
+         dueMask |= static_cast<uint8_t>(currentTime == nodeTimes[lane]) << lane;
+         earliestTime = std::min(earliestTime, currentTime == nodeTimes[lane] ? LONG_MAX : nodeTimes[lane]);
+      }
+      dueMasks[nodeIndex] = dueMask;
+   }
+   return earliestTime;
+}
+
+// Helper function that scans the lanes of a node in two 4-wide AVX2 compares. AVX2 has no 64-bit minimum, so the 
+// earliest time is kept with a compare and blend. The due lanes are raised to LONG_MAX first (the times are never 
+// negative, so or-ing in the compare result shifted right by one does it) so that they drop out of the minimum.
+__attribute__((target("avx2")))
+static long scanLanesAvx2(const long* times, int nodeCount, long currentTime, uint8_t* dueMasks) {
+   const __m256i current = _mm256_set1_epi64x(currentTime);
+   __m256i earliest = _mm256_set1_epi64x(LONG_MAX);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      const __m256i* nodeTimes = reinterpret_cast<const __m256i*>(times + static_cast<size_t>(nodeIndex) * LANE_COUNT);
+      __m256i low = _mm256_loadu_si256(nodeTimes);
+      __m256i high = _mm256_loadu_si256(nodeTimes + 1);
+      __m256i lowDue = _mm256_cmpeq_epi64(low, current);
+      __m256i highDue = _mm256_cmpeq_epi64(high, current);
+      dueMasks[nodeIndex] = static_cast<uint8_t>(_mm256_movemask_pd(_mm256_castsi256_pd(lowDue))
+                                               | (_mm256_movemask_pd(_mm256_castsi256_pd(highDue)) << 4));
+      
+      low = _mm256_or_si256(low, _mm256_srli_epi64(lowDue, 1));
+      high = _mm256_or_si256(high, _mm256_srli_epi64(highDue, 1));
+      earliest = _mm256_blendv_epi8(earliest, low, _mm256_cmpgt_epi64(earliest, low));
+      earliest = _mm256_blendv_epi8(earliest, high, _mm256_cmpgt_epi64(earliest, high));
+   }
+   
+   long earliestTimes[4];
+   _mm256_storeu_si256(reinterpret_cast<__m256i*>(earliestTimes), earliest);
+   return std::min(std::min(earliestTimes[0], earliestTimes[1]), std::min(earliestTimes[2], earliestTimes[3]));
+}
+
+// Helper function that scans the lanes of a node in one 8-wide AVX-512 compare, keeping the earliest time with a 
+// masked minimum. The lanes of the minimum are folded in scalar code at the end: GCC 12 flags the placeholder operands 
+// of its own _mm512_reduce_min_epi64() as uninitialized.
+__attribute__((target("avx512f")))
+static long scanLanesAvx512(const long* times, int nodeCount, long currentTime, uint8_t* dueMasks) {
+   const __m512i current = _mm512_set1_epi64(currentTime);
+   __m512i earliest = _mm512_set1_epi64(LONG_MAX);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      __m512i nodeTimes = _mm512_loadu_si512(times + static_cast<size_t>(nodeIndex) * LANE_COUNT);
+      __mmask8 dueMask = _mm512_cmpeq_epi64_mask(nodeTimes, current);
+      dueMasks[nodeIndex] = dueMask;
+      earliest = _mm512_mask_min_epi64(earliest, static_cast<__mmask8>(~dueMask), earliest, nodeTimes);
+   }
+   
+   long earliestTimes[LANE_COUNT];
+   _mm512_storeu_si512(earliestTimes, earliest);
+   return *std::min_element(earliestTimes, earliestTimes + LANE_COUNT);
+}
+
+// Scan kernel picked for this CPU, resolved on first use.
+struct LaneScan {
+   LaneScanKernel kernel;
+   const char* name;
+};
+
+// Returns the scan kernel for the widest instruction set the CPU supports.
+static LaneScan determineLaneScan() {
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f")) {
+      return LaneScan{ scanLanesAvx512, "AVX-512" };
+   }
+   else if (__builtin_cpu_supports("avx2")) {
+      return LaneScan{ scanLanesAvx2, "AVX2" };
+   }
+   return LaneScan{ scanLanesScalar, "scalar" };
+}
+
+// Returns the scan kernel of this CPU. Determined once; thread-safe as a function-local static.
+static const LaneScan& selectLaneScan() {
+   static const LaneScan selected = determineLaneScan();
+   return selected;
+}
+
+// LaneEngine class constructor with args.
+LaneEngine::LaneEngine(Configuration* configObj) {
+   theConfigObj = configObj;
+   theNodeCount = configObj->getNodeCount();
+   theChannelCount = configObj->getChannelCount();
+   theFrameLength = configObj->getFrameLength();
+   theCollisionLength = 1;
+   if (CSMA_CD == configObj->getCsmaType()) {
+      theCollisionLength = 2;
+   }
+   else if (CSMA_CA == configObj->getCsmaType() || FRAME_COLLISIONS == configObj->getCollisionModel()) {
+      theCollisionLength = theFrameLength;
+   }
+   theMessageBufferDepth = configObj->getMessageBufferDepth();
+   theMaxBackoffRetransmitCount = configObj->getMaxBackoffRetransmitCount();
+   theTimeSlotCount = configObj->getTimeSlotCount();
+   theProbFrameGeneration = configObj->getProbFrameGeneration();
+   theFrameGenerationThreshold = configObj->getFrameGenerationThreshold();
+   thePersistenceThreshold = configObj->getPersistenceThreshold();
+   theArrivalModel = configObj->getArrivalModel();
+   theChannelSelection = configObj->getChannelSelection();
+   theSeed = 0;
+   theFirstSimIndex = 0;
+   
+   // Resolve the protocol once instead of in every time slot.
+   switch (configObj->getCsmaType()) {
+      case NON_PERSISTENT:
+         theLaneProcessor = &LaneEngine::processLane<NON_PERSISTENT>;
+         break;
+      case ONE_PERSISTENT:
+         theLaneProcessor = &LaneEngine::processLane<ONE_PERSISTENT>;
+         break;
+      case P_PERSISTENT:
+         theLaneProcessor = &LaneEngine::processLane<P_PERSISTENT>;
+         break;
+      case CSMA_CD:
+         theLaneProcessor = &LaneEngine::processLane<CSMA_CD>;
+         break;
+      case CSMA_CA:
+         theLaneProcessor = &LaneEngine::processLane<CSMA_CA>;
+         break;
+   }
+   
+   // The due masks are padded to whole words of 8 nodes, so that they can be skipped a word at a time.
+   theDueMasks.assign((theNodeCount + 7) / 8 * 8, 0);
+   for (int lane = 0; lane < LANE_COUNT; lane++) {
+      theDueNodes[lane].reserve(theNodeCount);
+   }
+   theTransmittingNodes.reserve(theNodeCount);
+}
+
+// Runs the replications [firstSimIndex, firstSimIndex + laneCount) of the run keyed by seed, and moves the node and 
+// channel metrics of each into nodeMetrics[lane] and channelMetrics[lane]. Each time slot visited is the earliest in 
+// which a node of any lane is due; the lanes with nothing due in it are not touched.
+void LaneEngine::runReplications(unsigned int firstSimIndex, int laneCount, uint64_t seed, 
+                                 std::vector<Metric>* nodeMetrics, std::vector<Metric>* channelMetrics) {
+   start(firstSimIndex, laneCount, seed);
+   
+   LaneScanKernel scanLanes = selectLaneScan().kernel;
+   long currentTime = *std::min_element(theNextEventTimes.begin(), theNextEventTimes.end());
+   while (currentTime < theTimeSlotCount) {
+      // Find the lanes due at each node, and the earliest time slot after this one.
+      profilePhase(PHASE_SCHEDULING);
+      long nextTime = scanLanes(&theNextEventTimes[0], theNodeCount, currentTime, &theDueMasks[0]);
+      
+      // Sort the due nodes by lane, skipping 8 nodes at a time while none is due.
+      for (int lane = 0; lane < LANE_COUNT; lane++) {
+         theDueNodes[lane].clear();
+      }
+      for (int nodeIndex = 0; nodeIndex < theNodeCount; nodeIndex += 8) {
+         uint64_t dueWord;
+         memcpy(&dueWord, &theDueMasks[nodeIndex], sizeof(dueWord));
+         if (0 == dueWord) {
+            continue;
+         }
+         for (int offset = 0; offset < 8 && nodeIndex + offset < theNodeCount; offset++) {
+            for (unsigned int dueMask = theDueMasks[nodeIndex + offset]; 0 != dueMask; dueMask &= dueMask - 1) {
+               theDueNodes[__builtin_ctz(dueMask)].push_back(nodeIndex + offset);
+            }
+         }
+      }
+      
+      // Step each lane with its own replication's draws.
+      for (int lane = 0; lane < LANE_COUNT; lane++) {
+         if (!theDueNodes[lane].empty()) {
+            seedRandomGenerator(theSeed, theFirstSimIndex + lane);
+            nextTime = std::min(nextTime, (this->*theLaneProcessor)(lane, currentTime));
+         }
+      }
+      profileSlotEnd();
+      currentTime = nextTime;
+   }
+   
+   // Every time slot that a node did not spend transmitting was spent idle (waiting or backed-off).
+   for (int lane = 0; lane < laneCount; lane++) {
+      nodeMetrics[lane].resize(theNodeCount);
+      for (int nodeIndex = 0; nodeIndex < theNodeCount; nodeIndex++) {
+         int index = nodeIndex * LANE_COUNT + lane;
+         theMetrics[index].setClockCyclesTransmitting(theTransmittingSlots[index]);
+         theMetrics[index].setClockCyclesIdle(theTimeSlotCount - theTransmittingSlots[index]);
+         std::swap(nodeMetrics[lane][nodeIndex], theMetrics[index]);
+      }
+      
+      channelMetrics[lane].assign(theChannelCount, Metric());
+      for (int channelIndex = 0; channelIndex < theChannelCount; channelIndex++) {
+         theChannels[lane * theChannelCount + channelIndex].collectMetric(channelMetrics[lane][channelIndex], 
+                                                                          theTimeSlotCount);
+      }
+   }
+}
+
+// Returns the name of the instruction set used to scan the lanes.
+const char* LaneEngine::getScanInstructionSet() {
+   return selectLaneScan().name;
+}
+
+// Prepares the lanes for replications [firstSimIndex, firstSimIndex + laneCount), drawing their first frame arrivals 
+// with each lane's generator. The lanes past laneCount never have an event, so they are never due.
+void LaneEngine::start(unsigned int firstSimIndex, int laneCount, uint64_t seed) {
+   theSeed = seed;
+   theFirstSimIndex = firstSimIndex;
+   
+   // Reset the state left over from the previous replications.
+   size_t laneNodeCount = static_cast<size_t>(theNodeCount) * LANE_COUNT;
+   theNextEventTimes.assign(laneNodeCount, theTimeSlotCount);
+   theStates.assign(laneNodeCount, IDLE);
+   theTimesOfTransmitCompletion.assign(laneNodeCount, -1);
+   theNextAttemptedTransmitTimes.assign(laneNodeCount, -1);
+   theNextArrivalTimes.assign(laneNodeCount, theTimeSlotCount);
+   theRetransmitAttempts.assign(laneNodeCount, 0);
+   theBackoffIdleSlotCounts.assign(laneNodeCount, 0);
+   theChannelIndexes.resize(laneNodeCount);
+   theMessageTimesOfCreation.assign(laneNodeCount * theMessageBufferDepth, 0);
+   theMessageHeads.assign(laneNodeCount, 0);
+   theMessageCounts.assign(laneNodeCount, 0);
+   theTransmittingSlots.assign(laneNodeCount, 0);
+   theMetrics.assign(laneNodeCount, Metric());
+   theChannels.assign(static_cast<size_t>(theChannelCount) * LANE_COUNT, Channel());
+   for (size_t index = 0; index < laneNodeCount; index++) {
+      theChannelIndexes[index] = (index / LANE_COUNT) % theChannelCount;
+   }
+   
+   // Every node starts idle, so its first event is its first frame arrival.
+   for (int lane = 0; lane < laneCount; lane++) {
+      seedRandomGenerator(seed, firstSimIndex + lane);
+      for (int nodeIndex = 0; nodeIndex < theNodeCount; nodeIndex++) {
+         int index = nodeIndex * LANE_COUNT + lane;
+         scheduleNextArrival(nodeIndex, index, -1);
+         theNextEventTimes[index] = theNextArrivalTimes[index];
+      }
+   }
+}
+
+// Runs the completion, generation, contention and collision phases of the event engine for the nodes of lane that are 
+// due in currentTime, for the protocol csmaType; the protocol branches fold away in each instantiation. The decisions 
+// are those of the policies in protocol.h, on the lane-interleaved state. Returns the earliest time any of the due 
+// nodes is due next.
+template <CSMA_TYPE csmaType>
+long LaneEngine::processLane(int lane, long currentTime) {
+   std::vector<int>& dueNodes = theDueNodes[lane];
+   
+   // Check if any due node has completed its transmission.
+   profilePhase(PHASE_COMPLETION);
+   for (std::vector<int>::iterator it = dueNodes.begin(); it != dueNodes.end(); it++) {
+      int index = *it * LANE_COUNT + lane;
+      if (TRANSMITTING != theStates[index] || currentTime != theTimesOfTransmitCompletion[index]) {
+         continue;
+      }
+      
+      theStates[index] = IDLE;
+      theTimesOfTransmitCompletion[index] = -1;
+      getNodeChannel(lane, index).completeTransmit();
+      
+      // Update the metric, then remove the message that was sent.
+      Metric& nodeMetric = theMetrics[index];
+      size_t ringStart = static_cast<size_t>(index) * theMessageBufferDepth;
+      uint64_t timeMessageWaited = currentTime - theMessageTimesOfCreation[ringStart + theMessageHeads[index]];
+      nodeMetric.incrementCountOfMessagesTransmitted();
+      nodeMetric.updateTimeMessagesWaited(timeMessageWaited);
+      nodeMetric.updateMessageDelayHistogram(timeMessageWaited);
+      nodeMetric.updateRetransmissionHistogram(theRetransmitAttempts[index]);
+      theRetransmitAttempts[index] = 0;
+      if (++theMessageHeads[index] == theMessageBufferDepth) {
+         theMessageHeads[index] = 0;
+      }
+      theMessageCounts[index]--;
+   }
+   
+   // Check if any due node generates a message. A full buffer drops its newest message.
+   profilePhase(PHASE_GENERATION);
+   for (std::vector<int>::iterator it = dueNodes.begin(); it != dueNodes.end(); it++) {
+      int index = *it * LANE_COUNT + lane;
+      if (currentTime != theNextArrivalTimes[index]) {
+         continue;
+      }
+      
+      if (theMessageBufferDepth == theMessageCounts[index]) {
+         theMessageCounts[index]--;
+         theMetrics[index].incrementCountOfMessagesDropped();
+      }
+      int slot = theMessageHeads[index] + theMessageCounts[index];
+      if (slot >= theMessageBufferDepth) {
+         slot -= theMessageBufferDepth;
+      }
+      theMessageTimesOfCreation[static_cast<size_t>(index) * theMessageBufferDepth + slot] = currentTime;
+      theMessageCounts[index]++;
+      theMetrics[index].incrementCountOfMessagesGenerated();
+      
+      scheduleNextArrival(*it, index, currentTime);
+   }
+   
+   // Check if any due node will attempt to transmit.
+   profilePhase(PHASE_CONTENTION);
+   theTransmittingNodes.clear();
+   for (std::vector<int>::iterator it = dueNodes.begin(); it != dueNodes.end(); it++) {
+      int index = *it * LANE_COUNT + lane;
+      uint8_t state = theStates[index];
+      if (TRANSMITTING == state) {
+         // Visited for a frame arrival while transmitting; nothing else to do.
+         continue;
+      }
+      else if (BACKED_OFF == state && currentTime != theNextAttemptedTransmitTimes[index]) {
+         // Visited for a frame arrival while backed-off; the back-off continues.
+         continue;
+      }
+      else if (BACKED_OFF == state && CSMA_CA == csmaType) {
+         // The CSMA/CA back-off was pushed out by a busy medium; visit the node at its new time.
+         Channel& channel = getNodeChannel(lane, index);
+         if (channel.countIdleSlots(currentTime) < theBackoffIdleSlotCounts[index]) {
+            theNextAttemptedTransmitTimes[index] = channel.predictIdleSlotTime(theBackoffIdleSlotCounts[index], 
+                                                                               currentTime);
+            continue;
+         }
+      }
+      else if (BACKED_OFF != state && 0 == theMessageCounts[index]) {
+         // Idle node with nothing to send.
+         continue;
+      }
+      
+      // An idle node contends for its frame on the channel selected for it now.
+      if (BACKED_OFF != state && RANDOM_CHANNELS == theChannelSelection) {
+         theChannelIndexes[index] = generateRandomIntegerMinToMax(0, theChannelCount - 1, 
+                                                                  RNG_CHANNEL, *it, currentTime);
+      }
+      if (getNodeChannel(lane, index).isIdle(currentTime)) {
+         // The node transmits here if the medium is idle, unless p-persistence defers it to the next time slot.
+         if (P_PERSISTENT == csmaType
+          && !generateBernoulliTrial(thePersistenceThreshold, RNG_PERSISTENCE, *it, currentTime)) {
+            backoffNode(index, currentTime + 1);
+         }
+         else {
+            theTransmittingNodes.push_back(*it);
+         }
+      }
+      else {
+         // Medium is not idle. Determine the duration of the back-off.
+         if (NON_PERSISTENT == csmaType) {
+            backoffNode(index, determineEndOfBinaryExpBackoff(*it, index, currentTime));
+         }
+         else if (CSMA_CA == csmaType) {
+            backoffNode(index, startIdleSlotBackoff(*it, index, currentTime));
+         }
+         else {
+            backoffNode(index, currentTime + 1);
+         }
+         theMetrics[index].incrementCountOfTransmissionAttempts();
+      }
+   }
+   
+   // Determine, channel by channel, if a node can transmit or if a collision occurred.
+   profilePhase(PHASE_RESOLUTION);
+   for (std::vector<int>::iterator it = theTransmittingNodes.begin(); it != theTransmittingNodes.end(); it++) {
+      getNodeChannel(lane, *it * LANE_COUNT + lane).addContender();
+   }
+   for (std::vector<int>::iterator it = theTransmittingNodes.begin(); it != theTransmittingNodes.end(); it++) {
+      int index = *it * LANE_COUNT + lane;
+      Channel& channel = getNodeChannel(lane, index);
+      if (1 == channel.getContenderCount()) {
+         // Alone on its channel. The whole frame is accounted for now, cut short by the end of the simulation.
+         channel.clearContenders();
+         long completionTime = currentTime + theFrameLength;
+         theStates[index] = TRANSMITTING;
+         theTimesOfTransmitCompletion[index] = completionTime;
+         theNextAttemptedTransmitTimes[index] = -1;
+         channel.startTransmit(currentTime, completionTime);
+         theTransmittingSlots[index] += std::min(completionTime, theTimeSlotCount) - currentTime;
+         theMetrics[index].incrementCountOfTransmissionAttempts();
+      }
+      else {
+         // The collision is started by the first of the colliding nodes, which clears the channel's contenders.
+         if (0 < channel.getContenderCount()) {
+            channel.startCollision(currentTime, currentTime + theCollisionLength);
+         }
+         
+         // The binary exponential back-off starts once the collision is over.
+         if (CSMA_CA == csmaType) {
+            backoffNode(index, startIdleSlotBackoff(*it, index, currentTime));
+         }
+         else {
+            backoffNode(index, determineEndOfBinaryExpBackoff(*it, index, currentTime) + theCollisionLength - 1);
+         }
+         theMetrics[index].incrementCountOfCollisions();
+         theMetrics[index].incrementCountOfTransmissionAttempts();
+      }
+   }
+   
+   // Find when each due node must be visited next.
+   long earliestTime = LONG_MAX;
+   for (std::vector<int>::iterator it = dueNodes.begin(); it != dueNodes.end(); it++) {
+      int index = *it * LANE_COUNT + lane;
+      long eventTime = theNextArrivalTimes[index];
+      if (TRANSMITTING == theStates[index]) {
+         eventTime = std::min(eventTime, theTimesOfTransmitCompletion[index]);
+      }
+      else if (BACKED_OFF == theStates[index]) {
+         eventTime = std::min(eventTime, theNextAttemptedTransmitTimes[index]);
+      }
+      theNextEventTimes[index] = eventTime;
+      earliestTime = std::min(earliestTime, eventTime);
+   }
+   return earliestTime;
+}
+
+// Backs off the node at index until timeOfNextTransmitAttempt, counting a retransmit attempt.
+void LaneEngine::backoffNode(int index, long timeOfNextTransmitAttempt) {
+   theStates[index] = BACKED_OFF;
+   theNextAttemptedTransmitTimes[index] = timeOfNextTransmitAttempt;
+   int retransmitAttempts = ++theRetransmitAttempts[index];
+   if (theMetrics[index].getMaximumRetransmissionAttempts() < static_cast<unsigned int>(retransmitAttempts)) {
+      theMetrics[index].setMaximumRetransmissionAttempts(retransmitAttempts);
+   }
+}
+
+// Returns the end of the binary exponential back-off of nodeIndex (at index) drawn at currentTime, from a window of 
+// 2^min(max retransmits, retransmit attempts) time slots as Node::determineBackoffWindow().
+long LaneEngine::determineEndOfBinaryExpBackoff(int nodeIndex, int index, long currentTime) {
+   int power = std::min(std::min(theMaxBackoffRetransmitCount, theRetransmitAttempts[index]), 31);
+   return currentTime + generateRandomIntegerMinToMax(1, 1u << power, RNG_BACKOFF, nodeIndex, currentTime);
+}
+
+// Draws the CSMA/CA back-off of nodeIndex (at index) at currentTime in idle time slots, and returns the time it 
+// expires at if the medium stays idle (see CsmaCaPolicy::startIdleSlotBackoff()).
+long LaneEngine::startIdleSlotBackoff(int nodeIndex, int index, long currentTime) {
+   Channel& channel = getNodeChannel(index % LANE_COUNT, index);
+   int power = std::min(std::min(theMaxBackoffRetransmitCount, theRetransmitAttempts[index]), 31);
+   unsigned long window = std::min(CsmaCaPolicy::CSMA_CA_MIN_WINDOW * (1UL << power), 1UL << 31);
+   long idleSlotCount = channel.countIdleSlots(currentTime)
+                      + generateRandomIntegerMinToMax(1, window, RNG_BACKOFF, nodeIndex, currentTime);
+   theBackoffIdleSlotCounts[index] = idleSlotCount;
+   return channel.predictIdleSlotTime(idleSlotCount, currentTime);
+}
+
+// Finds the next frame arrival of nodeIndex (at index) strictly after afterTime, with the same draws as 
+// NodeStore::scheduleNextArrival().
+void LaneEngine::scheduleNextArrival(int nodeIndex, int index, long afterTime) {
+   theNextArrivalTimes[index] = theTimeSlotCount;
+   if (BERNOULLI_ARRIVALS == theArrivalModel) {
+      for (long time = afterTime + 1; 0 != theFrameGenerationThreshold && time < theTimeSlotCount; time++) {
+         if (generateBernoulliTrial(theFrameGenerationThreshold, RNG_ARRIVAL, nodeIndex, time)) {
+            theNextArrivalTimes[index] = time;
+            break;
+         }
+      }
+      return;
+   }
+   
+   unsigned long interval = generateGeometricInterval(theProbFrameGeneration, RNG_ARRIVAL, nodeIndex, afterTime + 1);
+   if (0 != interval && interval < static_cast<unsigned long>(theTimeSlotCount - afterTime)) {
+      theNextArrivalTimes[index] = afterTime + interval;
+   }
+}
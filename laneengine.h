@@ -0,0 +1,155 @@
+/*
+ * Declaration of the LaneEngine class. Runs LANE_COUNT replications of the same configuration side by side, one per 
+ * lane of a vector register, instead of one after the other. The replications differ only in their random draws, so 
+ * their per-node state is kept lane-interleaved (node i of lane l at i * LANE_COUNT + l) and the question asked of 
+ * every node in every time slot, "is anything due now?", is answered for all the lanes of a node with one vector 
+ * compare of its next event times. The same pass finds the earliest time anything is due in any lane, so, like the 
+ * event engine, the time slots in which nothing happens are skipped.
+ *
+ * The nodes that are due are then stepped lane by lane, with the calling thread's generator keyed to each lane's 
+ * replication in turn. Their phases (completion, generation, contention and resolution) are those of the event engine, 
+ * and every draw is keyed by the replication, node, purpose and time slot, so each lane's metrics are exactly those 
+ * of the same replication on the slot or event engine.
+ *
+ * The per-event work stays scalar: once a node is due its lanes take different branches. The engine wins where the 
+ * per-slot scan dominates, which is the many short replications of small collision domains that rare-event studies 
+ * run; ENGINE=event remains the better choice for one long replication of many nodes. It writes no verbose log or 
+ * event trace, and is limited to the full topology, without checkpoints or sweeps.
+ */
+
+#ifndef __LANEENGINE_H__
+#define __LANEENGINE_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "helpers.h"
+#include "channel.h"
+
+// Count of replications stepped together: 8 time slots of 64 bits fill one AVX-512 register (or two AVX2 registers).
+static const int LANE_COUNT = 8;
+
+class LaneEngine {
+   public:
+      // Constructor with args. Sizes every buffer for the configured node count and channel count.
+      LaneEngine(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Runs the replications [firstSimIndex, firstSimIndex + laneCount) of the run keyed by seed, laneCount at most 
+      // LANE_COUNT, and moves the node and channel metrics of each into nodeMetrics[lane] and channelMetrics[lane].
+      void runReplications(unsigned int firstSimIndex, int laneCount, uint64_t seed, 
+                           std::vector<Metric>* nodeMetrics, std::vector<Metric>* channelMetrics);
+      
+      // Returns the name of the instruction set used to scan the lanes.
+      static const char* getScanInstructionSet();
+   
+   private:
+      // Prepares the lanes for replications [firstSimIndex, firstSimIndex + laneCount), drawing their first frame 
+      // arrivals. The lanes past laneCount are left with nothing to do.
+      void start(unsigned int firstSimIndex, int laneCount, uint64_t seed);
+      
+      // Runs the completion, generation, contention and collision phases of the event engine for the nodes of lane 
+      // that are due in currentTime, for the protocol csmaType. Returns the earliest time any of them is due next.
+      template <CSMA_TYPE csmaType>
+      long processLane(int lane, long currentTime);
+      
+      // Backs off node (at index of the lane-interleaved arrays) until timeOfNextTransmitAttempt.
+      void backoffNode(int index, long timeOfNextTransmitAttempt);
+      
+      // Returns the end of the binary exponential back-off of node (at index) drawn at currentTime.
+      long determineEndOfBinaryExpBackoff(int node, int index, long currentTime);
+      
+      // Draws the CSMA/CA back-off of node (at index) at currentTime in idle time slots, and returns the time it 
+      // expires at if the medium stays idle.
+      long startIdleSlotBackoff(int node, int index, long currentTime);
+      
+      // Finds the next frame arrival of node (at index) strictly after afterTime, as NodeStore::scheduleNextArrival().
+      void scheduleNextArrival(int node, int index, long afterTime);
+      
+      // Returns the channel that the node at index of lane senses and transmits on.
+      Channel& getNodeChannel(int lane, int index) {
+         return theChannels[lane * theChannelCount + theChannelIndexes[index]];
+      }
+      
+      // Configuration shared (read-only) by every replication.
+      Configuration* theConfigObj;
+      
+      // processLane() for the configured protocol, selected once.
+      long (LaneEngine::*theLaneProcessor)(int lane, long currentTime);
+      
+      // Sizes and parameters of the configuration, read once.
+      int theNodeCount;
+      int theChannelCount;
+      int theFrameLength;
+      int theCollisionLength;
+      int theMessageBufferDepth;
+      int theMaxBackoffRetransmitCount;
+      long theTimeSlotCount;
+      float theProbFrameGeneration;
+      uint64_t theFrameGenerationThreshold;
+      uint64_t thePersistenceThreshold;
+      ARRIVAL_MODEL theArrivalModel;
+      CHANNEL_SELECTION theChannelSelection;
+      
+      // Seed of the run and replication of lane 0.
+      uint64_t theSeed;
+      unsigned int theFirstSimIndex;
+      
+      /*
+       * PER-NODE STATE, LANE-INTERLEAVED (node i of lane l at i * LANE_COUNT + l)
+       */
+      // Earliest time slot in which the node must be visited: its next frame arrival, or the completion of its 
+      // transmit or the end of its back-off if sooner. theTimeSlotCount when nothing is due.
+      std::vector<long> theNextEventTimes;
+      
+      // State of the node.
+      std::vector<uint8_t> theStates;
+      
+      // Time of completion for the current transmit, -1 when no transmit is in progress.
+      std::vector<long> theTimesOfTransmitCompletion;
+      
+      // Time of the next scheduled transmission attempt, -1 when none is scheduled.
+      std::vector<long> theNextAttemptedTransmitTimes;
+      
+      // Time of the next frame arrival, theTimeSlotCount when none is due within the simulation.
+      std::vector<long> theNextArrivalTimes;
+      
+      // Count of consecutive retransmission attempts.
+      std::vector<int> theRetransmitAttempts;
+      
+      // Idle-slot clock value at which the back-off expires, used by CSMA/CA only.
+      std::vector<long> theBackoffIdleSlotCounts;
+      
+      // Channel the node senses and transmits on.
+      std::vector<int> theChannelIndexes;
+      
+      // Creation times of the buffered messages, theMessageBufferDepth per node and lane, with the offset of the 
+      // oldest and the count of each ring.
+      std::vector<long> theMessageTimesOfCreation;
+      std::vector<int> theMessageHeads;
+      std::vector<int> theMessageCounts;
+      
+      // Count of time slots spent transmitting, accumulated as whole frames when each transmit starts.
+      std::vector<unsigned long> theTransmittingSlots;
+      
+      // Metric of the node.
+      std::vector<Metric> theMetrics;
+      
+      /*
+       * PER-LANE STATE
+       */
+      // Channels of each lane, theChannelCount per lane.
+      std::vector<Channel> theChannels;
+      
+      // Bit l set for each lane l due in the current time slot, per node.
+      std::vector<uint8_t> theDueMasks;
+      
+      // Nodes of each lane due in the current time slot, in ascending order.
+      std::vector<int> theDueNodes[LANE_COUNT];
+      
+      // Scratch list of nodes that intend to transmit in the current time slot.
+      std::vector<int> theTransmittingNodes;
+};
+
+#endif   // __LANEENGINE_H__
@@ -4,25 +4,55 @@
  * to create the simulation of interest.
  */
 
-#include <ctime>
+#include <algorithm>    // std::max
+#include <cstdio>       // remove
+#include <fstream>
 
 #include "helpers.h"
-
-// Forward delcare of helper functions.
-void copyMetrics(Metric* nodeTotalMetrics[], std::vector<Node*> nodeVector);
-void printSimulationMetrics(std::vector<Node*> nodeVector, unsigned int simIndex);
-void printOverallMetrics(Metric* nodeTotalMetrics[], 
-                         Configuration* configObj);
+#include "analytic.h"
+#include "checkpoint.h"
+#include "profiler.h"
+#include "replication.h"
+#include "resultsink.h"
+#include "sweep.h"
 
 // Global that identifies the configuration INI file.
 std::string GLOBAL_CONFIG_INI("./csma_config.ini");
 
 int main(int argc, char* argv[]) {   
+   // An INI other than ./csma_config.ini may be given as an argument (e.g. csma_large_scale.ini). --profile times 
+   // the phases of every time slot and prints their breakdown after the metrics. --analytic solves a Markov-chain 
+   // model of the configuration instead of simulating it.
+   bool isProfileEnabled = false;
+   bool isAnalyticEnabled = false;
+   for (int argIndex = 1; argIndex < argc; argIndex++) {
+      if (std::string("--profile") == argv[argIndex]) {
+         isProfileEnabled = true;
+      }
+      else if (std::string("--analytic") == argv[argIndex]) {
+         isAnalyticEnabled = true;
+      }
+      else {
+         GLOBAL_CONFIG_INI = argv[argIndex];
+      }
+   }
+   
    // Retrieve configuration variables
    Configuration* configObj = new Configuration(GLOBAL_CONFIG_INI);
    
+   // With RESULT_FILE=- the machine-readable results take stdout, so the console output goes to stderr instead of 
+   // being mixed into them.
+   if (TEXT_RESULTS != configObj->getResultFormat() && "-" == configObj->getResultFile()) {
+      std::cout.rdbuf(std::cerr.rdbuf());
+      CLog::setOutput(stderr);
+   }
+   
    // Update the log level.
-   if (configObj->getVerboseEnabled()) {
+   if (configObj->getVerboseEnabled() && CLog::VERBOSE < CLog::COMPILED_LEVEL) {
+      std::cout << "Verbose logging is compiled out of this build; use csma_sim_debug (or TRACE_FILE)." << std::endl;
+      CLog::setLevel(CLog::METRICS);
+   }
+   else if (configObj->getVerboseEnabled()) {
       std::cout << "Enabling verbose logging." << std::endl;
       CLog::setLevel(CLog::ALL);
    }
@@ -31,226 +61,111 @@ int main(int argc, char* argv[]) {
       CLog::setLevel(CLog::METRICS);
    }
    
-   // Use an array metrics objects to track each node.
-   unsigned short nodeCount = configObj->getNodeCount();
-   Metric* nodeTotalMetrics[nodeCount];
-   for (unsigned short nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
-      Metric* metricObj = new Metric();
-      nodeTotalMetrics[nodeIndex] = metricObj;
+   // Show the seed so that the run can be reproduced.
+   std::cout << "Using SEED=" << configObj->getSeed() << std::endl;
+   
+   // Build the carrier-sense topology, if configured. Every replication shares it.
+   if (!configObj->buildTopology()) {
+      exit(-1);
+   }
+   if (configObj->isTopologyEnabled()) {
+      Topology& topology = configObj->getTopology();
+      std::cout << "Using a topology of " << topology.getNodeCount() << " nodes and " << topology.getLinkCount() 
+                << " links (mean degree " << 2.0 * topology.getLinkCount() / std::max(1, topology.getNodeCount()) 
+                << ", max " << topology.getMaxDegree() << ")" << std::endl;
    }
    
-   // For a clean simulation, all of the node objects will be recreated each time.
-   unsigned short simCount = configObj->getSimulationCount();
-   unsigned long timeSlots = configObj->getTimeSlotCount();
-   for (unsigned short simIndex = 0; simIndex < simCount; simIndex++) {
-      // Initialize the nodes and place into a vector.
-      std::vector<Node*> nodeVector;
-      for (unsigned short nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
-         Node* nodeObj = new Node(nodeIndex);
-         nodeVector.push_back(nodeObj);
-      }
-      
-      // Initialize random seed.
-      srand (time(NULL));
-      
-      // Show simulation count.
-      CLog::write(CLog::METRICS, "- simulation %u -\n", simIndex);
-      
-      // Loop through all of the time-slots.
-      for (unsigned int timeIndex = 0; timeIndex < timeSlots; timeIndex++) {
-         CLog::write(CLog::VERBOSE, "---- timeIndex: %u ----\n", timeIndex);
-         determineNodeStates(nodeVector, timeIndex, configObj);
-         CLog::write(CLog::VERBOSE, "\n", timeIndex);
+   // The analytic model answers for the configuration, or for every point of its sweep, without simulating it.
+   if (isAnalyticEnabled) {
+      bool isSolved = runAnalyticModel(configObj);
+      delete configObj;
+      return isSolved ? 0 : -1;
+   }
+   
+   // Checkpoints cover the replications of a single run; a sweep restarts its points instead.
+   if (configObj->isCheckpointEnabled() && configObj->isSweepEnabled()) {
+      std::cout << "ERROR - CHECKPOINT_FILE is not supported with SWEEP_ keys" << std::endl;
+      exit(-1);
+   }
+   
+   // The lane engine runs groups of whole replications of a single run, with every node hearing every other node.
+   if (LANE_ENGINE == configObj->getEngineType() 
+    && (configObj->isCheckpointEnabled() || configObj->isSweepEnabled() || configObj->isTopologyEnabled())) {
+      std::cout << "ERROR - ENGINE=lanes is not supported with CHECKPOINT_FILE, SWEEP_ keys or TOPOLOGY" << std::endl;
+      exit(-1);
+   }
+   
+   // Resume from the checkpoint when asked to and one was left behind; otherwise the run starts afresh.
+   Checkpoint* savedCheckpoint = NULL;
+   if (configObj->isCheckpointEnabled() && configObj->getResumeEnabled() 
+    && std::ifstream(configObj->getCheckpointFile().c_str()).good()) {
+      savedCheckpoint = new Checkpoint(configObj);
+      if (!savedCheckpoint->readFile(configObj->getCheckpointFile())) {
+         exit(-1);
       }
-      
-      // Report the metrics.
-      printSimulationMetrics(nodeVector, simIndex);
-      
-      // Copy over the metrics from this simulation.
-      copyMetrics(nodeTotalMetrics, nodeVector);
-      
-      // Cleanup node objects.
-      for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-         delete *it;
+      std::cout << "Resuming from " << configObj->getCheckpointFile() << std::endl;
+   }
+   
+   // Results go to the sink selected by RESULT_FORMAT.
+   ResultSink* resultSink = ResultSink::createResultSink(configObj, NULL != savedCheckpoint);
+   if (NULL == resultSink) {
+      exit(-1);
+   }
+   
+   // Start the binary event trace, if configured. Unlike verbose logging, it is written by a background thread.
+   if (!configObj->getTraceFile().empty()) {
+      if (!Tracer::start(configObj->getTraceFile(), configObj->getTraceNodes(), 
+                         configObj->getTraceFirstSlot(), configObj->getTraceLastSlot())) {
+         exit(-1);
       }
+      std::cout << "Tracing to " << configObj->getTraceFile() << std::endl;
    }
    
-   // Display the overall data.
-   printOverallMetrics(nodeTotalMetrics, configObj);
+   // Start the phase profiler, if asked for. Its report follows the metrics.
+   if (isProfileEnabled) {
+      std::cout << "Profiling the phases of each time slot." << std::endl;
+      Profiler::start();
+   }
    
-   // Cleanup overall Node metrics objects.
-   for (unsigned short nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
-      delete(nodeTotalMetrics[nodeIndex]);
+   // A sweep reports one aggregated row per point instead of the per-node reports.
+   if (configObj->isSweepEnabled()) {
+      SweepRunner sweepRunner(configObj, resultSink);
+      sweepRunner.run();
+      Tracer::stop();
+      Profiler::stop();
+      
+      // Cleanup result sink and config object.
+      delete resultSink;
+      delete configObj;
+      
+      return 0;
    }
    
-   // Cleanup config object.
-   delete configObj;
+   // Track each node's and each channel's totals in a metrics object. Kept on the heap, as the node count can be large.
+   std::vector<Metric> nodeTotalMetrics(configObj->getNodeCount());
+   std::vector<Metric> channelTotalMetrics(configObj->getChannelCount());
    
-   return 0;
-}
-
-
-//////////////////////////////////////////////////
-//             HELPER FUNCTIONS
-//////////////////////////////////////////////////
-
-
-// Helper function used to copy over the node data from one simulation.
-void copyMetrics(Metric* nodeTotalMetrics[], std::vector<Node*> nodeVector) {
-   for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-      // Save off copies of relevant data for ease of access.
-      int nodeIndex = (*it)->getInternalAddress();
-      Metric* nodeMetricCopy = (*it)->theNodeMetric;
-      
-      // Clock cycles idle.
-      unsigned int lastValue = nodeTotalMetrics[nodeIndex]->getClockCyclesIdle();
-      nodeTotalMetrics[nodeIndex]->setClockCyclesIdle(lastValue + nodeMetricCopy->getClockCyclesIdle());
-      
-      // Clock cycles transmitting.
-      lastValue = nodeTotalMetrics[nodeIndex]->getClockCyclesTransmitting();
-      nodeTotalMetrics[nodeIndex]->setClockCyclesTransmitting(lastValue 
-                                                              + nodeMetricCopy->getClockCyclesTransmitting());
-      
-      // Count of messages generated.
-      lastValue = nodeTotalMetrics[nodeIndex]->getCountOfMessagesGenerated();
-      nodeTotalMetrics[nodeIndex]->setCountOfMessagesGenerated(lastValue 
-                                                               + nodeMetricCopy->getCountOfMessagesGenerated());
-      
-      // Count of transmission attempts.
-      lastValue = nodeTotalMetrics[nodeIndex]->getCountOfTransmissionAttempts();
-      nodeTotalMetrics[nodeIndex]->setCountOfTransmissionAttempts(lastValue 
-                                                                  + nodeMetricCopy->getCountOfTransmissionAttempts());
-      
-      // Count of collisions.
-      lastValue = nodeTotalMetrics[nodeIndex]->getCountOfCollisions();
-      nodeTotalMetrics[nodeIndex]->setCountOfCollisions(lastValue 
-                                                        + nodeMetricCopy->getCountOfCollisions());
-      
-      // Count of messages dropped.
-      lastValue = nodeTotalMetrics[nodeIndex]->getCountOfMessagesDropped();
-      nodeTotalMetrics[nodeIndex]->setCountOfMessagesDropped(lastValue 
-                                                             + nodeMetricCopy->getCountOfMessagesDropped());
-      
-      // Count of messages transmitted.
-      lastValue = nodeTotalMetrics[nodeIndex]->getCountOfMessagesTransmitted();
-      nodeTotalMetrics[nodeIndex]->setCountOfMessagesTransmitted(lastValue 
-                                                                 + nodeMetricCopy->getCountOfMessagesTransmitted());
-      
-      // Time slots messages spent waiting to be transmitted (time of completion - time of creation).
-      nodeTotalMetrics[nodeIndex]->updateTimeMessagesWaited(nodeMetricCopy->getTimeMessagesWaited());
-      
-      // Maximum count of retransmission attempts.
-      lastValue = nodeTotalMetrics[nodeIndex]->getMaximumRetransmissionAttempts();
-      nodeTotalMetrics[nodeIndex]->setMaximumRetransmissionAttempts(lastValue 
-                                                                    + nodeMetricCopy->getMaximumRetransmissionAttempts());
+   // Run the replications, in parallel where configured. Every random draw is keyed to the seed and replication.
+   ReplicationRunner runner(configObj, nodeTotalMetrics, channelTotalMetrics, resultSink, savedCheckpoint);
+   runner.run();
+   Tracer::stop();
+   
+   // Display the overall data, averaged over the replications reduced (which the stopping rule may have cut short).
+   resultSink->writeAggregates(0, configObj, runner.getReducedCount(), nodeTotalMetrics, runner.getStoppingRule());
+   if (configObj->getChannelCount() > 1) {
+      resultSink->writeChannelAggregates(0, configObj, runner.getReducedCount(), channelTotalMetrics);
    }
-}
-
-// Helper function used to print the data from one simulation.
-void printSimulationMetrics(std::vector<Node*> nodeVector, unsigned int simIndex) {
-   CLog::write(CLog::METRICS, "[sim %d node metrics]\n", simIndex);
-   for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-      CLog::write(CLog::METRICS, 
-                 "   [node %d]\n", 
-                 (*it)->getInternalAddress());
-      CLog::write(CLog::METRICS, 
-                 "      time slots idle: %d\n", 
-                 (*it)->theNodeMetric->getClockCyclesIdle());
-      CLog::write(CLog::METRICS,
-                 "      time slots transmitting: %d\n", 
-                 (*it)->theNodeMetric->getClockCyclesTransmitting());
-      CLog::write(CLog::METRICS,
-                 "      messages generated: %d\n",
-                 (*it)->theNodeMetric->getCountOfMessagesGenerated());
-      CLog::write(CLog::METRICS,
-                 "      tranmissions attempted: %d\n",
-                 (*it)->theNodeMetric->getCountOfTransmissionAttempts());
-      CLog::write(CLog::METRICS,
-                 "      collisions occurred: %d\n", 
-                 (*it)->theNodeMetric->getCountOfCollisions());
-      CLog::write(CLog::METRICS,
-                 "      messages dropped: %d\n", 
-                 (*it)->theNodeMetric->getCountOfMessagesDropped());
-      CLog::write(CLog::METRICS,
-                 "      messages transmitted: %d\n",
-                 (*it)->theNodeMetric->getCountOfMessagesTransmitted());
-      CLog::write(CLog::METRICS,
-                 "      time slots messages spent waiting: %d\n",
-                 (*it)->theNodeMetric->getTimeMessagesWaited());
-      CLog::write(CLog::METRICS,
-                 "      maximum retransmission attempts: %d\n", 
-                 (*it)->theNodeMetric->getMaximumRetransmissionAttempts());
-      CLog::write(CLog::METRICS, "\n");
+   Profiler::stop();
+   delete resultSink;
+   
+   // The run is complete, so its checkpoint is of no further use.
+   if (configObj->isCheckpointEnabled()) {
+      remove(configObj->getCheckpointFile().c_str());
    }
-}
-
-// Helper functions used to print the overall metrics for the entire execution.
-void printOverallMetrics(Metric* nodeTotalMetrics[], Configuration* configObj) {
-   // Determine looping conditions.
-   unsigned short arraySize = configObj->getNodeCount();
-   unsigned long timeSlots = configObj->getTimeSlotCount();
-   unsigned short simCount = configObj->getSimulationCount();
+   delete savedCheckpoint;
    
-   CLog::write(CLog::METRICS, "[averages over %u simulations of %lu timeslots]\n", simCount, timeSlots); 
+   // Cleanup config object.
+   delete configObj;
    
-   // Loop through the nodes.
-   for (unsigned short nodeIndex = 0; nodeIndex < arraySize; nodeIndex++) {
-      CLog::write(CLog::METRICS, "   [node %d]\n", nodeIndex);
-                 
-      // Time slots idle.
-      float value = ((float )nodeTotalMetrics[nodeIndex]->getClockCyclesIdle()/(float )simCount);
-      CLog::write(CLog::METRICS, "     time slots idle: %.2f (%.4f of clock cycles)\n", 
-                                 value, 
-                                 (value/(float )timeSlots));
-      
-      // Time slots transmitting.
-      float avgMessagesTransmitted = ((float )nodeTotalMetrics[nodeIndex]->getClockCyclesTransmitting()/(float )simCount);
-      CLog::write(CLog::METRICS, "     time slots transmitting: %.2f (%.4f of clock cycles)\n", 
-                                 avgMessagesTransmitted, 
-                                 (avgMessagesTransmitted/(float )timeSlots));
-      
-      // Count of messages generated.
-      float avgMessagesGenerated = ((float )nodeTotalMetrics[nodeIndex]->getCountOfMessagesGenerated()/(float)simCount);
-      CLog::write(CLog::METRICS, "     messages generated: %.2f (%.4f of clock cycles)\n", 
-                                 avgMessagesGenerated, 
-                                 ((float )avgMessagesGenerated/(float )timeSlots));
-      
-      // Count of transmission attempts.
-      float avgTransmissionAttempts = ((float )nodeTotalMetrics[nodeIndex]->getCountOfTransmissionAttempts()/(float )simCount);
-      CLog::write(CLog::METRICS, "     transmission attempts: %.2f\n", 
-                                 avgTransmissionAttempts);
-      
-      // Count of collisions.
-      value = ((float )nodeTotalMetrics[nodeIndex]->getCountOfCollisions()/(float )simCount);
-      CLog::write(CLog::METRICS, "     collisions: %.2f (%.4f of transmission attempts)\n", 
-                                 value, 
-                                 (value/(float )avgTransmissionAttempts));
-      CLog::write(CLog::METRICS, "                       (%.4f of clock cycles)\n",
-                                 (value/(float )timeSlots));
-      
-      // Count of messages dropped.
-      value = ((float )nodeTotalMetrics[nodeIndex]->getCountOfMessagesDropped()/(float )simCount);
-      CLog::write(CLog::METRICS, "     messages dropped: %.2f (%.4f of messages generated)\n", 
-                                 value, 
-                                 ((float )value/(float )avgMessagesGenerated));
-      
-      // Count of messages transmitted.
-      value = ((float )nodeTotalMetrics[nodeIndex]->getCountOfMessagesTransmitted()/(float )simCount);
-      CLog::write(CLog::METRICS, "     messages transmitted: %.2f (%.4f of messages generated)\n", 
-                                 value, 
-                                 ((float )value/(float )avgMessagesGenerated));
-                                 
-      // Time slots messages spent waiting to be transmitted (time of completion - time of creation).
-      value = ((float )nodeTotalMetrics[nodeIndex]->getTimeMessagesWaited()/(float )simCount);
-      CLog::write(CLog::METRICS, "     time slots messages waited: %.2f (%.2f per message transmitted)\n", 
-                                 value, 
-                                 ((float )value/(float )avgMessagesTransmitted));
-      
-      // Maximum count of retransmission attempts.
-      value = ((float )nodeTotalMetrics[nodeIndex]->getMaximumRetransmissionAttempts()/(float )simCount);
-      CLog::write(CLog::METRICS, "     maximum retransmissions required before any one message was sent: %.0f\n", 
-                                 value);
-                                 
-      CLog::write(CLog::METRICS, "\n");
-   }
+   return 0;
 }
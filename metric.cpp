@@ -19,37 +19,37 @@ Metric::Metric() {
 }
 
 // Setter for theCountOfClockCyclesIdle.
-void Metric::setClockCyclesIdle(unsigned int value) {
+void Metric::setClockCyclesIdle(uint64_t value) {
    theCountOfClockCyclesIdle = value;
 }
 
 // Setter for theCountOfClockCyclesTransmitting.
-void Metric::setClockCyclesTransmitting(unsigned int value) {
+void Metric::setClockCyclesTransmitting(uint64_t value) {
    theCountOfClockCyclesTransmitting = value;
 }
 
 // Setter for theCountOfCollisions.
-void Metric::setCountOfCollisions(unsigned int value) {
+void Metric::setCountOfCollisions(uint64_t value) {
    theCountOfCollisions = value;
 }
 
 // Setter for theCountOfTransmissionAttempts.
-void Metric::setCountOfTransmissionAttempts(unsigned int value) {
+void Metric::setCountOfTransmissionAttempts(uint64_t value) {
    theCountOfTransmissionAttempts = value;
 }
 
 // Setter for theCountOfMessagesGenerated.
-void Metric::setCountOfMessagesGenerated(unsigned int value) {
+void Metric::setCountOfMessagesGenerated(uint64_t value) {
    theCountOfMessagesGenerated = value;
 }
 
 // Setter for theCountOfMessagesTransmitted.
-void Metric::setCountOfMessagesTransmitted(unsigned int value) {
+void Metric::setCountOfMessagesTransmitted(uint64_t value) {
    theCountOfMessagesTransmitted = value;
 }
 
 // Setter for theCountOfMessagesDropped.
-void Metric::setCountOfMessagesDropped(unsigned int value) {
+void Metric::setCountOfMessagesDropped(uint64_t value) {
    theCountOfMessagesDropped = value;
 }
 
@@ -89,56 +89,112 @@ void Metric::incrementCountOfMessagesDropped() {
 }
 
 // Setter for theMaximumRetransmissionAttempts.
-void Metric::setMaximumRetransmissionAttempts(unsigned int count) {
+void Metric::setMaximumRetransmissionAttempts(uint64_t count) {
    theMaximumRetransmissionAttempts = count;
 }
 
 // Updater for theTimeMessagesWaited.
-void Metric::updateTimeMessagesWaited(unsigned int time) {
+void Metric::updateTimeMessagesWaited(uint64_t time) {
    theTimeMessagesWaited += time;
 }
 
+// Updater for theMessageDelayHistogram.
+void Metric::updateMessageDelayHistogram(uint64_t time) {
+   theMessageDelayHistogram.recordValue(time);
+}
+
+// Updater for theRetransmissionHistogram.
+void Metric::updateRetransmissionHistogram(uint64_t count) {
+   theRetransmissionHistogram.recordValue(count);
+}
+
+// Sizes both histograms for values up to highestValue.
+void Metric::reserveHistograms(uint64_t highestValue) {
+   theMessageDelayHistogram.reserveValues(highestValue);
+   theRetransmissionHistogram.reserveValues(highestValue);
+}
+
 // Getter for theCountOfClockCyclesIdle.
-unsigned int Metric::getClockCyclesIdle() {
+uint64_t Metric::getClockCyclesIdle() {
    return theCountOfClockCyclesIdle;
 }
 
 // Getter for theCountOfClockCyclesTransmitting.
-unsigned int Metric::getClockCyclesTransmitting() {
+uint64_t Metric::getClockCyclesTransmitting() {
    return theCountOfClockCyclesTransmitting;
 }
 
 // Getter for theCountOfCollisions.
-unsigned int Metric::getCountOfCollisions() {
+uint64_t Metric::getCountOfCollisions() {
    return theCountOfCollisions;
 }
 
 // Getter for theCountOfTransmissionAttempts.
-unsigned int Metric::getCountOfTransmissionAttempts() {
+uint64_t Metric::getCountOfTransmissionAttempts() {
    return theCountOfTransmissionAttempts;
 }
 
 // Getter for theCountOfMessagesGenerated.
-unsigned int Metric::getCountOfMessagesGenerated() {
+uint64_t Metric::getCountOfMessagesGenerated() {
    return theCountOfMessagesGenerated;
 }
 
 // Getter for theCountOfMessagesTransmitted.
-unsigned int Metric::getCountOfMessagesTransmitted() {
+uint64_t Metric::getCountOfMessagesTransmitted() {
    return theCountOfMessagesTransmitted;
 }
 
 // Getter for theCountOfMessagesDropped.
-unsigned int Metric::getCountOfMessagesDropped() {
+uint64_t Metric::getCountOfMessagesDropped() {
    return theCountOfMessagesDropped;
 }
 
 // Getter for theMaximumRetransmissionAttempts.
-unsigned int Metric::getMaximumRetransmissionAttempts() {
+uint64_t Metric::getMaximumRetransmissionAttempts() {
    return theMaximumRetransmissionAttempts;
 }
       
 // Getter for theTimeMessagesWaited.
-unsigned int Metric::getTimeMessagesWaited() {
+uint64_t Metric::getTimeMessagesWaited() {
    return theTimeMessagesWaited;
 }
+
+// Getter for theMessageDelayHistogram.
+Histogram& Metric::getMessageDelayHistogram() {
+   return theMessageDelayHistogram;
+}
+
+// Getter for theRetransmissionHistogram.
+Histogram& Metric::getRetransmissionHistogram() {
+   return theRetransmissionHistogram;
+}
+
+// Appends every counter and histogram to state.
+void Metric::saveState(StateBuffer& state) {
+   state.appendValue(theCountOfClockCyclesIdle);
+   state.appendValue(theCountOfClockCyclesTransmitting);
+   state.appendValue(theCountOfCollisions);
+   state.appendValue(theCountOfTransmissionAttempts);
+   state.appendValue(theCountOfMessagesGenerated);
+   state.appendValue(theCountOfMessagesTransmitted);
+   state.appendValue(theCountOfMessagesDropped);
+   state.appendValue(theMaximumRetransmissionAttempts);
+   state.appendValue(theTimeMessagesWaited);
+   theMessageDelayHistogram.saveState(state);
+   theRetransmissionHistogram.saveState(state);
+}
+
+// Reads back the counters and histograms saved by saveState(). Returns false if state is too short.
+bool Metric::restoreState(StateBuffer& state) {
+   return state.readValue(theCountOfClockCyclesIdle)
+       && state.readValue(theCountOfClockCyclesTransmitting)
+       && state.readValue(theCountOfCollisions)
+       && state.readValue(theCountOfTransmissionAttempts)
+       && state.readValue(theCountOfMessagesGenerated)
+       && state.readValue(theCountOfMessagesTransmitted)
+       && state.readValue(theCountOfMessagesDropped)
+       && state.readValue(theMaximumRetransmissionAttempts)
+       && state.readValue(theTimeMessagesWaited)
+       && theMessageDelayHistogram.restoreState(state)
+       && theRetransmissionHistogram.restoreState(state);
+}
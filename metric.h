@@ -1,11 +1,16 @@
 /*
- * Declaration of the Metric class. A class used to store a node's metrics.
+ * Declaration of the Metric class. A class used to store a node's metrics. Every counter is 64-bit, so that totals over 
+ * long runs and many replications (the time messages waited above all) do not overflow. The delays and retransmission 
+ * counts of the transmitted messages are also kept as histograms, for their quantiles.
  */
 
 #ifndef __METRIC_H__
 #define __METRIC_H__
 
+#include <stdint.h>
+
 #include "helpers.h"
+#include "histogram.h"
 
 class Metric {
 	public:
@@ -18,25 +23,25 @@ class Metric {
        * INCREMENTERS/SETTERS
        */
       // Setter for theCountOfClockCyclesIdle.
-      void setClockCyclesIdle(unsigned int value);
+      void setClockCyclesIdle(uint64_t value);
       
       // Setter for theCountOfClockCyclesTransmitting.
-      void setClockCyclesTransmitting(unsigned int value);
+      void setClockCyclesTransmitting(uint64_t value);
       
       // Setter for theCountOfCollisions.
-      void setCountOfCollisions(unsigned int value);
+      void setCountOfCollisions(uint64_t value);
       
       // Setter for theCountOfTransmissionAttempts.
-      void setCountOfTransmissionAttempts(unsigned int value);
+      void setCountOfTransmissionAttempts(uint64_t value);
       
       // Setter for theCountOfMessagesGenerated.
-      void setCountOfMessagesGenerated(unsigned int value);
+      void setCountOfMessagesGenerated(uint64_t value);
       
       // Setter for theCountOfMessagesTransmitted.
-      void setCountOfMessagesTransmitted(unsigned int value);
+      void setCountOfMessagesTransmitted(uint64_t value);
       
       // Setter for theCountOfMessagesDropped.
-      void setCountOfMessagesDropped(unsigned int value);
+      void setCountOfMessagesDropped(uint64_t value);
       
       // Incrementer for theCountOfClockCyclesIdle.
       void incrementClockCyclesIdle();
@@ -60,69 +65,99 @@ class Metric {
       void incrementCountOfMessagesDropped();
       
       // Setter for theMaximumRetransmissionAttempts.
-      void setMaximumRetransmissionAttempts(unsigned int count);
+      void setMaximumRetransmissionAttempts(uint64_t count);
       
       // Updater for theTimeMessagesWaited.
-      void updateTimeMessagesWaited(unsigned int time);
+      void updateTimeMessagesWaited(uint64_t time);
+      
+      // Updater for theMessageDelayHistogram.
+      void updateMessageDelayHistogram(uint64_t time);
+      
+      // Updater for theRetransmissionHistogram.
+      void updateRetransmissionHistogram(uint64_t count);
+      
+      // Sizes both histograms for values up to highestValue (see Histogram::reserveValues()).
+      void reserveHistograms(uint64_t highestValue);
       
       /*
        * GETTERS
        */
       // Getter for theCountOfClockCyclesIdle.
-      unsigned int getClockCyclesIdle();
+      uint64_t getClockCyclesIdle();
       
       // Getter for theCountOfClockCyclesTransmitting.
-      unsigned int getClockCyclesTransmitting();
+      uint64_t getClockCyclesTransmitting();
       
       // Getter for theCountOfCollisions.
-      unsigned int getCountOfCollisions();
+      uint64_t getCountOfCollisions();
       
       // Getter for theCountOfTransmissionAttempts.
-      unsigned int getCountOfTransmissionAttempts();
+      uint64_t getCountOfTransmissionAttempts();
       
       // Getter for theCountOfMessagesGenerated.
-      unsigned int getCountOfMessagesGenerated();
+      uint64_t getCountOfMessagesGenerated();
       
       // Getter for theCountOfMessagesTransmitted.
-      unsigned int getCountOfMessagesTransmitted();
+      uint64_t getCountOfMessagesTransmitted();
       
       // Getter for theCountOfMessagesDropped.
-      unsigned int getCountOfMessagesDropped();
+      uint64_t getCountOfMessagesDropped();
       
       // Getter for theMaximumRetransmissionAttempts.
-      unsigned int getMaximumRetransmissionAttempts();
+      uint64_t getMaximumRetransmissionAttempts();
       
       // Getter for theTimeMessagesWaited.
-      unsigned int getTimeMessagesWaited();
+      uint64_t getTimeMessagesWaited();
+      
+      // Getter for theMessageDelayHistogram.
+      Histogram& getMessageDelayHistogram();
+      
+      // Getter for theRetransmissionHistogram.
+      Histogram& getRetransmissionHistogram();
+      
+      /*
+       * CHECKPOINTS
+       */
+      // Appends every counter and histogram to state.
+      void saveState(StateBuffer& state);
+      
+      // Reads back the counters and histograms saved by saveState(). Returns false if state is too short.
+      bool restoreState(StateBuffer& state);
       
 	private:
       // Used to track the number of cycles in an idle stae.
-      unsigned int theCountOfClockCyclesIdle;
+      uint64_t theCountOfClockCyclesIdle;
       
       // Used to track the number of cycles in a transmitting state.
-      unsigned int theCountOfClockCyclesTransmitting;
+      uint64_t theCountOfClockCyclesTransmitting;
       
       // Used to track how many collisions a channel experienced. 
-      unsigned int theCountOfCollisions;
+      uint64_t theCountOfCollisions;
       
       // Used to track how many transmission attempts occurred. 
-      unsigned int theCountOfTransmissionAttempts;
+      uint64_t theCountOfTransmissionAttempts;
       
       // Used to track how many messages were generated.
-      unsigned int theCountOfMessagesGenerated;
+      uint64_t theCountOfMessagesGenerated;
       
       // Used to track how many messages were transmitted.
-      unsigned int theCountOfMessagesTransmitted;
+      uint64_t theCountOfMessagesTransmitted;
       
       // Used to track how many messages have overflowed the buffer and have been dropped as a result.
-      unsigned int theCountOfMessagesDropped;
+      uint64_t theCountOfMessagesDropped;
       
       // Used to track the maximum amount of retransmissions occurred before sending any one particular packet.
-      unsigned int theMaximumRetransmissionAttempts;
+      uint64_t theMaximumRetransmissionAttempts;
       
       // Used to track the total time messages waited to be transmitted. 
       // (time message completely transmitted - time message generated).
-      unsigned int theTimeMessagesWaited;
+      uint64_t theTimeMessagesWaited;
+      
+      // Used to track the distribution of the time each transmitted message waited.
+      Histogram theMessageDelayHistogram;
+      
+      // Used to track the distribution of the count of retransmissions each transmitted message required.
+      Histogram theRetransmissionHistogram;
 };
 
 #endif	// __METRIC_H__
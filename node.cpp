@@ -2,13 +2,14 @@
  * Implementation of the Node class. A class used to represent a slot or station.
  */
 
-#include <math.h>       // pow
 #include <algorithm>    // std::min
 
 #include "node.h"
+#include "nodestore.h"
 
-// Node class constructor with args.
-Node::Node(int address) {
+// Node class constructor with args. The node's state lives at index address of nodeStore.
+Node::Node(NodeStore* nodeStore, int address) {
+   theNodeStore = nodeStore;
    if (!setInternalAddress(address) 
     || !setNodeState(IDLE) 
     || !setNextAttemptedTransmitTime(-1)
@@ -20,38 +21,18 @@ Node::Node(int address) {
    // Initialize the retransmit counter.
    resetRetransmitAttempts();
    
-   // Initialize the node's Metric object.
-   theNodeMetric = new Metric();
+   // The node's Metric object is owned by the store.
+   theNodeMetric = &nodeStore->getMetrics()[address];
 }
 
-// Destructor declared in order to free up the stored message object if needed.
-Node::~Node() {
-   // Delete all stored messaeg objects.
-   clearAllMessages();
-   
-   // Delete the Metric object.
-   Metric* storedMetric = getNodeMetric();
-   if (storedMetric != NULL) {
-      theNodeMetric = NULL;
-      delete storedMetric;
-   }
-}
-
-// Helper function to determine if the medium is idle.
-bool Node::isMediumIdle(std::vector<Node*> nodeVector) {
-   // Loop through each node.
-   for (std::vector<Node*>::iterator it = nodeVector.begin(); it != nodeVector.end(); it++) {
-      if (TRANSMITTING == (*it)->getNodeState()) {
-         return false;  
-      }
-   }
-   
-   // Return true, representing no nodes are transmitting.
-   return true;
+// Helper function to determine if the medium is idle at currentTime.
+bool Node::isMediumIdle(unsigned long currentTime) {
+   // The channel keeps a count of its transmitters and its busy period, so this is constant time.
+   return theNodeStore->getNodeChannel(theNodeInternalAddress).isIdle(currentTime);
 }
 
 // Starts the transmit of a message to a node (other than itself).
-bool Node::startMessageTransmit(unsigned int currentTime) {
+bool Node::startMessageTransmit(unsigned long currentTime) {
    // Ensure the node has a message.
    if (!hasMessage()) {
       std::cout << "ERROR - cannot start message transmit on node " 
@@ -62,7 +43,7 @@ bool Node::startMessageTransmit(unsigned int currentTime) {
    }
    
    // Update time of completed transmit.
-   int completionTime = currentTime + theMessageDeque[0]->getMessageSize();
+   long completionTime = currentTime + theNodeStore->getFrameLength();
    if (!setTimeOfTransmitCompletion(completionTime)) {
       std::cout << "ERROR - failed to update node's time of transmit completion" << std::endl;
       return false;
@@ -79,19 +60,20 @@ bool Node::startMessageTransmit(unsigned int currentTime) {
       std::cout << "WARNING - failed to reset the next attempted transmit time" << std::endl;  
    }
    
-   // Reset the retransmit counter.
-   resetRetransmitAttempts();
+   // Occupy the node's channel (with a topology, the medium of the node and its neighbours).
+   theNodeStore->occupyMedium(theNodeInternalAddress, currentTime, completionTime);
 
-   CLog::write(CLog::VERBOSE, 
-               "node %d starting transmit with completion time set to: %d\n", 
-               getInternalAddress(),
-               getTimeOfTransmitCompletion());
+   CLOG_WRITE(CLog::VERBOSE, 
+              "node %d starting transmit with completion time set to: %ld\n", 
+              getInternalAddress(),
+              getTimeOfTransmitCompletion());
+   traceEvent(TRACE_TRANSMIT_START, theNodeInternalAddress, getTimeOfTransmitCompletion());
    
    return true;
 }
 
 // Completes the node's current transmit of a message.
-bool Node::completeMessageTransmit(int timeOfCompletion) {
+bool Node::completeMessageTransmit(long timeOfCompletion) {
    // Verify that this node is actually in a transmitting state.
    if (getNodeState() != TRANSMITTING) {
       std::cout << "WARNING - node " 
@@ -109,20 +91,54 @@ bool Node::completeMessageTransmit(int timeOfCompletion) {
                 << std::endl;
    }
    
+   // Release the node's channel, which it has kept since the transmit started.
+   theNodeStore->releaseMedium(theNodeInternalAddress);
+   
    // Update the metric.
    theNodeMetric->incrementCountOfMessagesTransmitted();
-   unsigned int timeMessageWaited = timeOfCompletion - theMessageDeque[0]->getMessageTimeOfCreation();
+   uint64_t timeMessageWaited = timeOfCompletion - theNodeStore->getFrontMessageTimeOfCreation(theNodeInternalAddress);
    theNodeMetric->updateTimeMessagesWaited(timeMessageWaited);
+   theNodeMetric->updateMessageDelayHistogram(timeMessageWaited);
+   theNodeMetric->updateRetransmissionHistogram(getRetransmitAttempts());
+   
+   // Reset the retransmit counter (kept through the transmit for the metric above).
+   resetRetransmitAttempts();
    
    // Remove the node's message that it was sending.
    clearCurrentMessage();
    
-   CLog::write(CLog::VERBOSE, "node %d completed message transmission\n", getInternalAddress());
+   CLOG_WRITE(CLog::VERBOSE, "node %d completed message transmission\n", getInternalAddress());
+   traceEvent(TRACE_TRANSMIT_COMPLETE, theNodeInternalAddress);
+   return true;
+}
+
+// Ends the node's current transmit of a message that its receiver did not get (see NodeStore::isFrameReceived()). The 
+// message is kept for a retransmit, which the caller schedules with backoffFromTransmit().
+bool Node::abortMessageTransmit() {
+   // Verify that this node is actually in a transmitting state.
+   if (getNodeState() != TRANSMITTING) {
+      std::cout << "WARNING - node " 
+                << getInternalAddress() 
+                << " was not transmitting yet abortMessageTransmit() was called." 
+                << std::endl;
+      return false;
+   }
+   
+   // Reset the node's state and release its channel.
+   if (!setNodeState(IDLE) || !setTimeOfTransmitCompletion(-1)) {
+      std::cout << "WARNING - node " 
+                << getInternalAddress() 
+                << " failed to reset its state and time of transmit completion." 
+                << std::endl;
+   }
+   theNodeStore->releaseMedium(theNodeInternalAddress);
+   
+   CLOG_WRITE(CLog::VERBOSE, "node %d's message was not received\n", getInternalAddress());
    return true;
 }
 
 // Backs off from attempting to transmit.
-bool Node::backoffFromTransmit(unsigned int timeOfNextTransmitAttempt) {
+bool Node::backoffFromTransmit(long timeOfNextTransmitAttempt) {
    // Ensure the node has a message.
    if (!hasMessage()) {
       std::cout << "ERROR - cannot back-off on node " 
@@ -146,74 +162,67 @@ bool Node::backoffFromTransmit(unsigned int timeOfNextTransmitAttempt) {
    
    // Increase the retransmit counter.
    incrementRetransmitAttempts();
-   CLog::write(CLog::VERBOSE, 
-               "node %d will back-off, reattempting transmission at time %d, new retransmit attempt counter: %d\n",
-               getInternalAddress(),
-               getNextAttemptedTransmitTime(),
-               getRetransmitAttempts());
+   CLOG_WRITE(CLog::VERBOSE, 
+              "node %d will back-off, reattempting transmission at time %ld, new retransmit attempt counter: %d\n",
+              getInternalAddress(),
+              getNextAttemptedTransmitTime(),
+              getRetransmitAttempts());
+   traceEvent(TRACE_BACKOFF, theNodeInternalAddress, getNextAttemptedTransmitTime(), getRetransmitAttempts());
    return true;
 }
 
 // Reset the node's counter of consecutively experience.
 void Node::resetRetransmitAttempts() {
-   theRetransmitAttempts = 0;
+   theNodeStore->setRetransmitAttempts(theNodeInternalAddress, 0);
 }
 
 // Increments the node's counter of consecutively experience.
 void Node::incrementRetransmitAttempts() {
-   theRetransmitAttempts++;
+   int retransmitAttempts = getRetransmitAttempts() + 1;
+   theNodeStore->setRetransmitAttempts(theNodeInternalAddress, retransmitAttempts);
    
    // Update the metric.
-   if (theNodeMetric->getMaximumRetransmissionAttempts() < theRetransmitAttempts) {
-      theNodeMetric->setMaximumRetransmissionAttempts(theRetransmitAttempts);
+   if (theNodeMetric->getMaximumRetransmissionAttempts() < static_cast<unsigned int>(retransmitAttempts)) {
+      theNodeMetric->setMaximumRetransmissionAttempts(retransmitAttempts);
    }
 }
 
-// Determines the end of the back-off.
-int Node::determineBackoffEndTime(unsigned int currentTime, Configuration* configObj) {
-   // Medium is NOT idle. Determine the duration of the back-off.
-   unsigned int nextAttemptedTransmitTime = -1;
-   CSMA_TYPE csmaType = configObj->getCsmaType();
-   if (P_PERSISTENT == csmaType || ONE_PERSISTENT == csmaType) {
-      nextAttemptedTransmitTime = currentTime + 1;
-   }
-   else if (NON_PERSISTENT == csmaType) {
-      unsigned int power = std::min(configObj->getMaxBackoffRetransmitCount(), getRetransmitAttempts());
-      nextAttemptedTransmitTime = currentTime + generateRandomIntegerMinToMax(1, pow(2, power));
-   }
-   else {
-      // Intentionally blank for readability.
-   }
-   
-   return nextAttemptedTransmitTime;
+// Determine the end of the binary exponential backoff.
+long Node::determineEndOfBinaryExpBackoff(unsigned long currentTime, Configuration* configObj) {
+   return currentTime + generateRandomIntegerMinToMax(1, 
+                                                      determineBackoffWindow(configObj), 
+                                                      RNG_BACKOFF, 
+                                                      theNodeInternalAddress, 
+                                                      currentTime);
 }
 
-// Determine the end of the binary exponential backoff.
-int Node::determineEndOfBinaryExpBackoff(unsigned int currentTime, Configuration* configObj) {
-   unsigned int power = std::min(configObj->getMaxBackoffRetransmitCount(), getRetransmitAttempts());
-   return currentTime + generateRandomIntegerMinToMax(1, pow(2, power));
+// Determines the count of time slots a back-off is drawn from, 2^min(max retransmits, retransmit attempts). The power 
+// is capped at 31 so that the window fits in 32 bits.
+unsigned int Node::determineBackoffWindow(Configuration* configObj) {
+   int power = std::min(std::min(configObj->getMaxBackoffRetransmitCount(), getRetransmitAttempts()), 31);
+   return 1u << power;
 }
 
 // Returns if node has a message.
 bool Node::hasMessage() {
-   return !theMessageDeque.empty();
+   return 0 != getMessageCount();
 }
 
-// Adds a message to theMessageVector.
-bool Node::addMessage(Message* messageObj) {
-   // Validate the object.
-   if (!messageObj) {
-      std::cout << "ERROR - message object is null" << std::endl;
+// Adds a message, created at timeOfCreation, to the back of the node's message buffer.
+bool Node::addMessage(long timeOfCreation) {
+   // Validate the time.
+   if (timeOfCreation < 0) {
+      std::cout << "ERROR - illegal time: " << timeOfCreation << std::endl;
       return false;   
    }
    
    // Check if the message buffer overflowed.
-   if (10 == getMessageCount()) {
+   if (theNodeStore->getMessageBufferDepth() == getMessageCount()) {
       messagesOverflowed();
    }
    
-   // Add the message object to the buffer.
-   theMessageDeque.push_back(messageObj);
+   // Add the message to the buffer.
+   theNodeStore->pushBackMessage(theNodeInternalAddress, timeOfCreation);
    
    // Update the metric.
    theNodeMetric->incrementCountOfMessagesGenerated();
@@ -221,18 +230,17 @@ bool Node::addMessage(Message* messageObj) {
    return true;
 }
 
-// Clears front most message object.
+// Clears front most message.
 void Node::clearCurrentMessage() {
-   delete(theMessageDeque.front());
-   theMessageDeque.pop_front();
+   theNodeStore->popFrontMessage(theNodeInternalAddress);
 }
 
-// Pops a message off the back of theMessageDeque due to a simulated buffer overflow.
+// Pops a message off the back of the message buffer due to a simulated buffer overflow.
 void Node::messagesOverflowed() {
-   CLog::write(CLog::VERBOSE, "node %d dropped a message\n", getInternalAddress());
+   CLOG_WRITE(CLog::VERBOSE, "node %d dropped a message\n", getInternalAddress());
+   traceEvent(TRACE_DROP, theNodeInternalAddress);
    
-   delete(theMessageDeque.back());
-   theMessageDeque.pop_back();
+   theNodeStore->popBackMessage(theNodeInternalAddress);
    
    // Update the metric.
    theNodeMetric->incrementCountOfMessagesDropped();
@@ -257,31 +265,31 @@ bool Node::setNodeState(NODE_STATE state) {
       return false;
    }
    
-   theNodeState = state;
+   theNodeStore->setState(theNodeInternalAddress, state);
    return true;
 }
 
 // Setter for theTimeOfTransmitCompletion.
-bool Node::setTimeOfTransmitCompletion(int time) {
+bool Node::setTimeOfTransmitCompletion(long time) {
    // Validate the time
    if (time < -1) {
       std::cout << "ERROR - illegal time: " << time << std::endl;
       return false;   
    }
    
-   theTimeOfTransmitCompletion = time;
+   theNodeStore->setTimeOfTransmitCompletion(theNodeInternalAddress, time);
    return true;
 }
    
 // Setter for nextAttemptedTransmitTime.
-bool Node::setNextAttemptedTransmitTime(int time) {
+bool Node::setNextAttemptedTransmitTime(long time) {
    // Validate the time.
    if (time < -1) {
       std::cout << "ERROR - illegal time: " << time << std::endl;
       return false;   
    }
    
-   theNextAttemptedTransmitTime = time;
+   theNodeStore->setNextAttemptedTransmitTime(theNodeInternalAddress, time);
    return true;
 }
 
@@ -293,13 +301,13 @@ bool Node::setRetransmitAttempts(int attempts) {
       return false;   
    }
    
-   theRetransmitAttempts = attempts;
+   theNodeStore->setRetransmitAttempts(theNodeInternalAddress, attempts);
    return true;
 }
 
-// Returns the count of messages in theMessageDeque.
+// Returns the count of messages in the message buffer.
 int Node::getMessageCount() {
-   return theMessageDeque.size();
+   return theNodeStore->getMessageCount(theNodeInternalAddress);
 }
 
 // Getter for nodeInternalAddress.
@@ -309,30 +317,25 @@ int Node::getInternalAddress() {
 
 // Getter for nodeState.
 NODE_STATE Node::getNodeState() {
-   return theNodeState;
+   return theNodeStore->getState(theNodeInternalAddress);
 }
    
 // Getter for theTimeOfTransmitCompletion.
-int Node::getTimeOfTransmitCompletion() {
-   return theTimeOfTransmitCompletion;
+long Node::getTimeOfTransmitCompletion() {
+   return theNodeStore->getTimeOfTransmitCompletion(theNodeInternalAddress);
 }
 
 // Getter for nextAttemptedTransmitTime.
-int Node::getNextAttemptedTransmitTime() {
-   return theNextAttemptedTransmitTime;
+long Node::getNextAttemptedTransmitTime() {
+   return theNodeStore->getNextAttemptedTransmitTime(theNodeInternalAddress);
 }
    
 // Getter for theRetransmitAttempts.
 int Node::getRetransmitAttempts() {
-   return theRetransmitAttempts;
+   return theNodeStore->getRetransmitAttempts(theNodeInternalAddress);
 }
 
 // Getter for theMetric.
 Metric* Node::getNodeMetric() {
    return theNodeMetric;  
 }
-
-// Clears all message objects in theMessageDeque. 
-void Node::clearAllMessages() {
-   theMessageDeque.clear();
-}
@@ -5,14 +5,12 @@
 #ifndef __NODE_H__
 #define __NODE_H__
 
-#include <deque>
-
 #include "helpers.h"
 
 // Forward declarations. Resolves circular dependency issues.
-class Message;
 class Configuration;
 class Metric;
+class NodeStore;
 
 // Enum representing a node's current transmit state.
 // IN_QUEUE means that the node is currently backed off and is waiting for a reattempt.
@@ -25,23 +23,25 @@ typedef enum NODE_STATE {
 
 class Node {
    public:
-      // Constructor with args.
-      Node(int address);
+      // Constructor with args. The node's state lives at index address of nodeStore.
+      Node(NodeStore* nodeStore, int address);
       
-      // Destructor declared in order to free up the stored message object if needed.
-      ~Node();
+      // Destructor not declared since the default will suffice.
       
-      // Helper function to determine if the medium is idle.
-      bool isMediumIdle(std::vector<Node*> nodeVector);
+      // Helper function to determine if the medium is idle at currentTime.
+      bool isMediumIdle(unsigned long currentTime);
    
       // Transmits a message to a node other than itself.
-      bool startMessageTransmit(unsigned int currentTime);
+      bool startMessageTransmit(unsigned long currentTime);
    
       // Completes the node's current transmit of a message.
-      bool completeMessageTransmit(int timeOfCreation);
+      bool completeMessageTransmit(long timeOfCompletion);
+   
+      // Ends the node's current transmit of a message that its receiver did not get, keeping the message.
+      bool abortMessageTransmit();
    
       // Backs off from attempting to transmit based on the current configuration.
-      bool backoffFromTransmit(unsigned int timeOfNextTransmitAttempt);
+      bool backoffFromTransmit(long timeOfNextTransmitAttempt);
    
       // Reset the node's counter of consecutively experience.
       void resetRetransmitAttempts();
@@ -49,22 +49,22 @@ class Node {
       // Increments the node's counter of consecutively experience.
       void incrementRetransmitAttempts();
    
-      // Determines the end of the back-off.
-      int determineBackoffEndTime(unsigned int currentTime, Configuration* configObj);
-      
       // Determine the end of the binary exponential backoff.
-      int determineEndOfBinaryExpBackoff(unsigned int currentTime, Configuration* configObj);
+      long determineEndOfBinaryExpBackoff(unsigned long currentTime, Configuration* configObj);
+      
+      // Determines the count of time slots a back-off is drawn from.
+      unsigned int determineBackoffWindow(Configuration* configObj);
 
       // Returns if node has a message.
       bool hasMessage();
 
-      // Adds a message to theMessageVector.
-      bool addMessage(Message* messageObj);
+      // Adds a message, created at timeOfCreation, to the back of the node's message buffer.
+      bool addMessage(long timeOfCreation);
 
-      // Clears front most message object.
+      // Clears front most message.
       void clearCurrentMessage();
 
-      // Pops a message off the back of theMessageVector due to a simulated buffer overflow.
+      // Pops a message off the back of the message buffer due to a simulated buffer overflow.
       void messagesOverflowed();
    
       /*
@@ -77,21 +77,18 @@ class Node {
       bool setNodeState(NODE_STATE state);
    
       // Setter for theTimeOfTransmitCompletion.
-      bool setTimeOfTransmitCompletion(int time);
+      bool setTimeOfTransmitCompletion(long time);
    
       // Setter for nextAttemptedTransmitTime.
-      bool setNextAttemptedTransmitTime(int time);
+      bool setNextAttemptedTransmitTime(long time);
    
       // Setter for theRetransmitAttempts.
       bool setRetransmitAttempts(int attempts);
-   
-      // Setter for theMessage.
-      bool setMessage(Message* messageObj);
       
       /*
        * GETTERS
        */
-      // Returns the count of messages in theMessageVector.
+      // Returns the count of messages in the message buffer.
       int getMessageCount();
       
       // Getter for theNodeInternalAddress.
@@ -101,10 +98,10 @@ class Node {
       NODE_STATE getNodeState();
    
       // Getter for theTimeOfTransmitCompletion.
-      int getTimeOfTransmitCompletion();
+      long getTimeOfTransmitCompletion();
    
       // Getter for theNextAttemptedTransmitTime.
-      int getNextAttemptedTransmitTime();
+      long getNextAttemptedTransmitTime();
    
       // Getter for theRetransmitAttempts.
       int getRetransmitAttempts();
@@ -113,39 +110,15 @@ class Node {
       Metric* getNodeMetric();
       
       // Metric object.
-      // Contains non-null Metric object.
+      // Contains non-null Metric object, owned by the node store.
       Metric* theNodeMetric;
    
    private:
-      // Clears all message objects in theMessageVector. 
-      void clearAllMessages();
-   
-      // Internal address for this node.
+      // Internal address for this node, which is also its index in theNodeStore.
       int theNodeInternalAddress;
    
-      // Enum representing current state.
-      NODE_STATE theNodeState;
-   
-      // Integer representing the time of completion for the current transmit. 
-      // Values:
-      //    -1: default, no transmit in progress
-      //    non-negative integer: time of completion for the current transmitted message
-      // This value will be ignored if theNodeState is not set to BACKED_OFF
-      int theTimeOfTransmitCompletion;
-   
-      // Integer representing the next attempted transmit time. Behavior will depend upon the configured protocol.
-      // Values:
-      //    -1: default, no scheduled attempted transmit time
-      //    non-negative integer: time of next scheduled transmission attempt
-      // This value will be ignored if theNodeState is not set to BACKED_OFF
-      int theNextAttemptedTransmitTime;
-      
-      // Integer representing the number of retransmission attempts this node has currently consecutively experienced.
-      int theRetransmitAttempts;
-      
-      // Message deque.
-      // Contains non-null Message objects if currently transmitting or in a back-off state. Maximum count of 10.
-      std::deque<Message*> theMessageDeque;
+      // Store holding this node's state, transmit times, retransmit counter, message buffer and channel.
+      NodeStore* theNodeStore;
 };
 
 #endif	// __NODE_H__
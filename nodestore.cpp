@@ -0,0 +1,355 @@
+/*
+ * Implementation of the NodeStore class. A struct-of-arrays store holding the hot per-node state of a replication.
+ */
+
+#include <algorithm>    // std::min
+
+#include "nodestore.h"
+
+// Bytes that the histograms of the metrics may take up front. Beyond them (millions of nodes, or astronomically many 
+// time slots), the histograms are left to grow on demand instead.
+static const uint64_t HISTOGRAM_PRESIZE_BYTE_LIMIT = 64ULL << 20;
+
+// NodeStore class constructor with args. Sized from the node count, message buffer depth and state layout of configObj. 
+// The first frame arrival of every node is found here (unless the slot engine draws them per slot), so the calling 
+// thread's generator must already be keyed.
+NodeStore::NodeStore(Configuration* configObj) {
+   int nodeCount = configObj->getNodeCount();
+   theNodeCount = nodeCount;
+   thePacked = configObj->getPackedNodeStatesEnabled();
+   theMessageBufferDepth = configObj->getMessageBufferDepth();
+   theFrameLength = configObj->getFrameLength();
+   theTimeSlotCount = configObj->getTimeSlotCount();
+   theProbFrameGeneration = configObj->getProbFrameGeneration();
+   theFrameGenerationThreshold = configObj->getFrameGenerationThreshold();
+   theArrivalModel = configObj->getArrivalModel();
+   theIsArrivalScheduled = GEOMETRIC_ARRIVALS == theArrivalModel || EVENT_ENGINE == configObj->getEngineType();
+   
+   // With CHANNEL_SELECTION=random the channels only hold until each node's first frame. With a topology, each node 
+   // has a channel of its own.
+   theChannelSelection = configObj->getChannelSelection();
+   theTopology = configObj->isTopologyEnabled() ? &configObj->getTopology() : NULL;
+   theChannelCount = NULL == theTopology ? configObj->getChannelCount() : nodeCount;
+   
+   // A message waits, and is retransmitted, fewer times than there are time slots, so histograms sized for 
+   // TIME_SLOT_COUNT never grow in the slot loop.
+   uint64_t histogramBytes = 2ULL * nodeCount * Histogram::determineBucketCount(theTimeSlotCount) * sizeof(uint64_t);
+   theHistogramsPresized = histogramBytes <= HISTOGRAM_PRESIZE_BYTE_LIMIT;
+   
+   // Size every array once, by setting the state of the first replication; nothing is resized afterwards.
+   reset();
+   
+   // Create the node views, side by side.
+   theNodes.reserve(nodeCount);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      theNodes.push_back(Node(this, nodeIndex));
+   }
+}
+
+// Re-initializes the store in place for a new replication. Each array is refilled at the size it already has, so 
+// nothing is reallocated, and the metrics keep the buckets their histograms were sized to. The first frame arrival of 
+// every node is found here (unless the slot engine draws them per slot), so the calling thread's generator must 
+// already be keyed to the replication.
+void NodeStore::reset() {
+   int nodeCount = theNodeCount;
+   int bitWordCount = (nodeCount + 63) / 64;
+   if (thePacked) {
+      thePackedStates.assign((nodeCount + 31) / 32, 0);
+   }
+   else {
+      theStates.assign(nodeCount, IDLE);
+   }
+   theTransmittingBits.assign(bitWordCount, 0);
+   theBackedOffBits.assign(bitWordCount, 0);
+   theQueuedBits.assign(bitWordCount, 0);
+   theContendingBits.assign(bitWordCount, 0);
+   theTimesOfTransmitCompletion.assign(nodeCount, -1);
+   theNextAttemptedTransmitTimes.assign(nodeCount, -1);
+   theRetransmitAttempts.assign(nodeCount, 0);
+   theBackoffIdleSlotCounts.assign(nodeCount, 0);
+   theNextArrivalTimes.assign(nodeCount, theTimeSlotCount);
+   theMessageTimesOfCreation.assign(static_cast<size_t>(nodeCount) * theMessageBufferDepth, 0);
+   theMessageHeads.assign(nodeCount, 0);
+   theMessageCounts.assign(nodeCount, 0);
+   theMetrics.assign(nodeCount, Metric());
+   if (theHistogramsPresized) {
+      for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+         theMetrics[nodeIndex].reserveHistograms(theTimeSlotCount);
+      }
+   }
+   
+   // Spread the nodes over the channels.
+   theChannels.assign(theChannelCount, Channel());
+   theChannelIndexes.resize(nodeCount);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      theChannelIndexes[nodeIndex] = nodeIndex % theChannelCount;
+   }
+   if (NULL != theTopology) {
+      theReceivers.assign(nodeCount, -1);
+      theReceptionMarks.assign(nodeCount, 0);
+   }
+   
+   // Every node starts idle, waiting on its first frame. The slot engine draws Bernoulli arrivals itself.
+   theEarliestArrivalTime = theTimeSlotCount;
+   if (theIsArrivalScheduled) {
+      for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+         scheduleNextArrival(nodeIndex, -1);
+      }
+   }
+}
+
+// Finds a node's next frame arrival strictly after afterTime. The geometric gap is keyed by the time slot that follows 
+// afterTime; Bernoulli arrivals are found by walking the node's per-slot draws. Either way every engine sees the same 
+// arrivals.
+void NodeStore::scheduleNextArrival(int index, long afterTime) {
+   if (BERNOULLI_ARRIVALS == theArrivalModel) {
+      theNextArrivalTimes[index] = theTimeSlotCount;
+      for (long time = afterTime + 1; 0 != theFrameGenerationThreshold && time < theTimeSlotCount; time++) {
+         if (generateBernoulliTrial(theFrameGenerationThreshold, RNG_ARRIVAL, index, time)) {
+            theNextArrivalTimes[index] = time;
+            break;
+         }
+      }
+      theEarliestArrivalTime = std::min(theEarliestArrivalTime, theNextArrivalTimes[index]);
+      return;
+   }
+   
+   unsigned long interval = generateGeometricInterval(theProbFrameGeneration, RNG_ARRIVAL, index, afterTime + 1);
+   if (0 == interval || interval >= static_cast<unsigned long>(theTimeSlotCount - afterTime)) {
+      theNextArrivalTimes[index] = theTimeSlotCount;
+      return;
+   }
+   
+   theNextArrivalTimes[index] = afterTime + interval;
+   theEarliestArrivalTime = std::min(theEarliestArrivalTime, theNextArrivalTimes[index]);
+}
+
+// Records that a node starts a transmit at currentTime that completes at timeOfCompletion. With a topology, the node's 
+// channel and those of its neighbours are occupied, and the receiver is drawn among the neighbours; the frame is 
+// already lost if the receiver hears any transmitter but the node (including one starting in this time slot before 
+// the node, or the receiver itself).
+void NodeStore::occupyMedium(int index, long currentTime, long timeOfCompletion) {
+   theChannels[theChannelIndexes[index]].startTransmit(currentTime, timeOfCompletion);
+   if (NULL == theTopology) {
+      return;
+   }
+   
+   int degree = theTopology->getDegree(index);
+   const int* neighbours = theTopology->getNeighbours(index);
+   for (int neighbourIndex = 0; neighbourIndex < degree; neighbourIndex++) {
+      theChannels[neighbours[neighbourIndex]].startTransmit(currentTime, timeOfCompletion);
+   }
+   
+   if (0 == degree) {
+      theReceivers[index] = -1;
+      return;
+   }
+   int receiverIndex = neighbours[generateRandomIntegerMinToMax(0, degree - 1, RNG_RECEIVER, index, currentTime)];
+   Channel& receiverChannel = theChannels[receiverIndex];
+   theReceivers[index] = receiverIndex;
+   theReceptionMarks[index] = receiverChannel.getStartedTransmitCount() 
+                            - (1 == receiverChannel.getTransmitterCount() ? 0 : 1);
+}
+
+// Records that a node's transmit is over, releasing the channels occupyMedium() occupied.
+void NodeStore::releaseMedium(int index) {
+   theChannels[theChannelIndexes[index]].completeTransmit();
+   if (NULL == theTopology) {
+      return;
+   }
+   
+   int degree = theTopology->getDegree(index);
+   const int* neighbours = theTopology->getNeighbours(index);
+   for (int neighbourIndex = 0; neighbourIndex < degree; neighbourIndex++) {
+      theChannels[neighbours[neighbourIndex]].completeTransmit();
+   }
+}
+
+// Stores, in ascending order, the indexes of the nodes with a frame arrival at currentTime. Time slots before the 
+// earliest arrival return at once; otherwise the arrival times are compared in one branch-free pass that also finds 
+// the earliest arrival among the nodes that are not due.
+void NodeStore::collectDueArrivals(long currentTime, std::vector<int>& arrivalIndexes) {
+   arrivalIndexes.clear();
+   if (currentTime < theEarliestArrivalTime) {
+      return;
+   }
+   
+   long earliestArrivalTime = theTimeSlotCount;
+   for (int baseIndex = 0; baseIndex < theNodeCount; baseIndex += 64) {
+      int wordNodeCount = std::min(64, theNodeCount - baseIndex);
+      const long* arrivalTimes = &theNextArrivalTimes[baseIndex];
+      uint64_t dueBits = 0;
+      for (int offset = 0; offset < wordNodeCount; offset++) {
+         bool isDue = arrivalTimes[offset] == currentTime;
+         dueBits |= static_cast<uint64_t>(isDue) << offset;
+         earliestArrivalTime = std::min(earliestArrivalTime, isDue ? theTimeSlotCount : arrivalTimes[offset]);
+      }
+      
+      while (0 != dueBits) {
+         arrivalIndexes.push_back(baseIndex + __builtin_ctzll(dueBits));
+         dueBits &= dueBits - 1;
+      }
+   }
+   theEarliestArrivalTime = earliestArrivalTime;
+}
+
+// Stores, in ascending order, the indexes of the transmitting nodes whose transmit completes at currentTime. Words 
+// without a transmitting node are skipped; otherwise the completion times of the word's 64 nodes are compared in one 
+// branch-free (vectorizable) pass and masked with the transmitting bits.
+void NodeStore::collectCompletedTransmits(long currentTime, std::vector<int>& completedIndexes) {
+   completedIndexes.clear();
+   for (unsigned int word = 0; word < theTransmittingBits.size(); word++) {
+      uint64_t transmittingBits = theTransmittingBits[word];
+      if (0 == transmittingBits) {
+         continue;
+      }
+      
+      int baseIndex = word << 6;
+      int wordNodeCount = std::min(64, theNodeCount - baseIndex);
+      const long* completionTimes = &theTimesOfTransmitCompletion[baseIndex];
+      uint64_t completedBits = 0;
+      for (int offset = 0; offset < wordNodeCount; offset++) {
+         completedBits |= static_cast<uint64_t>(completionTimes[offset] == currentTime) << offset;
+      }
+      
+      completedBits &= transmittingBits;
+      while (0 != completedBits) {
+         completedIndexes.push_back(baseIndex + __builtin_ctzll(completedBits));
+         completedBits &= completedBits - 1;
+      }
+   }
+}
+
+// Stores the masks of the nodes with a transmit decision to take at currentTime. The nodes waiting on the medium with 
+// a message come from the state bits alone; the next attempt times are only compared, in one branch-free pass, in 
+// the words with a backed-off node.
+int NodeStore::collectAttemptBits(long currentTime, std::vector<uint64_t>& dueBits, 
+                                  std::vector<uint64_t>& waitingBits) {
+   int attemptCount = 0;
+   for (unsigned int word = 0; word < theBackedOffBits.size(); word++) {
+      uint64_t backedOffBits = theBackedOffBits[word];
+      uint64_t wordDueBits = 0;
+      if (0 != backedOffBits) {
+         int baseIndex = word << 6;
+         int wordNodeCount = std::min(64, theNodeCount - baseIndex);
+         const long* attemptTimes = &theNextAttemptedTransmitTimes[baseIndex];
+         for (int offset = 0; offset < wordNodeCount; offset++) {
+            wordDueBits |= static_cast<uint64_t>(attemptTimes[offset] == currentTime) << offset;
+         }
+         wordDueBits &= backedOffBits;
+      }
+      
+      dueBits[word] = wordDueBits;
+      waitingBits[word] = theQueuedBits[word] & ~(theTransmittingBits[word] | backedOffBits);
+      attemptCount += __builtin_popcountll(wordDueBits) + __builtin_popcountll(waitingBits[word]);
+   }
+   return attemptCount;
+}
+
+// Sets the idle time slots of every node to the time slots it did not spend transmitting, after the last time slot. 
+// The transmitting ones were credited as each transmit started.
+void NodeStore::settleIdleSlots() {
+   for (int nodeIndex = 0; nodeIndex < theNodeCount; nodeIndex++) {
+      theMetrics[nodeIndex].setClockCyclesIdle(theTimeSlotCount - theMetrics[nodeIndex].getClockCyclesTransmitting());
+   }
+}
+
+// Stores, in ascending order, the indexes of the nodes flagged as wanting to transmit and clears the flags.
+void NodeStore::takeContenders(std::vector<int>& contenderIndexes) {
+   contenderIndexes.clear();
+   for (unsigned int word = 0; word < theContendingBits.size(); word++) {
+      uint64_t contendingBits = theContendingBits[word];
+      while (0 != contendingBits) {
+         contenderIndexes.push_back((word << 6) + __builtin_ctzll(contendingBits));
+         contendingBits &= contendingBits - 1;
+      }
+      theContendingBits[word] = 0;
+   }
+}
+
+// Stores the counts of each channel as one metric per channel, at the end of a replication: the transmits started 
+// and collided as transmission attempts, the collided ones as collisions, the completed ones as messages transmitted, 
+// and the time slots the channel was sensed idle and busy as idle and transmitting. A topology has no shared channels, 
+// so there are none to store.
+void NodeStore::collectChannelMetrics(std::vector<Metric>& channelMetrics) {
+   if (NULL != theTopology) {
+      channelMetrics.clear();
+      return;
+   }
+   
+   channelMetrics.assign(theChannels.size(), Metric());
+   for (unsigned int channelIndex = 0; channelIndex < theChannels.size(); channelIndex++) {
+      theChannels[channelIndex].collectMetric(channelMetrics[channelIndex], theTimeSlotCount);
+   }
+}
+
+// Appends the state of every node (including its metric) and of the channels to state, between two time slots. Each 
+// array is copied whole, which is about as cheap as copying the store.
+void NodeStore::saveState(StateBuffer& state) {
+   state.appendValue(theNodeCount);
+   state.appendValue(theEarliestArrivalTime);
+   state.appendVector(theStates);
+   state.appendVector(thePackedStates);
+   state.appendVector(theTransmittingBits);
+   state.appendVector(theContendingBits);
+   state.appendVector(theTimesOfTransmitCompletion);
+   state.appendVector(theNextAttemptedTransmitTimes);
+   state.appendVector(theRetransmitAttempts);
+   state.appendVector(theBackoffIdleSlotCounts);
+   state.appendVector(theNextArrivalTimes);
+   state.appendVector(theMessageTimesOfCreation);
+   state.appendVector(theMessageHeads);
+   state.appendVector(theMessageCounts);
+   for (int nodeIndex = 0; nodeIndex < theNodeCount; nodeIndex++) {
+      theMetrics[nodeIndex].saveState(state);
+   }
+   for (unsigned int channelIndex = 0; channelIndex < theChannels.size(); channelIndex++) {
+      theChannels[channelIndex].saveState(state);
+   }
+   state.appendVector(theChannelIndexes);
+   state.appendVector(theReceivers);
+   state.appendVector(theReceptionMarks);
+}
+
+// Reads back the state saved by saveState() from a store of the same configuration. Returns false if state is too 
+// short or was saved for another node count.
+bool NodeStore::restoreState(StateBuffer& state) {
+   int nodeCount = 0;
+   if (!state.readValue(nodeCount) || nodeCount != theNodeCount) {
+      return false;
+   }
+   
+   bool isRestored = state.readValue(theEarliestArrivalTime)
+                  && state.readVector(theStates)
+                  && state.readVector(thePackedStates)
+                  && state.readVector(theTransmittingBits)
+                  && state.readVector(theContendingBits)
+                  && state.readVector(theTimesOfTransmitCompletion)
+                  && state.readVector(theNextAttemptedTransmitTimes)
+                  && state.readVector(theRetransmitAttempts)
+                  && state.readVector(theBackoffIdleSlotCounts)
+                  && state.readVector(theNextArrivalTimes)
+                  && state.readVector(theMessageTimesOfCreation)
+                  && state.readVector(theMessageHeads)
+                  && state.readVector(theMessageCounts);
+   for (int nodeIndex = 0; isRestored && nodeIndex < theNodeCount; nodeIndex++) {
+      isRestored = theMetrics[nodeIndex].restoreState(state);
+   }
+   for (unsigned int channelIndex = 0; isRestored && channelIndex < theChannels.size(); channelIndex++) {
+      isRestored = theChannels[channelIndex].restoreState(state);
+   }
+   isRestored = isRestored 
+             && state.readVector(theChannelIndexes) 
+             && state.readVector(theReceivers) 
+             && state.readVector(theReceptionMarks);
+   
+   // The backed-off and queued bits are not saved, they follow from the states and message counts.
+   for (int nodeIndex = 0; isRestored && nodeIndex < theNodeCount; nodeIndex++) {
+      uint64_t bit = 1ULL << (nodeIndex & 63);
+      theBackedOffBits[nodeIndex >> 6] = BACKED_OFF == getState(nodeIndex) ? theBackedOffBits[nodeIndex >> 6] | bit 
+                                                                           : theBackedOffBits[nodeIndex >> 6] & ~bit;
+      theQueuedBits[nodeIndex >> 6] = 0 < theMessageCounts[nodeIndex] ? theQueuedBits[nodeIndex >> 6] | bit 
+                                                                      : theQueuedBits[nodeIndex >> 6] & ~bit;
+   }
+   return isRestored;
+}
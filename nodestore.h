@@ -0,0 +1,365 @@
+/*
+ * Declaration of the NodeStore class. A struct-of-arrays store holding the hot per-node state of a replication in 
+ * contiguous arrays, so that the per-slot scans in determineNodeStates() walk memory linearly instead of chasing one 
+ * heap object per node. Node objects are thin views onto one index of the store, themselves held in one array.
+ *
+ * Each node's message buffer is a fixed-capacity ring of creation times (the only per-frame data; the sender, 
+ * receiver and size are the same for every frame of a node) carved out of one flat array.
+ *
+ * Two layouts are offered for the node states: one byte per node, or (for very large collision domains) 2 bits per 
+ * node packed 32 to a word. Either way the store also keeps one bit per node for "transmitting", "backed-off", "has a 
+ * message" and "wants to transmit this slot", which turns the completion and contention checks into word-wide masks: 
+ * the contention pass only visits the nodes of the mask with a decision to take, and the idle and transmitting time 
+ * slots are accounted per transmit rather than per node and time slot.
+ *
+ * By default frame arrivals are not drawn slot by slot. Each node's next arrival time is sampled from the geometric 
+ * distribution of the gap between Bernoulli successes and kept here, so a time slot only does arrival work when one 
+ * is due.
+ *
+ * The store also holds the channels (one Channel per channel, see CHANNEL_COUNT) and the channel each node senses and 
+ * transmits on. Nodes on different channels never sense or collide with each other.
+ *
+ * With a TOPOLOGY, the store holds one Channel per node instead: the medium as the node hears it. A transmit occupies 
+ * the channels of the transmitter and of its neighbours, so each node keeps a running count of the busy nodes it 
+ * hears and senses the medium in constant time, and a transmit or completion costs one update per neighbour. Every 
+ * node is alone on its own channel, so contention never collides a frame at the start; instead each transmit picks a 
+ * receiver among the transmitter's neighbours, and the frame is lost if, at any time before it completes, the 
+ * receiver hears another transmitter (or transmits itself). The receiver's channel counts every transmit it hears 
+ * start, so this is found at completion by comparing that count with the one taken when the frame started.
+ */
+
+#ifndef __NODESTORE_H__
+#define __NODESTORE_H__
+
+#include <stdint.h>
+#include <algorithm>    // std::min
+#include <vector>
+
+#include "helpers.h"
+#include "channel.h"
+
+class NodeStore {
+   public:
+      // Constructor with args. Sized from the node count, message buffer depth and state layout of configObj. The 
+      // first frame arrival of every node is found here (unless the slot engine draws them per slot), so the calling 
+      // thread's generator must already be keyed.
+      NodeStore(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Re-initializes every node and channel in place for a new replication, as the constructor left them, without 
+      // reallocating. The calling thread's generator must already be keyed to the replication.
+      void reset();
+      
+      // Returns the count of nodes in the store.
+      int getNodeCount() { return theNodeCount; }
+      
+      // Returns the view of node index.
+      Node* getNode(int index) { return &theNodes[index]; }
+      
+      // Returns the metrics, indexed by address.
+      std::vector<Metric>& getMetrics() { return theMetrics; }
+      
+      // Returns the count of channels.
+      int getChannelCount() { return static_cast<int>(theChannels.size()); }
+      
+      // Returns channel channelIndex.
+      Channel& getChannel(int channelIndex) { return theChannels[channelIndex]; }
+      
+      // Returns the length, in time slots, of every frame.
+      int getFrameLength() { return theFrameLength; }
+      
+      // Returns the capacity of each node's message buffer.
+      int getMessageBufferDepth() { return theMessageBufferDepth; }
+      
+      // Returns true if the histograms of the metrics are sized for every value up front (see reset()).
+      bool areHistogramsPresized() { return theHistogramsPresized; }
+      
+      /*
+       * PER-NODE ACCESSORS (defined inline as they sit in the per-slot loops)
+       */
+      // Getter for the state of a node.
+      NODE_STATE getState(int index) {
+         if (thePacked) {
+            return static_cast<NODE_STATE>((thePackedStates[index >> 5] >> ((index & 31) << 1)) & 3);
+         }
+         return static_cast<NODE_STATE>(theStates[index]);
+      }
+      
+      // Setter for the state of a node. Also maintains the transmitting and backed-off bits of the node.
+      void setState(int index, NODE_STATE state) {
+         if (thePacked) {
+            uint64_t shift = (index & 31) << 1;
+            thePackedStates[index >> 5] = (thePackedStates[index >> 5] & ~(3ULL << shift)) 
+                                        | (static_cast<uint64_t>(state) << shift);
+         }
+         else {
+            theStates[index] = static_cast<uint8_t>(state);
+         }
+         
+         uint64_t bit = 1ULL << (index & 63);
+         if (TRANSMITTING == state) {
+            theTransmittingBits[index >> 6] |= bit;
+         }
+         else {
+            theTransmittingBits[index >> 6] &= ~bit;
+         }
+         if (BACKED_OFF == state) {
+            theBackedOffBits[index >> 6] |= bit;
+         }
+         else {
+            theBackedOffBits[index >> 6] &= ~bit;
+         }
+      }
+      
+      // Returns the index of the channel a node senses and transmits on.
+      int getChannelIndex(int index) { return theChannelIndexes[index]; }
+      
+      // Returns the channel a node senses and transmits on.
+      Channel& getNodeChannel(int index) { return theChannels[theChannelIndexes[index]]; }
+      
+      // Records that a node starts a transmit at currentTime that completes at timeOfCompletion, on its channel or, with 
+      // a topology, on the channels of the node and its neighbours; also picks the receiver of the frame.
+      void occupyMedium(int index, long currentTime, long timeOfCompletion);
+      
+      // Records that a node's transmit is over, releasing the channels occupyMedium() occupied.
+      void releaseMedium(int index);
+      
+      // Returns true if the receiver of a node's transmit, due to complete now, got the frame. Always true without a 
+      // topology, where frames only collide at the start.
+      bool isFrameReceived(int index) {
+         int receiverIndex = NULL == theTopology ? -1 : theReceivers[index];
+         return receiverIndex < 0 || theChannels[receiverIndex].getStartedTransmitCount() == theReceptionMarks[index];
+      }
+      
+      // Selects the channel of a node about to contend for a new frame at currentTime. Only CHANNEL_SELECTION=random 
+      // changes it, with a draw keyed by the node and time slot; the node keeps it until the frame is transmitted.
+      void selectChannel(int index, unsigned long currentTime) {
+         if (RANDOM_CHANNELS == theChannelSelection) {
+            theChannelIndexes[index] = generateRandomIntegerMinToMax(0, theChannels.size() - 1, 
+                                                                     RNG_CHANNEL, index, currentTime);
+         }
+      }
+      
+      // Getter and setter for the time of transmit completion of a node.
+      long getTimeOfTransmitCompletion(int index) { return theTimesOfTransmitCompletion[index]; }
+      void setTimeOfTransmitCompletion(int index, long time) { theTimesOfTransmitCompletion[index] = time; }
+      
+      // Getter and setter for the next attempted transmit time of a node.
+      long getNextAttemptedTransmitTime(int index) { return theNextAttemptedTransmitTimes[index]; }
+      void setNextAttemptedTransmitTime(int index, long time) { theNextAttemptedTransmitTimes[index] = time; }
+      
+      // Getter and setter for the retransmit attempts of a node.
+      int getRetransmitAttempts(int index) { return theRetransmitAttempts[index]; }
+      void setRetransmitAttempts(int index, int attempts) { theRetransmitAttempts[index] = attempts; }
+      
+      // Getter and setter for the idle-slot clock value at which a node's CSMA/CA back-off expires.
+      long getBackoffIdleSlotCount(int index) { return theBackoffIdleSlotCounts[index]; }
+      void setBackoffIdleSlotCount(int index, long count) { theBackoffIdleSlotCounts[index] = count; }
+      
+      // Returns the count of messages buffered by a node.
+      int getMessageCount(int index) { return theMessageCounts[index]; }
+      
+      // Returns the creation time of a node's oldest buffered message. The node must have a message.
+      long getFrontMessageTimeOfCreation(int index) { 
+         return theMessageTimesOfCreation[static_cast<size_t>(index) * theMessageBufferDepth + theMessageHeads[index]]; 
+      }
+      
+      // Appends a message to a node's buffer. The buffer must not be full.
+      void pushBackMessage(int index, long timeOfCreation) {
+         int slot = theMessageHeads[index] + theMessageCounts[index];
+         if (slot >= theMessageBufferDepth) {
+            slot -= theMessageBufferDepth;
+         }
+         theMessageTimesOfCreation[static_cast<size_t>(index) * theMessageBufferDepth + slot] = timeOfCreation;
+         theMessageCounts[index]++;
+         theQueuedBits[index >> 6] |= 1ULL << (index & 63);
+      }
+      
+      // Removes a node's oldest message. The node must have a message.
+      void popFrontMessage(int index) {
+         if (++theMessageHeads[index] == theMessageBufferDepth) {
+            theMessageHeads[index] = 0;
+         }
+         if (0 == --theMessageCounts[index]) {
+            theQueuedBits[index >> 6] &= ~(1ULL << (index & 63));
+         }
+      }
+      
+      // Removes a node's newest message. The node must have a message.
+      void popBackMessage(int index) { 
+         if (0 == --theMessageCounts[index]) {
+            theQueuedBits[index >> 6] &= ~(1ULL << (index & 63));
+         }
+      }
+      
+      // Removes all of a node's messages.
+      void clearMessages(int index) { 
+         theMessageHeads[index] = 0; 
+         theMessageCounts[index] = 0; 
+         theQueuedBits[index >> 6] &= ~(1ULL << (index & 63));
+      }
+      
+      // Returns the time of a node's next frame arrival, the count of time slots if none is due in the simulation.
+      long getNextArrivalTime(int index) { return theNextArrivalTimes[index]; }
+      
+      // Finds a node's next frame arrival strictly after afterTime.
+      void scheduleNextArrival(int index, long afterTime);
+      
+      /*
+       * WHOLE-STORE SCANS
+       */
+      // Stores, in ascending order, the indexes of the nodes with a frame arrival at currentTime. Each of them must 
+      // have its next arrival scheduled before the following time slot.
+      void collectDueArrivals(long currentTime, std::vector<int>& arrivalIndexes);
+      
+      // Stores, in ascending order, the indexes of the transmitting nodes whose transmit completes at currentTime.
+      void collectCompletedTransmits(long currentTime, std::vector<int>& completedIndexes);
+      
+      // Stores, one word per 64 nodes, the masks of the nodes with a transmit decision to take at currentTime: in 
+      // dueBits the backed-off nodes whose next attempt is now, in waitingBits the nodes neither transmitting nor 
+      // backed-off that have a message. Returns the count of nodes in either mask.
+      int collectAttemptBits(long currentTime, std::vector<uint64_t>& dueBits, std::vector<uint64_t>& waitingBits);
+      
+      // Returns the word of transmitting bits, and of backed-off bits, of the nodes [64 * word, 64 * word + 64).
+      uint64_t getTransmittingBits(int word) { return theTransmittingBits[word]; }
+      uint64_t getBackedOffBits(int word) { return theBackedOffBits[word]; }
+      
+      // Credits a node that starts a transmit at currentTime, completing at timeOfCompletion, with the time slots of 
+      // the transmit that fall within the simulation.
+      void creditTransmittingSlots(int index, long currentTime, long timeOfCompletion) {
+         Metric& metric = theMetrics[index];
+         metric.setClockCyclesTransmitting(metric.getClockCyclesTransmitting() 
+                                         + std::min(timeOfCompletion, theTimeSlotCount) - currentTime);
+      }
+      
+      // Sets the idle time slots of every node to the time slots of the simulation it did not spend transmitting 
+      // (see creditTransmittingSlots()), after the last time slot.
+      void settleIdleSlots();
+      
+      // Flags a node as wanting to transmit in the current time slot.
+      void markContender(int index) { theContendingBits[index >> 6] |= 1ULL << (index & 63); }
+      
+      // Stores, in ascending order, the indexes of the nodes flagged as wanting to transmit and clears the flags.
+      void takeContenders(std::vector<int>& contenderIndexes);
+      
+      // Stores the counts of each channel (transmits started and collided, completed and collided, and the time slots 
+      // it was sensed idle and busy) as one metric per channel, at the end of a replication.
+      void collectChannelMetrics(std::vector<Metric>& channelMetrics);
+      
+      /*
+       * CHECKPOINTS
+       */
+      // Appends the state of every node (including its metric) and of the channels to state, between two time slots.
+      void saveState(StateBuffer& state);
+      
+      // Reads back the state saved by saveState() from a store of the same configuration. Returns false if state is 
+      // too short or was saved for another node count.
+      bool restoreState(StateBuffer& state);
+   
+   private:
+      // Count of nodes.
+      int theNodeCount;
+      
+      // Capacity of each node's message buffer.
+      int theMessageBufferDepth;
+      
+      // Length, in time slots, of every frame.
+      int theFrameLength;
+      
+      // Count of time slots in the simulation.
+      long theTimeSlotCount;
+      
+      // Probability of a frame arrival in each time slot, and the same as a Bernoulli threshold.
+      float theProbFrameGeneration;
+      uint64_t theFrameGenerationThreshold;
+      
+      // How frame arrivals are drawn.
+      ARRIVAL_MODEL theArrivalModel;
+      
+      // True if the next arrival of every node is kept (see scheduleNextArrival()), rather than drawn slot by slot.
+      bool theIsArrivalScheduled;
+      
+      // True if the histograms of the metrics are sized for every value up front.
+      bool theHistogramsPresized;
+      
+      // Earliest of the next arrival times, used to skip the arrival scan in time slots without an arrival.
+      long theEarliestArrivalTime;
+      
+      // True if the node states are packed 2 bits per node.
+      bool thePacked;
+      
+      // Node states, one byte per node (unpacked layout only).
+      std::vector<uint8_t> theStates;
+      
+      // Node states, 2 bits per node and 32 nodes per word (packed layout only).
+      std::vector<uint64_t> thePackedStates;
+      
+      // One bit per node, set while the node is TRANSMITTING.
+      std::vector<uint64_t> theTransmittingBits;
+      
+      // One bit per node, set while the node is BACKED_OFF.
+      std::vector<uint64_t> theBackedOffBits;
+      
+      // One bit per node, set while the node has a message.
+      std::vector<uint64_t> theQueuedBits;
+      
+      // One bit per node, set while the node wants to transmit in the current time slot.
+      std::vector<uint64_t> theContendingBits;
+      
+      // Time of completion for the current transmit, -1 when no transmit is in progress.
+      std::vector<long> theTimesOfTransmitCompletion;
+      
+      // Time of the next scheduled transmission attempt, -1 when none is scheduled.
+      std::vector<long> theNextAttemptedTransmitTimes;
+      
+      // Count of consecutive retransmission attempts.
+      std::vector<int> theRetransmitAttempts;
+      
+      // Idle-slot clock value (see Channel) at which the back-off expires, used by CSMA/CA only.
+      std::vector<long> theBackoffIdleSlotCounts;
+      
+      // Time of the next frame arrival, theTimeSlotCount when none is due within the simulation.
+      std::vector<long> theNextArrivalTimes;
+      
+      // Creation times of the buffered messages. Node i's ring occupies 
+      // [i * theMessageBufferDepth, (i + 1) * theMessageBufferDepth).
+      std::vector<long> theMessageTimesOfCreation;
+      
+      // Offset, within each node's ring, of its oldest message.
+      std::vector<int> theMessageHeads;
+      
+      // Count of messages in each node's ring.
+      std::vector<int> theMessageCounts;
+      
+      // Metric of each node.
+      std::vector<Metric> theMetrics;
+      
+      // How the nodes are assigned to the channels.
+      CHANNEL_SELECTION theChannelSelection;
+      
+      // Count of channels: CHANNEL_COUNT, or the node count with a topology.
+      int theChannelCount;
+      
+      // Channels, each shared by the nodes on it.
+      std::vector<Channel> theChannels;
+      
+      // Channel each node senses and transmits on.
+      std::vector<int> theChannelIndexes;
+      
+      // Which nodes hear each other, NULL when every node hears every other node.
+      Topology* theTopology;
+      
+      // Receiver of each node's transmit in progress, -1 if the node has no neighbour (topology only).
+      std::vector<int> theReceivers;
+      
+      // Count of transmits started that the receiver of each node's transmit in progress must have heard at the 
+      // completion for the frame to be received: the count once the frame started, or one less (never reached again) 
+      // if the receiver already heard another transmitter then (topology only).
+      std::vector<uint64_t> theReceptionMarks;
+      
+      // Node views onto this store, indexed by address.
+      std::vector<Node> theNodes;
+};
+
+#endif   // __NODESTORE_H__
@@ -0,0 +1,247 @@
+/*
+ * Implementation of the Profiler class. The phase profiler of csma_sim --profile.
+ */
+
+#include <cerrno>
+#include <cstring>      // memset, strerror
+#include <linux/perf_event.h>
+#include <sys/resource.h>       // getrusage
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "CLog.h"
+#include "alloccount.h"
+#include "profiler.h"
+
+// Name of each phase, as printed in the report.
+static const char* PROFILE_PHASE_NAMES[PROFILE_PHASE_COUNT] = {
+   "scheduling", "completion", "generation", "contention", "resolution"
+};
+
+// Hardware event of each counter.
+static const uint64_t PROFILE_COUNTER_EVENTS[PROFILE_COUNTER_COUNT] = {
+   PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+bool Profiler::theEnabled = false;
+thread_local ThreadProfile* Profiler::theThreadProfile = NULL;
+std::vector<ThreadProfile*> Profiler::theProfiles;
+std::mutex Profiler::theProfileMutex;
+std::string Profiler::theCounterError;
+
+// Helper function that opens a user-space counter of event for the calling thread, in the group led by groupFd (-1 
+// to lead a new group). Returns the file descriptor, or -1 with errno set.
+static int openCounter(uint64_t event, int groupFd) {
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.size = sizeof(attr);
+   attr.type = PERF_TYPE_HARDWARE;
+   attr.config = event;
+   attr.read_format = PERF_FORMAT_GROUP;
+   attr.exclude_kernel = 1;
+   attr.exclude_hv = 1;
+   return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+// ThreadProfile struct constructor.
+ThreadProfile::ThreadProfile() {
+   memset(nanoseconds, 0, sizeof(nanoseconds));
+   memset(counts, 0, sizeof(counts));
+   memset(allocations, 0, sizeof(allocations));
+   memset(lastCounts, 0, sizeof(lastCounts));
+   slotCount = 0;
+   currentPhase = PROFILE_PHASE_COUNT;
+   lastAllocationCount = 0;
+   groupFd = -1;
+}
+
+// Opens the calling thread's counters as one group, so that they are read together; a counter the PMU lacks is left 
+// out of the group. Returns false, with errno set, if none could be opened.
+bool ThreadProfile::openCounters() {
+   for (int counter = 0; counter < PROFILE_COUNTER_COUNT; counter++) {
+      int counterFd = openCounter(PROFILE_COUNTER_EVENTS[counter], groupFd);
+      if (counterFd < 0) {
+         continue;
+      }
+      if (groupFd < 0) {
+         groupFd = counterFd;
+      }
+      groupCounters.push_back(static_cast<PROFILE_COUNTER>(counter));
+   }
+   return groupFd >= 0;
+}
+
+// Starts profiling the time slots of every thread.
+void Profiler::start() {
+   theEnabled = true;
+}
+
+// Prints the per-phase breakdown over every thread, the peak RSS and the allocations, and closes the counters. Called 
+// once the threads that ran the time slots have finished.
+void Profiler::stop() {
+   if (!theEnabled) {
+      return;
+   }
+   theEnabled = false;
+   
+   // Add up the threads.
+   ThreadProfile total;
+   bool isCounted[PROFILE_COUNTER_COUNT] = { false };
+   for (unsigned int profileIndex = 0; profileIndex < theProfiles.size(); profileIndex++) {
+      ThreadProfile* profile = theProfiles[profileIndex];
+      for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+         total.nanoseconds[phase] += profile->nanoseconds[phase];
+         total.allocations[phase] += profile->allocations[phase];
+         for (int counter = 0; counter < PROFILE_COUNTER_COUNT; counter++) {
+            total.counts[phase][counter] += profile->counts[phase][counter];
+         }
+      }
+      for (unsigned int groupIndex = 0; groupIndex < profile->groupCounters.size(); groupIndex++) {
+         isCounted[profile->groupCounters[groupIndex]] = true;
+      }
+      total.slotCount += profile->slotCount;
+   }
+   
+   // The totals over the phases, for the last row.
+   uint64_t totalNanoseconds = 0, totalAllocations = 0;
+   uint64_t totalCounts[PROFILE_COUNTER_COUNT] = { 0 };
+   for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+      totalNanoseconds += total.nanoseconds[phase];
+      totalAllocations += total.allocations[phase];
+      for (int counter = 0; counter < PROFILE_COUNTER_COUNT; counter++) {
+         totalCounts[counter] += total.counts[phase][counter];
+      }
+   }
+   
+   CLog::write(CLog::METRICS, "\n- profile: %lu time slots on %lu thread(s) -\n",
+                              static_cast<unsigned long>(total.slotCount),
+                              static_cast<unsigned long>(theProfiles.size()));
+   CLog::write(CLog::METRICS, "%-12s%12s%8s%10s%14s%14s%7s%20s%20s%10s\n",
+                              "phase", "seconds", "share", "ns/slot", "cycles/slot", "instr/slot", "IPC",
+                              "cache-misses/slot", "branch-misses/slot", "allocs");
+   double slotCount = total.slotCount > 0 ? static_cast<double>(total.slotCount) : 1;
+   for (int phase = 0; phase <= PROFILE_PHASE_COUNT; phase++) {
+      // The row after the last phase holds the totals.
+      const char* name = phase < PROFILE_PHASE_COUNT ? PROFILE_PHASE_NAMES[phase] : "total";
+      uint64_t nanoseconds = phase < PROFILE_PHASE_COUNT ? total.nanoseconds[phase] : totalNanoseconds;
+      uint64_t allocations = phase < PROFILE_PHASE_COUNT ? total.allocations[phase] : totalAllocations;
+      uint64_t* counts = phase < PROFILE_PHASE_COUNT ? total.counts[phase] : totalCounts;
+      
+      char counterColumns[PROFILE_COUNTER_COUNT][32];
+      for (int counter = 0; counter < PROFILE_COUNTER_COUNT; counter++) {
+         if (isCounted[counter]) {
+            snprintf(counterColumns[counter], sizeof(counterColumns[counter]), "%.1f", counts[counter] / slotCount);
+         }
+         else {
+            snprintf(counterColumns[counter], sizeof(counterColumns[counter]), "-");
+         }
+      }
+      char ipcColumn[32] = "-";
+      if (isCounted[COUNTER_CYCLES] && isCounted[COUNTER_INSTRUCTIONS] && counts[COUNTER_CYCLES] > 0) {
+         snprintf(ipcColumn, sizeof(ipcColumn), "%.2f",
+                  static_cast<double>(counts[COUNTER_INSTRUCTIONS]) / counts[COUNTER_CYCLES]);
+      }
+      char allocationColumn[32] = "-";
+      if (isAllocationCountingEnabled()) {
+         snprintf(allocationColumn, sizeof(allocationColumn), "%lu", static_cast<unsigned long>(allocations));
+      }
+      
+      CLog::write(CLog::METRICS, "%-12s%12.6f%7.1f%%%10.1f%14s%14s%7s%20s%20s%10s\n",
+                                 name,
+                                 nanoseconds / 1e9,
+                                 totalNanoseconds > 0 ? 100.0 * nanoseconds / totalNanoseconds : 0.0,
+                                 nanoseconds / slotCount,
+                                 counterColumns[COUNTER_CYCLES],
+                                 counterColumns[COUNTER_INSTRUCTIONS],
+                                 ipcColumn,
+                                 counterColumns[COUNTER_CACHE_MISSES],
+                                 counterColumns[COUNTER_BRANCH_MISSES],
+                                 allocationColumn);
+   }
+   
+   if (!theCounterError.empty()) {
+      CLog::write(CLog::METRICS, "hardware counters unavailable (perf_event_open: %s); phases are only timed\n",
+                                 theCounterError.c_str());
+   }
+   if (!isAllocationCountingEnabled()) {
+      CLog::write(CLog::METRICS, "allocations are only counted by csma_sim_alloc\n");
+   }
+   struct rusage usage;
+   if (0 == getrusage(RUSAGE_SELF, &usage)) {
+      CLog::write(CLog::METRICS, "peak RSS: %.1f MiB\n", usage.ru_maxrss / 1024.0);
+   }
+   
+   // Release the profiles. The threads that made them have finished, bar the calling one.
+   for (unsigned int profileIndex = 0; profileIndex < theProfiles.size(); profileIndex++) {
+      if (theProfiles[profileIndex]->groupFd >= 0) {
+         close(theProfiles[profileIndex]->groupFd);
+      }
+      delete theProfiles[profileIndex];
+   }
+   theProfiles.clear();
+   theThreadProfile = NULL;
+}
+
+// Ends the calling thread's phase in progress, if any, and starts phase.
+void Profiler::enterPhase(PROFILE_PHASE phase) {
+   ThreadProfile* profile = getThreadProfile();
+   accountPhase(profile);
+   profile->currentPhase = phase;
+}
+
+// Ends the calling thread's time slot.
+void Profiler::endSlot() {
+   ThreadProfile* profile = getThreadProfile();
+   accountPhase(profile);
+   profile->currentPhase = PROFILE_PHASE_COUNT;
+   profile->slotCount++;
+}
+
+// Returns the calling thread's profile, creating and registering it on first use.
+ThreadProfile* Profiler::getThreadProfile() {
+   if (NULL == theThreadProfile) {
+      theThreadProfile = new ThreadProfile();
+      bool isCounting = theThreadProfile->openCounters();
+      int counterErrno = errno;
+      std::lock_guard<std::mutex> lock(theProfileMutex);
+      if (!isCounting && theCounterError.empty()) {
+         theCounterError = strerror(counterErrno);
+      }
+      theProfiles.push_back(theThreadProfile);
+   }
+   return theThreadProfile;
+}
+
+// Adds the time, counts and allocations since the start of the phase in progress to it, and restarts the clock. The 
+// clock is read first and restarted last, so that the time spent reading the counters is left out of every phase.
+void Profiler::accountPhase(ThreadProfile* profile) {
+   std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+   PROFILE_PHASE phase = profile->currentPhase;
+   bool isInPhase = PROFILE_PHASE_COUNT != phase;
+   if (isInPhase) {
+      profile->nanoseconds[phase] +=
+         std::chrono::duration_cast<std::chrono::nanoseconds>(now - profile->phaseStart).count();
+   }
+   
+   if (profile->groupFd >= 0) {
+      // The group reads as its count of counters, followed by their values in the order they were opened.
+      uint64_t values[1 + PROFILE_COUNTER_COUNT];
+      if (read(profile->groupFd, values, sizeof(values)) > 0) {
+         for (unsigned int groupIndex = 0; groupIndex < profile->groupCounters.size(); groupIndex++) {
+            PROFILE_COUNTER counter = profile->groupCounters[groupIndex];
+            if (isInPhase) {
+               profile->counts[phase][counter] += values[1 + groupIndex] - profile->lastCounts[counter];
+            }
+            profile->lastCounts[counter] = values[1 + groupIndex];
+         }
+      }
+   }
+   
+   unsigned long allocationCount = getThreadAllocationCount();
+   if (isInPhase) {
+      profile->allocations[phase] += allocationCount - profile->lastAllocationCount;
+   }
+   profile->lastAllocationCount = allocationCount;
+   
+   profile->phaseStart = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,130 @@
+/*
+ * Declaration of the Profiler class. The phase profiler of csma_sim --profile, which attributes the time of every 
+ * simulated time slot to the phases of determineNodeStates() (and of the event and lane engines' time slots): 
+ *   scheduling - the shuffle of the service order (slot engine), the pops of the due nodes (event engine) or the 
+ *                scan of the lanes for due nodes (lane engine) 
+ *   completion - the transmits completing 
+ *   generation - the frame arrivals 
+ *   contention - the decision of every node to transmit, wait or back off 
+ *   resolution - the transmit started, or the collision resolved
+ *
+ * Each thread keeps its own profile, created on its first time slot. A phase is timed with the steady clock and, where 
+ * the kernel allows perf_event_open, counted with the thread's hardware counters (cycles, instructions, cache misses 
+ * and branch misses, user space only). The counters are read with one system call at each phase boundary; the time of 
+ * that call is left out of the phases, but it does slow a profiled run. Where the counters cannot be opened (no PMU, 
+ * perf_event_paranoid, a container), the phases are only timed. The allocations of each phase are counted in the 
+ * diagnostic build (csma_sim_alloc).
+ *
+ * Profiling never changes the results. Each hook costs a single test when it is off.
+ */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Enum representing a phase of a time slot.
+typedef enum PROFILE_PHASE {
+   PHASE_SCHEDULING = 0,
+   PHASE_COMPLETION,
+   PHASE_GENERATION,
+   PHASE_CONTENTION,
+   PHASE_RESOLUTION,
+   PROFILE_PHASE_COUNT
+} PROFILE_PHASE;
+
+// Enum representing a hardware counter.
+typedef enum PROFILE_COUNTER {
+   COUNTER_CYCLES = 0,
+   COUNTER_INSTRUCTIONS,
+   COUNTER_CACHE_MISSES,
+   COUNTER_BRANCH_MISSES,
+   PROFILE_COUNTER_COUNT
+} PROFILE_COUNTER;
+
+// The profile of one thread.
+struct ThreadProfile {
+   // Constructor. Starts the profile empty, without counters.
+   ThreadProfile();
+   
+   // Opens the calling thread's hardware counters. Returns false, with errno set, if none could be opened.
+   bool openCounters();
+   
+   // Time (in nanoseconds), hardware counts and allocations of each phase.
+   uint64_t nanoseconds[PROFILE_PHASE_COUNT];
+   uint64_t counts[PROFILE_PHASE_COUNT][PROFILE_COUNTER_COUNT];
+   uint64_t allocations[PROFILE_PHASE_COUNT];
+   
+   // Count of time slots profiled.
+   uint64_t slotCount;
+   
+   // Phase in progress (PROFILE_PHASE_COUNT between time slots), and its start.
+   PROFILE_PHASE currentPhase;
+   std::chrono::steady_clock::time_point phaseStart;
+   
+   // Counter group of the thread (-1 if none could be opened), and the counters it holds in the order they are read.
+   int groupFd;
+   std::vector<PROFILE_COUNTER> groupCounters;
+   
+   // Counter values and allocation count at the start of the phase in progress.
+   uint64_t lastCounts[PROFILE_COUNTER_COUNT];
+   unsigned long lastAllocationCount;
+};
+
+class Profiler {
+   public:
+      // Starts profiling the time slots of every thread.
+      static void start();
+      
+      // Prints the per-phase breakdown over every thread, the peak RSS and the allocations, and closes the counters.
+      static void stop();
+      
+      // Returns true while profiling.
+      static bool isEnabled() { return theEnabled; }
+      
+      // Ends the calling thread's phase in progress, if any, and starts phase.
+      static void enterPhase(PROFILE_PHASE phase);
+      
+      // Ends the calling thread's time slot.
+      static void endSlot();
+   
+   private:
+      // Returns the calling thread's profile, creating and registering it on first use.
+      static ThreadProfile* getThreadProfile();
+      
+      // Adds the time, counts and allocations since the start of the phase in progress to it, and restarts the clock.
+      static void accountPhase(ThreadProfile* profile);
+      
+      // True while profiling.
+      static bool theEnabled;
+      
+      // Profile of the calling thread.
+      static thread_local ThreadProfile* theThreadProfile;
+      
+      // Every profile created. Guarded by theProfileMutex.
+      static std::vector<ThreadProfile*> theProfiles;
+      static std::mutex theProfileMutex;
+      
+      // Why the counters could not be opened, empty if they could.
+      static std::string theCounterError;
+};
+
+// Starts a phase of the calling thread's time slot. Inline so that it costs a single test when profiling is off.
+inline void profilePhase(PROFILE_PHASE phase) {
+   if (Profiler::isEnabled()) {
+      Profiler::enterPhase(phase);
+   }
+}
+
+// Ends the calling thread's time slot.
+inline void profileSlotEnd() {
+   if (Profiler::isEnabled()) {
+      Profiler::endSlot();
+   }
+}
+
+#endif   // __PROFILER_H__
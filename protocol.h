@@ -0,0 +1,196 @@
+/*
+ * Declaration of the MAC protocol policies. A policy answers the few decisions on which the protocols differ (what a
+ * node with a frame does on an idle medium, on a busy medium and after a collision, and when its back-off is over).
+ * The slot kernel (determineNodeStates()) and the event engine are templates on the policy, instantiated once per
+ * protocol and selected once at startup, so the per-node loops carry no protocol branches.
+ *
+ * The three original protocols have no collision detection. By default (COLLISION_MODEL=slot) they keep the original 
+ * collision model: a collision is given up on in the time slot it happens in and the medium is idle again in the next 
+ * one. With COLLISION_MODEL=frame, the colliding frames are sent whole and keep the medium busy for FRAME_LENGTH, the 
+ * colliding nodes backing off from the end of the collision. CSMA/CD detects a collision and aborts it with a one slot 
+ * jam whatever the model, and CSMA/CA, having no collision detection, always keeps the medium busy for a whole frame. 
+ * CSMA/CA back-offs count down idle time slots only (802.11 DCF freezes the back-off counter while the medium is 
+ * busy), on the idle-slot clock of the node's channel.
+ */
+
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include <algorithm>    // std::min
+
+#include "helpers.h"
+#include "nodestore.h"
+
+// Returned by onIdleWithFrame() when the node transmits in the current time slot.
+static const long TRANSMIT_NOW = -1;
+
+// What the policies need to take their decisions.
+struct ProtocolContext {
+   // Nodes of the current replication.
+   NodeStore* nodeStore;
+   
+   // Configuration shared (read-only) by every replication.
+   Configuration* configObj;
+   
+   // Scratch buffers of the slot kernel, whose p-persistence draws are batched per time slot. NULL in the event
+   // engine, which draws for one node at a time.
+   SlotScratch* scratch;
+};
+
+// Helper function that returns a node's p-persistence draw for the time slot. With scratch buffers, the draws of every
+// node are taken in one batch on the first call of each time slot; either way the draw is the same.
+inline bool drawPersistence(ProtocolContext& context, int nodeIndex, unsigned long currentTime) {
+   SlotScratch* scratch = context.scratch;
+   if (NULL == scratch) {
+      return generateBernoulliTrial(context.configObj->getPersistenceThreshold(),
+                                    RNG_PERSISTENCE,
+                                    nodeIndex,
+                                    currentTime);
+   }
+   
+   if (!scratch->isPersistenceDrawn) {
+      generateBernoulliTrials(context.configObj->getPersistenceThreshold(),
+                              RNG_PERSISTENCE,
+                              context.nodeStore->getNodeCount(),
+                              currentTime,
+                              &scratch->persistenceBits[0]);
+      scratch->isPersistenceDrawn = true;
+   }
+   return (scratch->persistenceBits[nodeIndex >> 6] >> (nodeIndex & 63)) & 1;
+}
+
+// Behaviour shared by the policies. A policy hides the hooks it changes.
+struct ProtocolPolicy {
+   // Returns TRANSMIT_NOW if a node with a frame transmits on the idle medium, otherwise the time it defers to.
+   static long onIdleWithFrame(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return TRANSMIT_NOW;
+   }
+   
+   // Returns the time of the next attempt of a node with a frame that senses the medium busy.
+   static long onBusy(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return currentTime + 1;
+   }
+   
+   // Returns the time of the next attempt of a node whose transmit collided. The back-off starts once the collision 
+   // is over.
+   static long onCollision(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return nodeObj->determineEndOfBinaryExpBackoff(currentTime, context.configObj) 
+           + determineCollisionEndTime(context, currentTime) - static_cast<long>(currentTime + 1);
+   }
+   
+   // Returns the end of the period a collision at currentTime keeps the medium busy for (currentTime + 1 for none): 
+   // the whole frame with COLLISION_MODEL=frame.
+   static long determineCollisionEndTime(ProtocolContext& context, unsigned long currentTime) {
+      if (FRAME_COLLISIONS == context.configObj->getCollisionModel()) {
+         return currentTime + context.nodeStore->getFrameLength();
+      }
+      return currentTime + 1;
+   }
+   
+   // Returns true if the back-off of a node due at currentTime is over. Otherwise the node's next attempted transmit
+   // time has been moved out, without counting a retransmit attempt.
+   static bool isBackoffExpired(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return true;
+   }
+};
+
+// Non-persistent CSMA: on a busy medium, wait a random back-off before sensing again.
+struct NonPersistentPolicy : public ProtocolPolicy {
+   static long onBusy(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return nodeObj->determineEndOfBinaryExpBackoff(currentTime, context.configObj);
+   }
+};
+
+// 1-persistent CSMA: on a busy medium, sense again in the next time slot.
+struct OnePersistentPolicy : public ProtocolPolicy {
+};
+
+// p-persistent CSMA: on an idle medium, transmit with probability p, otherwise defer to the next time slot.
+struct PPersistentPolicy : public ProtocolPolicy {
+   static long onIdleWithFrame(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      if (drawPersistence(context, nodeObj->getInternalAddress(), currentTime)) {
+         CLOG_WRITE(CLog::VERBOSE,
+                    "medium is idle for retransmit attempt and p-persistent node %d will attempt to transmit\n",
+                    nodeObj->getInternalAddress());
+         traceEvent(TRACE_PERSIST_ATTEMPT, nodeObj->getInternalAddress());
+         return TRANSMIT_NOW;
+      }
+      
+      CLOG_WRITE(CLog::VERBOSE,
+                 "p-persistance node %d will wait until next time cycle and try again\n",
+                 nodeObj->getInternalAddress());
+      traceEvent(TRACE_PERSIST_WAIT, nodeObj->getInternalAddress());
+      return currentTime + 1;
+   }
+};
+
+// 1-persistent CSMA with collision detection: a collision is aborted after a one slot jam, then the nodes take the
+// binary exponential back-off from the end of the jam. Under COLLISION_MODEL=frame, where a 1-persistent collision 
+// wastes a whole frame, this is what collision detection saves; under the default slot model the others give up on a 
+// collision at once too, so the jam only adds to its cost.
+struct CsmaCdPolicy : public ProtocolPolicy {
+   static long onCollision(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return nodeObj->determineEndOfBinaryExpBackoff(currentTime, context.configObj) + 1;
+   }
+   
+   static long determineCollisionEndTime(ProtocolContext& context, unsigned long currentTime) {
+      return currentTime + 2;
+   }
+};
+
+// 802.11-style CSMA/CA: a node with a frame transmits on an idle medium. On a busy medium or after a collision it
+// draws a back-off from the contention window (CSMA_CA_MIN_WINDOW, doubling with each retransmit attempt) that only 
+// counts down in idle time slots. Without collision detection, colliding frames keep the medium busy for their whole 
+// length.
+struct CsmaCaPolicy : public ProtocolPolicy {
+   // Smallest contention window, in time slots (CWmin + 1 of 802.11 DSSS). Without it, every node that found the 
+   // medium busy would wait the same single idle slot and collide.
+   static const unsigned long CSMA_CA_MIN_WINDOW = 32;
+   
+   static long onBusy(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return startIdleSlotBackoff(context, nodeObj, currentTime);
+   }
+   
+   static long onCollision(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      return startIdleSlotBackoff(context, nodeObj, currentTime);
+   }
+   
+   static long determineCollisionEndTime(ProtocolContext& context, unsigned long currentTime) {
+      return currentTime + context.nodeStore->getFrameLength();
+   }
+   
+   // The node is due at the time its back-off was predicted to expire. Busy time slots since then push it out.
+   static bool isBackoffExpired(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      Channel& channel = context.nodeStore->getNodeChannel(nodeObj->getInternalAddress());
+      long idleSlotCount = context.nodeStore->getBackoffIdleSlotCount(nodeObj->getInternalAddress());
+      if (channel.countIdleSlots(currentTime) >= idleSlotCount) {
+         return true;
+      }
+      
+      nodeObj->setNextAttemptedTransmitTime(channel.predictIdleSlotTime(idleSlotCount, currentTime));
+      return false;
+   }
+   
+   // Draws the back-off in idle time slots and returns the time it expires at if the medium stays idle.
+   static long startIdleSlotBackoff(ProtocolContext& context, Node* nodeObj, unsigned long currentTime) {
+      Channel& channel = context.nodeStore->getNodeChannel(nodeObj->getInternalAddress());
+      unsigned long window = std::min(CSMA_CA_MIN_WINDOW * nodeObj->determineBackoffWindow(context.configObj), 
+                                      1UL << 31);
+      long idleSlotCount = channel.countIdleSlots(currentTime)
+                         + generateRandomIntegerMinToMax(1,
+                                                         window,
+                                                         RNG_BACKOFF,
+                                                         nodeObj->getInternalAddress(),
+                                                         currentTime);
+      context.nodeStore->setBackoffIdleSlotCount(nodeObj->getInternalAddress(), idleSlotCount);
+      return channel.predictIdleSlotTime(idleSlotCount, currentTime);
+   }
+};
+
+// The slot kernel, determineNodeStates() instantiated for one protocol.
+typedef void (*SlotKernel)(NodeStore& nodeStore, unsigned long currentTime, Configuration* configObj, SlotScratch& scratch);
+
+// Helper function that returns determineNodeStates() instantiated for the protocol.
+SlotKernel selectSlotKernel(CSMA_TYPE csmaType);
+
+#endif   // __PROTOCOL_H__
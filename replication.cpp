@@ -0,0 +1,347 @@
+/*
+ * Implementation of the ReplicationRunner class. A class used to execute the configured replications on a pool of 
+ * worker threads and to reduce their node and channel metrics, in replication order, into the overall totals.
+ */
+
+#include <algorithm>    // std::min, std::max
+#include <chrono>
+#include <thread>
+
+#include "replication.h"
+#include "laneengine.h"
+#include "simulation.h"
+#include "report.h"
+
+// Helper function that appends the count of metrics, then each metric, to state.
+static void saveMetrics(StateBuffer& state, std::vector<Metric>& metrics) {
+   state.appendValue<uint64_t>(metrics.size());
+   for (unsigned int metricIndex = 0; metricIndex < metrics.size(); metricIndex++) {
+      metrics[metricIndex].saveState(state);
+   }
+}
+
+// Helper function that reads back metrics saved by saveMetrics(). Returns false if state is too short.
+static bool restoreMetrics(StateBuffer& state, std::vector<Metric>& metrics) {
+   uint64_t metricCount = 0;
+   if (!state.readValue(metricCount)) {
+      return false;
+   }
+   metrics.resize(metricCount);
+   for (unsigned int metricIndex = 0; metricIndex < metrics.size(); metricIndex++) {
+      if (!metrics[metricIndex].restoreState(state)) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// ReplicationRunner class constructor with args. With savedCheckpoint (NULL otherwise), the run resumes from the 
+// checkpoint: the replications already reduced are not run again, and the RESULT_FILE is cut back to the checkpoint.
+ReplicationRunner::ReplicationRunner(Configuration* configObj, std::vector<Metric>& nodeTotalMetrics, 
+                                     std::vector<Metric>& channelTotalMetrics, ResultSink* resultSink, 
+                                     Checkpoint* savedCheckpoint) 
+   : theStoppingRule(configObj), theNextSimIndex(0), theSimLimit(configObj->getSimulationCount()) {
+   theConfigObj = configObj;
+   theNodeTotalMetrics = &nodeTotalMetrics;
+   theChannelTotalMetrics = &channelTotalMetrics;
+   theResultSink = resultSink;
+   theNextSimToReduce = 0;
+   theSavedCheckpoint = savedCheckpoint;
+   theCheckpointer = NULL;
+   theCheckpointsStopped = false;
+   
+   if (NULL != theSavedCheckpoint) {
+      if (!restoreRunState(theSavedCheckpoint->getRunState())) {
+         std::cout << "ERROR - failed to restore the run from the checkpoint" << std::endl;
+         exit(-1);
+      }
+      theNextSimIndex = theNextSimToReduce;
+   }
+}
+
+// Executes every replication and returns once all of them have been reduced.
+void ReplicationRunner::run() {
+   unsigned int workerCount = determineWorkerCount();
+   if (theConfigObj->isStoppingEnabled()) {
+      CLog::write(CLog::METRICS, "Running up to %u simulations on %u worker thread(s), stopping once the %g%% "
+                                 "confidence intervals are within %g%% of their means.\n", 
+                                 theConfigObj->getSimulationCount(), 
+                                 workerCount, 
+                                 100 * theConfigObj->getStopConfidence(), 
+                                 100 * theConfigObj->getStopRelativeHalfWidth());
+   }
+   else {
+      CLog::write(CLog::METRICS, "Running %u simulations on %u worker thread(s).\n", 
+                                 theConfigObj->getSimulationCount(), 
+                                 workerCount);
+   }
+   if (LANE_ENGINE == theConfigObj->getEngineType()) {
+      CLog::write(CLog::METRICS, "Stepping %d simulations at a time per worker (%s lane scan).\n", 
+                                 LANE_COUNT, 
+                                 LaneEngine::getScanInstructionSet());
+   }
+   
+   // The checkpoint thread sleeps between checkpoints, so it does not take a worker's place.
+   Checkpointer checkpointer(workerCount);
+   std::thread checkpointThread;
+   if (theConfigObj->isCheckpointEnabled()) {
+      theCheckpointer = &checkpointer;
+      checkpointThread = std::thread(&ReplicationRunner::checkpointLoop, this);
+   }
+   
+   // The calling thread acts as the last worker.
+   void (ReplicationRunner::*workerBody)() = &ReplicationRunner::workerLoop;
+   if (LANE_ENGINE == theConfigObj->getEngineType()) {
+      workerBody = &ReplicationRunner::laneWorkerLoop;
+   }
+   std::vector<std::thread> workers;
+   for (unsigned int workerIndex = 1; workerIndex < workerCount; workerIndex++) {
+      workers.push_back(std::thread(workerBody, this));
+   }
+   (this->*workerBody)();
+   
+   for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); it++) {
+      it->join();
+   }
+   
+   if (checkpointThread.joinable()) {
+      {
+         std::lock_guard<std::mutex> lock(theCheckpointMutex);
+         theCheckpointsStopped = true;
+      }
+      theCheckpointCondition.notify_all();
+      checkpointThread.join();
+      theCheckpointer = NULL;
+   }
+   
+   if (theConfigObj->isStoppingEnabled()) {
+      CLog::write(CLog::METRICS, "Stopped after %u simulations: %s.\n", 
+                                 theNextSimToReduce, 
+                                 theStoppingRule.isSatisfied() ? "the confidence targets were met" 
+                                                               : "SIMULATION_COUNT was reached first");
+   }
+}
+
+// Returns the count of worker threads that run() will use.
+unsigned int ReplicationRunner::determineWorkerCount() {
+   // Verbose logging traces every time slot, which is only readable from a single worker.
+   if (theConfigObj->getVerboseEnabled()) {
+      return 1;
+   }
+   
+   unsigned int workerCount = theConfigObj->getThreadCount();
+   if (0 == workerCount) {
+      workerCount = std::thread::hardware_concurrency();
+   }
+   
+   // There is no use for more workers than replications (or than groups of LANE_COUNT replications, with the lane 
+   // engine).
+   unsigned int simCount = theConfigObj->getSimulationCount();
+   if (LANE_ENGINE == theConfigObj->getEngineType()) {
+      simCount = (simCount + LANE_COUNT - 1) / LANE_COUNT;
+   }
+   workerCount = std::min(workerCount, simCount);
+   return std::max(workerCount, 1u);
+}
+
+// Returns the stopping rule, or NULL unless STOP_STATISTICS is configured.
+StoppingRule* ReplicationRunner::getStoppingRule() {
+   return theConfigObj->isStoppingEnabled() ? &theStoppingRule : NULL;
+}
+
+// Returns the count of replications reduced. It is kept apart from the configuration, which the workers share 
+// read-only.
+unsigned int ReplicationRunner::getReducedCount() {
+   return theNextSimToReduce;
+}
+
+// Body of each worker thread. Claims replication indexes until none remain.
+void ReplicationRunner::workerLoop() {
+   // Each worker owns its simulation state; only the configuration is shared.
+   Simulation simulation(theConfigObj);
+   std::vector<Metric> nodeMetrics;
+   std::vector<Metric> channelMetrics;
+   simulation.setCheckpointer(theCheckpointer);
+   
+   for (unsigned int simIndex = theNextSimIndex++; simIndex < theSimLimit; simIndex = theNextSimIndex++) {
+      // Replications awaiting reduction in the checkpoint resumed from are already done.
+      if (theResumedSimIndexes.count(simIndex) > 0) {
+         continue;
+      }
+      
+      StateBuffer* savedState = NULL;
+      if (NULL != theSavedCheckpoint) {
+         savedState = theSavedCheckpoint->findReplicationState(simIndex);
+      }
+      simulation.runReplication(simIndex, theConfigObj->getSeed(), nodeMetrics, channelMetrics, savedState);
+      submitResults(simIndex, nodeMetrics, channelMetrics);
+   }
+   simulation.retireFromCheckpoints();
+}
+
+// Body of each worker thread with ENGINE=lanes. Claims LANE_COUNT consecutive replication indexes at a time and runs 
+// them together; their results are reduced in replication order like any other. Replications claimed past the count 
+// needed are cut from the group, and those the stopping rule no longer needs by the time they finish are dropped.
+void ReplicationRunner::laneWorkerLoop() {
+   LaneEngine laneEngine(theConfigObj);
+   std::vector<Metric> nodeMetrics[LANE_COUNT];
+   std::vector<Metric> channelMetrics[LANE_COUNT];
+   
+   for (unsigned int firstSimIndex = theNextSimIndex.fetch_add(LANE_COUNT); firstSimIndex < theSimLimit; 
+        firstSimIndex = theNextSimIndex.fetch_add(LANE_COUNT)) {
+      int laneCount = static_cast<int>(std::min<unsigned int>(LANE_COUNT, theSimLimit - firstSimIndex));
+      laneEngine.runReplications(firstSimIndex, laneCount, theConfigObj->getSeed(), nodeMetrics, channelMetrics);
+      for (int lane = 0; lane < laneCount; lane++) {
+         submitResults(firstSimIndex + lane, nodeMetrics[lane], channelMetrics[lane]);
+      }
+   }
+}
+
+// Hands a finished replication to the reducer. Results are printed and accumulated strictly in replication order so 
+// that the output does not depend on the count of workers. The stopping rule sees the replications in the same order, 
+// so the replication it stops at does not either.
+void ReplicationRunner::submitResults(unsigned int simIndex, std::vector<Metric>& nodeMetrics, 
+                                      std::vector<Metric>& channelMetrics) {
+   std::lock_guard<std::mutex> lock(theResultMutex);
+   
+   // Drop replications that were already running when the stopping rule was satisfied.
+   if (simIndex >= theSimLimit) {
+      return;
+   }
+   thePendingResults[simIndex].swap(nodeMetrics);
+   thePendingChannelResults[simIndex].swap(channelMetrics);
+   
+   // Reduce every replication that is now next in line.
+   std::map<unsigned int, std::vector<Metric> >::iterator it = thePendingResults.find(theNextSimToReduce);
+   while (it != thePendingResults.end()) {
+      // Report the metrics.
+      theResultSink->writeReplication(0, theNextSimToReduce, it->second);
+      
+      // Copy over the metrics from this simulation.
+      copyMetrics(*theNodeTotalMetrics, it->second);
+      copyMetrics(*theChannelTotalMetrics, thePendingChannelResults[theNextSimToReduce]);
+      
+      // Update the confidence intervals, and stop claiming replications once they are narrow enough.
+      if (theConfigObj->isStoppingEnabled()) {
+         theStoppingRule.addReplication(theConfigObj, it->second);
+         if (theStoppingRule.isSatisfied()) {
+            theSimLimit = theNextSimToReduce + 1;
+         }
+      }
+      
+      thePendingResults.erase(it);
+      thePendingChannelResults.erase(theNextSimToReduce);
+      if (++theNextSimToReduce >= theSimLimit) {
+         thePendingResults.clear();
+         thePendingChannelResults.clear();
+         break;
+      }
+      it = thePendingResults.find(theNextSimToReduce);
+   }
+}
+
+// Body of the checkpoint thread. Takes a checkpoint every CHECKPOINT_INTERVAL seconds until the run ends.
+void ReplicationRunner::checkpointLoop() {
+   std::chrono::seconds interval(theConfigObj->getCheckpointInterval());
+   std::unique_lock<std::mutex> lock(theCheckpointMutex);
+   while (!theCheckpointCondition.wait_for(lock, interval, [this] { return theCheckpointsStopped; })) {
+      lock.unlock();
+      writeCheckpoint();
+      lock.lock();
+   }
+}
+
+// Takes a checkpoint of the run and writes it to CHECKPOINT_FILE. The workers are only held up long enough to copy 
+// their replications, and the reducer long enough to copy its state; the file is written without either.
+void ReplicationRunner::writeCheckpoint() {
+   Checkpoint checkpoint(theConfigObj);
+   theCheckpointer->collectSnapshots(checkpoint.getReplicationStates());
+   unsigned int reducedSimCount = 0;
+   {
+      std::lock_guard<std::mutex> lock(theResultMutex);
+      saveRunState(checkpoint.getRunState());
+      reducedSimCount = theNextSimToReduce;
+   }
+   if (checkpoint.writeFile(theConfigObj->getCheckpointFile())) {
+      CLOG_WRITE(CLog::VERBOSE, "Checkpointed %u simulations and %u in flight.\n", 
+                                reducedSimCount, 
+                                static_cast<unsigned int>(checkpoint.getReplicationStates().size()));
+   }
+}
+
+// Appends the reduction state to state: the replications reduced, the length of the results written for them, the 
+// node and channel totals, the replications awaiting reduction and the stopping rule. Must be called while holding 
+// theResultMutex.
+void ReplicationRunner::saveRunState(StateBuffer& state) {
+   state.appendValue(theNextSimToReduce);
+   state.appendValue(theSimLimit.load());
+   state.appendValue(theResultSink->markCheckpoint());
+   
+   state.appendValue<uint64_t>(theNodeTotalMetrics->size());
+   for (unsigned int nodeIndex = 0; nodeIndex < theNodeTotalMetrics->size(); nodeIndex++) {
+      (*theNodeTotalMetrics)[nodeIndex].saveState(state);
+   }
+   saveMetrics(state, *theChannelTotalMetrics);
+   
+   state.appendValue<uint64_t>(thePendingResults.size());
+   for (std::map<unsigned int, std::vector<Metric> >::iterator it = thePendingResults.begin(); 
+        it != thePendingResults.end(); 
+        it++) {
+      state.appendValue(it->first);
+      state.appendValue<uint64_t>(it->second.size());
+      for (unsigned int nodeIndex = 0; nodeIndex < it->second.size(); nodeIndex++) {
+         it->second[nodeIndex].saveState(state);
+      }
+      saveMetrics(state, thePendingChannelResults[it->first]);
+   }
+   
+   theStoppingRule.saveState(state);
+}
+
+// Reads back the reduction state saved by saveRunState(), and cuts the results back to the checkpoint. Returns false 
+// if state is too short or does not match the run.
+bool ReplicationRunner::restoreRunState(StateBuffer& state) {
+   unsigned int simLimit = 0;
+   uint64_t resultByteCount = 0, nodeCount = 0, pendingCount = 0;
+   if (!state.readValue(theNextSimToReduce) 
+    || !state.readValue(simLimit) 
+    || !state.readValue(resultByteCount) 
+    || !state.readValue(nodeCount) 
+    || nodeCount != theNodeTotalMetrics->size()) {
+      return false;
+   }
+   theSimLimit = simLimit;
+   
+   for (unsigned int nodeIndex = 0; nodeIndex < theNodeTotalMetrics->size(); nodeIndex++) {
+      if (!(*theNodeTotalMetrics)[nodeIndex].restoreState(state)) {
+         return false;
+      }
+   }
+   if (!restoreMetrics(state, *theChannelTotalMetrics)) {
+      return false;
+   }
+   
+   if (!state.readValue(pendingCount)) {
+      return false;
+   }
+   for (uint64_t pendingIndex = 0; pendingIndex < pendingCount; pendingIndex++) {
+      unsigned int simIndex = 0;
+      uint64_t metricCount = 0;
+      if (!state.readValue(simIndex) || !state.readValue(metricCount)) {
+         return false;
+      }
+      std::vector<Metric>& nodeMetrics = thePendingResults[simIndex];
+      nodeMetrics.resize(metricCount);
+      for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+         if (!nodeMetrics[nodeIndex].restoreState(state)) {
+            return false;
+         }
+      }
+      if (!restoreMetrics(state, thePendingChannelResults[simIndex])) {
+         return false;
+      }
+      theResumedSimIndexes.insert(simIndex);
+   }
+   
+   return theStoppingRule.restoreState(state) && theResultSink->resumeFromCheckpoint(resultByteCount);
+}
@@ -0,0 +1,118 @@
+/*
+ * Declaration of the ReplicationRunner class. A class used to execute the configured replications on a pool of 
+ * worker threads and to reduce their node and channel metrics, in replication order, into the overall totals. With 
+ * STOP_STATISTICS configured, SIMULATION_COUNT is a cap: the run ends at the first replication that satisfies the 
+ * stopping rule. With CHECKPOINT_FILE configured, a background thread checkpoints the run every CHECKPOINT_INTERVAL 
+ * seconds (see checkpoint.h), and a run constructed from a checkpoint carries on exactly where it was saved.
+ */
+
+#ifndef __REPLICATION_H__
+#define __REPLICATION_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "helpers.h"
+#include "checkpoint.h"
+#include "resultsink.h"
+#include "stopping.h"
+
+class ReplicationRunner {
+   public:
+      // Constructor with args. With savedCheckpoint (NULL otherwise), the run resumes from the checkpoint, whose 
+      // replication states must outlive the run.
+      ReplicationRunner(Configuration* configObj, std::vector<Metric>& nodeTotalMetrics, 
+                        std::vector<Metric>& channelTotalMetrics, ResultSink* resultSink, 
+                        Checkpoint* savedCheckpoint);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Executes every replication and returns once all of them have been reduced.
+      void run();
+      
+      // Returns the count of worker threads that run() will use.
+      unsigned int determineWorkerCount();
+      
+      // Returns the stopping rule, or NULL unless STOP_STATISTICS is configured.
+      StoppingRule* getStoppingRule();
+      
+      // Returns the count of replications reduced, which the stopping rule may have cut short of SIMULATION_COUNT.
+      unsigned int getReducedCount();
+   
+   private:
+      // Body of each worker thread. Claims replication indexes until none remain.
+      void workerLoop();
+      
+      // Body of each worker thread with ENGINE=lanes. Claims LANE_COUNT replication indexes at a time until none 
+      // remain.
+      void laneWorkerLoop();
+      
+      // Hands a finished replication to the reducer. Results are printed and accumulated strictly in replication 
+      // order so that the output does not depend on the count of workers.
+      void submitResults(unsigned int simIndex, std::vector<Metric>& nodeMetrics, std::vector<Metric>& channelMetrics);
+      
+      // Body of the checkpoint thread. Takes a checkpoint every CHECKPOINT_INTERVAL seconds until the run ends.
+      void checkpointLoop();
+      
+      // Takes a checkpoint of the run and writes it to CHECKPOINT_FILE.
+      void writeCheckpoint();
+      
+      // Appends the reduction state to state. Must be called while holding theResultMutex.
+      void saveRunState(StateBuffer& state);
+      
+      // Reads back the reduction state saved by saveRunState(). Returns false if state is too short.
+      bool restoreRunState(StateBuffer& state);
+      
+      // Configuration shared (read-only) by every worker.
+      Configuration* theConfigObj;
+      
+      // Per-node totals across all replications. Only modified while holding theResultMutex.
+      std::vector<Metric>* theNodeTotalMetrics;
+      
+      // Per-channel totals across all replications. Only modified while holding theResultMutex.
+      std::vector<Metric>* theChannelTotalMetrics;
+      
+      // Receives each replication's metrics. Only used while holding theResultMutex.
+      ResultSink* theResultSink;
+      
+      // Decides when enough replications have been reduced. Only used while holding theResultMutex.
+      StoppingRule theStoppingRule;
+      
+      // Index of the next replication to be claimed by a worker.
+      std::atomic<unsigned int> theNextSimIndex;
+      
+      // Count of replications needed: SIMULATION_COUNT until the stopping rule is satisfied.
+      std::atomic<unsigned int> theSimLimit;
+      
+      // Guards the reduction state below.
+      std::mutex theResultMutex;
+      
+      // Index of the next replication to be reduced.
+      unsigned int theNextSimToReduce;
+      
+      // Finished replications waiting on an earlier replication before being reduced, and their channel metrics.
+      std::map<unsigned int, std::vector<Metric> > thePendingResults;
+      std::map<unsigned int, std::vector<Metric> > thePendingChannelResults;
+      
+      // Checkpoint the run resumed from, NULL for a fresh run.
+      Checkpoint* theSavedCheckpoint;
+      
+      // Replications that were awaiting reduction in the checkpoint resumed from, which are not run again.
+      std::set<unsigned int> theResumedSimIndexes;
+      
+      // Coordinates the workers with the checkpoint thread, NULL unless CHECKPOINT_FILE is configured.
+      Checkpointer* theCheckpointer;
+      
+      // Guards theCheckpointsStopped, signalled when the run ends.
+      std::mutex theCheckpointMutex;
+      std::condition_variable theCheckpointCondition;
+      
+      // True once the checkpoint thread must end.
+      bool theCheckpointsStopped;
+};
+
+#endif   // __REPLICATION_H__
@@ -0,0 +1,343 @@
+/*
+ * Implementation of the report helper functions. Used to accumulate and print the per-node metrics.
+ */
+
+#include <cmath>    // fabs
+
+#include "report.h"
+
+// Helper function used to copy over the node data from one simulation.
+void copyMetrics(std::vector<Metric>& nodeTotalMetrics, std::vector<Metric>& nodeMetrics) {
+   for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+      // Save off copies of relevant data for ease of access.
+      Metric* nodeMetricCopy = &nodeMetrics[nodeIndex];
+      
+      // Clock cycles idle.
+      uint64_t lastValue = nodeTotalMetrics[nodeIndex].getClockCyclesIdle();
+      nodeTotalMetrics[nodeIndex].setClockCyclesIdle(lastValue + nodeMetricCopy->getClockCyclesIdle());
+      
+      // Clock cycles transmitting.
+      lastValue = nodeTotalMetrics[nodeIndex].getClockCyclesTransmitting();
+      nodeTotalMetrics[nodeIndex].setClockCyclesTransmitting(lastValue 
+                                                             + nodeMetricCopy->getClockCyclesTransmitting());
+      
+      // Count of messages generated.
+      lastValue = nodeTotalMetrics[nodeIndex].getCountOfMessagesGenerated();
+      nodeTotalMetrics[nodeIndex].setCountOfMessagesGenerated(lastValue 
+                                                              + nodeMetricCopy->getCountOfMessagesGenerated());
+      
+      // Count of transmission attempts.
+      lastValue = nodeTotalMetrics[nodeIndex].getCountOfTransmissionAttempts();
+      nodeTotalMetrics[nodeIndex].setCountOfTransmissionAttempts(lastValue 
+                                                                 + nodeMetricCopy->getCountOfTransmissionAttempts());
+      
+      // Count of collisions.
+      lastValue = nodeTotalMetrics[nodeIndex].getCountOfCollisions();
+      nodeTotalMetrics[nodeIndex].setCountOfCollisions(lastValue 
+                                                       + nodeMetricCopy->getCountOfCollisions());
+      
+      // Count of messages dropped.
+      lastValue = nodeTotalMetrics[nodeIndex].getCountOfMessagesDropped();
+      nodeTotalMetrics[nodeIndex].setCountOfMessagesDropped(lastValue 
+                                                            + nodeMetricCopy->getCountOfMessagesDropped());
+      
+      // Count of messages transmitted.
+      lastValue = nodeTotalMetrics[nodeIndex].getCountOfMessagesTransmitted();
+      nodeTotalMetrics[nodeIndex].setCountOfMessagesTransmitted(lastValue 
+                                                                + nodeMetricCopy->getCountOfMessagesTransmitted());
+      
+      // Time slots messages spent waiting to be transmitted (time of completion - time of creation).
+      nodeTotalMetrics[nodeIndex].updateTimeMessagesWaited(nodeMetricCopy->getTimeMessagesWaited());
+      
+      // Maximum count of retransmission attempts.
+      lastValue = nodeTotalMetrics[nodeIndex].getMaximumRetransmissionAttempts();
+      nodeTotalMetrics[nodeIndex].setMaximumRetransmissionAttempts(lastValue 
+                                                                   + nodeMetricCopy->getMaximumRetransmissionAttempts());
+      
+      // Distributions of the message delays and retransmission counts.
+      nodeTotalMetrics[nodeIndex].getMessageDelayHistogram().merge(nodeMetricCopy->getMessageDelayHistogram());
+      nodeTotalMetrics[nodeIndex].getRetransmissionHistogram().merge(nodeMetricCopy->getRetransmissionHistogram());
+   }
+}
+
+// Helper function used to print the data from one simulation.
+void printSimulationMetrics(std::vector<Metric>& nodeMetrics, unsigned int simIndex) {
+   CLog::write(CLog::METRICS, "[sim %d node metrics]\n", simIndex);
+   for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+      Metric* nodeMetric = &nodeMetrics[nodeIndex];
+      CLog::write(CLog::METRICS, 
+                 "   [node %d]\n", 
+                 nodeIndex);
+      CLog::write(CLog::METRICS, 
+                 "      time slots idle: %llu\n", 
+                 static_cast<unsigned long long>(nodeMetric->getClockCyclesIdle()));
+      CLog::write(CLog::METRICS,
+                 "      time slots transmitting: %llu\n", 
+                 static_cast<unsigned long long>(nodeMetric->getClockCyclesTransmitting()));
+      CLog::write(CLog::METRICS,
+                 "      messages generated: %llu\n",
+                 static_cast<unsigned long long>(nodeMetric->getCountOfMessagesGenerated()));
+      CLog::write(CLog::METRICS,
+                 "      tranmissions attempted: %llu\n",
+                 static_cast<unsigned long long>(nodeMetric->getCountOfTransmissionAttempts()));
+      CLog::write(CLog::METRICS,
+                 "      collisions occurred: %llu\n", 
+                 static_cast<unsigned long long>(nodeMetric->getCountOfCollisions()));
+      CLog::write(CLog::METRICS,
+                 "      messages dropped: %llu\n", 
+                 static_cast<unsigned long long>(nodeMetric->getCountOfMessagesDropped()));
+      CLog::write(CLog::METRICS,
+                 "      messages transmitted: %llu\n",
+                 static_cast<unsigned long long>(nodeMetric->getCountOfMessagesTransmitted()));
+      CLog::write(CLog::METRICS,
+                 "      time slots messages spent waiting: %llu\n",
+                 static_cast<unsigned long long>(nodeMetric->getTimeMessagesWaited()));
+      CLog::write(CLog::METRICS,
+                 "      maximum retransmission attempts: %llu\n", 
+                 static_cast<unsigned long long>(nodeMetric->getMaximumRetransmissionAttempts()));
+      CLog::write(CLog::METRICS, "\n");
+   }
+}
+
+// Helper function used to print the REPORTED_QUANTILES of histogram.
+static void printQuantiles(const char* label, Histogram& histogram) {
+   CLog::write(CLog::METRICS, "     %s at", label);
+   for (int quantileIndex = 0; quantileIndex < REPORTED_QUANTILE_COUNT; quantileIndex++) {
+      CLog::write(CLog::METRICS, "%s p%g: %llu", 
+                                 0 == quantileIndex ? "" : ",", 
+                                 100 * REPORTED_QUANTILES[quantileIndex], 
+                                 static_cast<unsigned long long>(
+                                    histogram.getValueAtQuantile(REPORTED_QUANTILES[quantileIndex])));
+   }
+   CLog::write(CLog::METRICS, "\n");
+}
+
+// Helper functions used to print the overall metrics for the entire execution.
+void printOverallMetrics(std::vector<Metric>& nodeTotalMetrics, Configuration* configObj, unsigned int simCount) {
+   // Determine looping conditions.
+   int arraySize = configObj->getNodeCount();
+   unsigned long timeSlots = configObj->getTimeSlotCount();
+   
+   CLog::write(CLog::METRICS, "[averages over %u simulations of %lu timeslots]\n", simCount, timeSlots); 
+   
+   // Loop through the nodes.
+   for (int nodeIndex = 0; nodeIndex < arraySize; nodeIndex++) {
+      CLog::write(CLog::METRICS, "   [node %d]\n", nodeIndex);
+                 
+      // Time slots idle.
+      double value = ((double )nodeTotalMetrics[nodeIndex].getClockCyclesIdle()/(double )simCount);
+      CLog::write(CLog::METRICS, "     time slots idle: %.2f (%.4f of clock cycles)\n", 
+                                 value, 
+                                 (value/(double )timeSlots));
+      
+      // Time slots transmitting.
+      double avgMessagesTransmitted = ((double )nodeTotalMetrics[nodeIndex].getClockCyclesTransmitting()/(double )simCount);
+      CLog::write(CLog::METRICS, "     time slots transmitting: %.2f (%.4f of clock cycles)\n", 
+                                 avgMessagesTransmitted, 
+                                 (avgMessagesTransmitted/(double )timeSlots));
+      
+      // Count of messages generated.
+      double avgMessagesGenerated = ((double )nodeTotalMetrics[nodeIndex].getCountOfMessagesGenerated()/(double)simCount);
+      CLog::write(CLog::METRICS, "     messages generated: %.2f (%.4f of clock cycles)\n", 
+                                 avgMessagesGenerated, 
+                                 ((double )avgMessagesGenerated/(double )timeSlots));
+      
+      // Count of transmission attempts.
+      double avgTransmissionAttempts = ((double )nodeTotalMetrics[nodeIndex].getCountOfTransmissionAttempts()/(double )simCount);
+      CLog::write(CLog::METRICS, "     transmission attempts: %.2f\n", 
+                                 avgTransmissionAttempts);
+      
+      // Count of collisions.
+      value = ((double )nodeTotalMetrics[nodeIndex].getCountOfCollisions()/(double )simCount);
+      CLog::write(CLog::METRICS, "     collisions: %.2f (%.4f of transmission attempts)\n", 
+                                 value, 
+                                 (value/(double )avgTransmissionAttempts));
+      CLog::write(CLog::METRICS, "                       (%.4f of clock cycles)\n",
+                                 (value/(double )timeSlots));
+      
+      // Count of messages dropped.
+      value = ((double )nodeTotalMetrics[nodeIndex].getCountOfMessagesDropped()/(double )simCount);
+      CLog::write(CLog::METRICS, "     messages dropped: %.2f (%.4f of messages generated)\n", 
+                                 value, 
+                                 ((double )value/(double )avgMessagesGenerated));
+      
+      // Count of messages transmitted.
+      value = ((double )nodeTotalMetrics[nodeIndex].getCountOfMessagesTransmitted()/(double )simCount);
+      CLog::write(CLog::METRICS, "     messages transmitted: %.2f (%.4f of messages generated)\n", 
+                                 value, 
+                                 ((double )value/(double )avgMessagesGenerated));
+                                 
+      // Time slots messages spent waiting to be transmitted (time of completion - time of creation).
+      value = ((double )nodeTotalMetrics[nodeIndex].getTimeMessagesWaited()/(double )simCount);
+      CLog::write(CLog::METRICS, "     time slots messages waited: %.2f (%.2f per message transmitted)\n", 
+                                 value, 
+                                 ((double )value/(double )avgMessagesTransmitted));
+      
+      // Maximum count of retransmission attempts.
+      value = ((double )nodeTotalMetrics[nodeIndex].getMaximumRetransmissionAttempts()/(double )simCount);
+      CLog::write(CLog::METRICS, "     maximum retransmissions required before any one message was sent: %.0f\n", 
+                                 value);
+      
+      // Quantiles of the delays and retransmission counts, over the messages of every simulation.
+      printQuantiles("time slots messages waited", nodeTotalMetrics[nodeIndex].getMessageDelayHistogram());
+      printQuantiles("retransmissions per message transmitted", 
+                     nodeTotalMetrics[nodeIndex].getRetransmissionHistogram());
+                                 
+      CLog::write(CLog::METRICS, "\n");
+   }
+}
+
+
+// Helper function used to print the per-channel and all-channel metrics for the entire execution, averaged over the 
+// simulations. A channel counts what happens on it (see NodeStore::collectChannelMetrics()), so a node that switches 
+// channels adds to each channel it used.
+void printChannelMetrics(std::vector<Metric>& channelTotalMetrics, Configuration* configObj, unsigned int simCount) {
+   unsigned long timeSlots = configObj->getTimeSlotCount();
+   int frameLength = configObj->getFrameLength();
+   
+   CLog::write(CLog::METRICS, "[channel averages over %u simulations of %lu timeslots, %s channel selection]\n", 
+                              simCount, 
+                              timeSlots, 
+                              STATIC_CHANNELS == configObj->getChannelSelection() ? "static" : "random");
+   
+   // Loop through the channels, then print their sums.
+   uint64_t allAttempts = 0, allCollisions = 0, allTransmitted = 0, allBusySlots = 0;
+   for (unsigned int channelIndex = 0; channelIndex <= channelTotalMetrics.size(); channelIndex++) {
+      uint64_t attempts = allAttempts, collisions = allCollisions;
+      uint64_t transmitted = allTransmitted, busySlots = allBusySlots;
+      if (channelIndex < channelTotalMetrics.size()) {
+         CLog::write(CLog::METRICS, "   [channel %u]\n", channelIndex);
+         attempts = channelTotalMetrics[channelIndex].getCountOfTransmissionAttempts();
+         collisions = channelTotalMetrics[channelIndex].getCountOfCollisions();
+         transmitted = channelTotalMetrics[channelIndex].getCountOfMessagesTransmitted();
+         busySlots = channelTotalMetrics[channelIndex].getClockCyclesTransmitting();
+         allAttempts += attempts;
+         allCollisions += collisions;
+         allTransmitted += transmitted;
+         allBusySlots += busySlots;
+      }
+      else {
+         CLog::write(CLog::METRICS, "   [all channels]\n");
+      }
+      
+      // Count of transmission attempts.
+      double avgTransmissionAttempts = (double )attempts / simCount;
+      CLog::write(CLog::METRICS, "     transmission attempts: %.2f\n", 
+                                 avgTransmissionAttempts);
+      
+      // Count of collisions.
+      double value = (double )collisions / simCount;
+      CLog::write(CLog::METRICS, "     collisions: %.2f (%.4f of transmission attempts)\n", 
+                                 value, 
+                                 value / avgTransmissionAttempts);
+      
+      // Count of messages transmitted, and the share of the time slots their frames took.
+      value = (double )transmitted / simCount;
+      CLog::write(CLog::METRICS, "     messages transmitted: %.2f (throughput %.4f)\n", 
+                                 value, 
+                                 value * frameLength / timeSlots);
+      
+      // Time slots the channel was sensed busy (summed over the channels for all of them).
+      value = (double )busySlots / simCount;
+      CLog::write(CLog::METRICS, "     time slots sensed busy: %.2f (%.4f of clock cycles)\n", 
+                                 value, 
+                                 value / timeSlots);
+      CLog::write(CLog::METRICS, "\n");
+   }
+}
+
+// Helper function used to print the confidence intervals reached by the stopping rule, and whether they met the 
+// target.
+void printConfidenceIntervals(StoppingRule& stoppingRule) {
+   CLog::write(CLog::METRICS, "[%g%% confidence intervals over %u simulations]\n", 
+                              100 * stoppingRule.getConfidence(), 
+                              stoppingRule.getReplicationCount());
+   for (unsigned int statisticIndex = 0; statisticIndex < stoppingRule.getStatistics().size(); statisticIndex++) {
+      double mean = stoppingRule.getMean(statisticIndex);
+      double halfWidth = stoppingRule.getHalfWidth(statisticIndex);
+      CLog::write(CLog::METRICS, "     %s: %.6g +/- %.6g (%.2f%% of the mean)\n", 
+                                 StoppingRule::getStatisticName(stoppingRule.getStatistics()[statisticIndex]), 
+                                 mean, 
+                                 halfWidth, 
+                                 100 * halfWidth / fabs(mean));
+   }
+   CLog::write(CLog::METRICS, "     target of +/- %.2f%% of the mean: %s\n", 
+                              100 * stoppingRule.getRelativeHalfWidth(), 
+                              stoppingRule.isSatisfied() ? "met" : "not met within SIMULATION_COUNT");
+   CLog::write(CLog::METRICS, "\n");
+}
+
+// Helper function used to print the column names of the sweep result rows. With a stopping rule, each row also has 
+// the count of simulations run and the half-width of each statistic's confidence interval.
+void printSweepHeader(Configuration* configObj) {
+   CLog::write(CLog::METRICS, "point,PROTOCOL_TYPE,NODE_COUNT,PROB_FRAME_GENERATION,PROB_PERSISTENCE,FRAME_LENGTH,"
+                              "MAX_RETRANSMIT_ATTEMPTS,offered_load,throughput,mean_delay,collisions_per_attempt,"
+                              "drop_ratio");
+   for (int quantileIndex = 0; quantileIndex < REPORTED_QUANTILE_COUNT; quantileIndex++) {
+      CLog::write(CLog::METRICS, ",delay_%s", REPORTED_QUANTILE_NAMES[quantileIndex]);
+   }
+   for (int quantileIndex = 0; quantileIndex < REPORTED_QUANTILE_COUNT; quantileIndex++) {
+      CLog::write(CLog::METRICS, ",retransmissions_%s", REPORTED_QUANTILE_NAMES[quantileIndex]);
+   }
+   if (configObj->isStoppingEnabled()) {
+      CLog::write(CLog::METRICS, ",simulations");
+      std::vector<STOP_STATISTIC> statistics = configObj->getStopStatistics();
+      for (unsigned int statisticIndex = 0; statisticIndex < statistics.size(); statisticIndex++) {
+         CLog::write(CLog::METRICS, ",%s_half_width", StoppingRule::getStatisticName(statistics[statisticIndex]));
+      }
+   }
+   CLog::write(CLog::METRICS, "\n");
+}
+
+// Helper function used to print the result row of one sweep point, aggregated over its nodes and replications. The 
+// offered load and throughput are in frames' worth of time slots per time slot; the mean delay is in time slots per 
+// message transmitted. The delay and retransmission quantiles pool the messages of every node.
+void printSweepRow(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                   std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule) {
+   double generated = 0, transmitted = 0, attempts = 0, collisions = 0, dropped = 0, waited = 0;
+   Histogram delayHistogram, retransmissionHistogram;
+   for (int nodeIndex = 0; nodeIndex < pointConfigObj->getNodeCount(); nodeIndex++) {
+      generated += nodeTotalMetrics[nodeIndex].getCountOfMessagesGenerated();
+      transmitted += nodeTotalMetrics[nodeIndex].getCountOfMessagesTransmitted();
+      attempts += nodeTotalMetrics[nodeIndex].getCountOfTransmissionAttempts();
+      collisions += nodeTotalMetrics[nodeIndex].getCountOfCollisions();
+      dropped += nodeTotalMetrics[nodeIndex].getCountOfMessagesDropped();
+      waited += nodeTotalMetrics[nodeIndex].getTimeMessagesWaited();
+      delayHistogram.merge(nodeTotalMetrics[nodeIndex].getMessageDelayHistogram());
+      retransmissionHistogram.merge(nodeTotalMetrics[nodeIndex].getRetransmissionHistogram());
+   }
+   
+   const char* protocolNames[] = { "Non-Persistent", "1-Persistent", "p-Persistent", "CSMA/CD", "CSMA/CA" };
+   double slotCount = static_cast<double>(pointConfigObj->getTimeSlotCount()) * simCount;
+   int frameLength = pointConfigObj->getFrameLength();
+   CLog::write(CLog::METRICS, "%u,%s,%d,%g,%g,%d,%d,%.6f,%.6f,%.4f,%.6f,%.6f", 
+                              pointIndex, 
+                              protocolNames[pointConfigObj->getCsmaType()], 
+                              pointConfigObj->getNodeCount(), 
+                              pointConfigObj->getProbFrameGeneration(), 
+                              pointConfigObj->getProbOfPersistance(), 
+                              frameLength, 
+                              pointConfigObj->getMaxBackoffRetransmitCount(), 
+                              generated * frameLength / slotCount, 
+                              transmitted * frameLength / slotCount, 
+                              transmitted > 0 ? waited / transmitted : 0.0, 
+                              attempts > 0 ? collisions / attempts : 0.0, 
+                              generated > 0 ? dropped / generated : 0.0);
+   for (int quantileIndex = 0; quantileIndex < REPORTED_QUANTILE_COUNT; quantileIndex++) {
+      CLog::write(CLog::METRICS, ",%llu", 
+                                 static_cast<unsigned long long>(
+                                    delayHistogram.getValueAtQuantile(REPORTED_QUANTILES[quantileIndex])));
+   }
+   for (int quantileIndex = 0; quantileIndex < REPORTED_QUANTILE_COUNT; quantileIndex++) {
+      CLog::write(CLog::METRICS, ",%llu", 
+                                 static_cast<unsigned long long>(
+                                    retransmissionHistogram.getValueAtQuantile(REPORTED_QUANTILES[quantileIndex])));
+   }
+   if (NULL != stoppingRule) {
+      CLog::write(CLog::METRICS, ",%u", stoppingRule->getReplicationCount());
+      for (unsigned int statisticIndex = 0; statisticIndex < stoppingRule->getStatistics().size(); statisticIndex++) {
+         CLog::write(CLog::METRICS, ",%.6g", stoppingRule->getHalfWidth(statisticIndex));
+      }
+   }
+   CLog::write(CLog::METRICS, "\n");
+}
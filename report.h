@@ -0,0 +1,41 @@
+/*
+ * Declaration of the report helper functions. Used to accumulate and print the per-node metrics.
+ */
+
+#ifndef __REPORT_H__
+#define __REPORT_H__
+
+#include <vector>
+
+#include "helpers.h"
+#include "stopping.h"
+
+// Quantiles reported of the message delay and retransmission histograms, and their names in the result columns.
+static const int REPORTED_QUANTILE_COUNT = 3;
+static const double REPORTED_QUANTILES[REPORTED_QUANTILE_COUNT] = { 0.5, 0.99, 0.999 };
+static const char* const REPORTED_QUANTILE_NAMES[REPORTED_QUANTILE_COUNT] = { "p50", "p99", "p999" };
+
+// Helper function used to copy over the node data from one simulation.
+void copyMetrics(std::vector<Metric>& nodeTotalMetrics, std::vector<Metric>& nodeMetrics);
+
+// Helper function used to print the data from one simulation.
+void printSimulationMetrics(std::vector<Metric>& nodeMetrics, unsigned int simIndex);
+
+// Helper functions used to print the overall metrics for the entire execution.
+void printOverallMetrics(std::vector<Metric>& nodeTotalMetrics, Configuration* configObj, unsigned int simCount);
+
+// Helper function used to print the per-channel and all-channel metrics for the entire execution (CHANNEL_COUNT > 1).
+void printChannelMetrics(std::vector<Metric>& channelTotalMetrics, Configuration* configObj, unsigned int simCount);
+
+// Helper function used to print the confidence intervals reached by the stopping rule.
+void printConfidenceIntervals(StoppingRule& stoppingRule);
+
+// Helper function used to print the column names of the sweep result rows.
+void printSweepHeader(Configuration* configObj);
+
+// Helper function used to print the result row of one sweep point, aggregated over its nodes and replications. 
+// stoppingRule is NULL unless STOP_STATISTICS is configured.
+void printSweepRow(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                   std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule);
+
+#endif // __REPORT_H__
@@ -0,0 +1,463 @@
+/*
+ * Implementation of the ResultSink classes. Sinks receiving the metrics of each replication and the aggregates.
+ */
+
+#include <algorithm>    // std::min
+#include <cmath>        // std::isfinite
+#include <cstdarg>
+#include <unistd.h>     // ftruncate
+
+#include "resultsink.h"
+#include "report.h"
+
+// Size past which a buffered sink writes its buffer out.
+static const size_t RESULT_BUFFER_THRESHOLD = 1 << 20;
+
+// Count of Metric fields written per node.
+static const int METRIC_FIELD_COUNT = 9;
+
+// Helper function that returns the Metric fields of a node, in the order of the CSV columns.
+static void getMetricFields(Metric& metric, uint64_t fields[METRIC_FIELD_COUNT]) {
+   fields[0] = metric.getClockCyclesIdle();
+   fields[1] = metric.getClockCyclesTransmitting();
+   fields[2] = metric.getCountOfMessagesGenerated();
+   fields[3] = metric.getCountOfTransmissionAttempts();
+   fields[4] = metric.getCountOfCollisions();
+   fields[5] = metric.getCountOfMessagesDropped();
+   fields[6] = metric.getCountOfMessagesTransmitted();
+   fields[7] = metric.getTimeMessagesWaited();
+   fields[8] = metric.getMaximumRetransmissionAttempts();
+}
+
+// Names of the Metric fields, in the order of the CSV columns.
+static const char* METRIC_FIELD_NAMES[METRIC_FIELD_COUNT] = {
+   "slots_idle", "slots_transmitting", "messages_generated", "transmission_attempts", "collisions", 
+   "messages_dropped", "messages_transmitted", "slots_waited", "maximum_retransmissions"
+};
+
+// Count of quantile fields written per node: each reported quantile of the message delays, then of the retransmission 
+// counts.
+static const int QUANTILE_FIELD_COUNT = 2 * REPORTED_QUANTILE_COUNT;
+
+// Helper function that returns the quantile fields of a node, over the messages its metric holds, in the order of the 
+// CSV columns.
+static void getQuantileFields(Metric& metric, uint64_t fields[QUANTILE_FIELD_COUNT]) {
+   for (int quantileIndex = 0; quantileIndex < REPORTED_QUANTILE_COUNT; quantileIndex++) {
+      fields[quantileIndex] = 
+         metric.getMessageDelayHistogram().getValueAtQuantile(REPORTED_QUANTILES[quantileIndex]);
+      fields[REPORTED_QUANTILE_COUNT + quantileIndex] = 
+         metric.getRetransmissionHistogram().getValueAtQuantile(REPORTED_QUANTILES[quantileIndex]);
+   }
+}
+
+// Helper function that returns the name of quantile field field (delay_p50, ..., retransmissions_p999).
+static std::string getQuantileFieldName(int field) {
+   return std::string(field < REPORTED_QUANTILE_COUNT ? "delay_" : "retransmissions_") 
+        + REPORTED_QUANTILE_NAMES[field % REPORTED_QUANTILE_COUNT];
+}
+
+// Creates the sink selected by RESULT_FORMAT. Returns NULL if the RESULT_FILE cannot be opened. A resumed run 
+// (isResuming) opens the existing RESULT_FILE rather than truncating it.
+ResultSink* ResultSink::createResultSink(Configuration* configObj, bool isResuming) {
+   RESULT_FORMAT resultFormat = configObj->getResultFormat();
+   if (TEXT_RESULTS == resultFormat) {
+      return new TextResultSink(configObj->isSweepEnabled());
+   }
+   
+   // A file name of "-" is stdout.
+   std::string resultFile = configObj->getResultFile();
+   FILE* file = stdout;
+   if ("-" != resultFile) {
+      if (isResuming) {
+         file = fopen(resultFile.c_str(), BINARY_RESULTS == resultFormat ? "r+b" : "r+");
+      }
+      else {
+      file = fopen(resultFile.c_str(), BINARY_RESULTS == resultFormat ? "wb" : "w");
+      }
+      if (NULL == file) {
+         std::cout << "ERROR - failed to open RESULT_FILE: " << resultFile << std::endl;
+         return NULL;
+      }
+   }
+   
+   if (CSV_RESULTS == resultFormat) {
+      return new CsvResultSink(file);
+   }
+   else if (JSONL_RESULTS == resultFormat) {
+      return new JsonLinesResultSink(file);
+   }
+   return new BinaryResultSink(file);
+}
+
+/**********************************************
+ * TextResultSink
+ *******************/
+
+// TextResultSink class constructor with args.
+TextResultSink::TextResultSink(bool isSweep) {
+   theSweepEnabled = isSweep;
+}
+
+// Writes the metrics of every node for one replication. Sweeps only report the aggregates.
+void TextResultSink::writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics) {
+   if (theSweepEnabled) {
+      return;
+   }
+   
+   // Show simulation count.
+   CLog::write(CLog::METRICS, "- simulation %u -\n", simIndex);
+   
+   // Report the metrics.
+   printSimulationMetrics(nodeMetrics, simIndex);
+}
+
+// Writes the per-node aggregates over every replication of a point, given the per-node totals.
+void TextResultSink::writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                     std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule) {
+   if (theSweepEnabled) {
+      // Points are reported in order, so the header goes ahead of the first.
+      if (0 == pointIndex) {
+         printSweepHeader(pointConfigObj);
+      }
+      printSweepRow(pointIndex, pointConfigObj, simCount, nodeTotalMetrics, stoppingRule);
+   }
+   else {
+      printOverallMetrics(nodeTotalMetrics, pointConfigObj, simCount);
+      if (NULL != stoppingRule) {
+         printConfidenceIntervals(*stoppingRule);
+      }
+   }
+}
+
+// Writes the per-channel utilization and collisions after the averages. A sweep row already sums over the channels.
+void TextResultSink::writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, 
+                                            unsigned int simCount, std::vector<Metric>& channelTotalMetrics) {
+   if (!theSweepEnabled) {
+      printChannelMetrics(channelTotalMetrics, pointConfigObj, simCount);
+   }
+}
+
+/**********************************************
+ * BufferedResultSink
+ *******************/
+
+// BufferedResultSink class constructor with args. The sink takes ownership of file (unless it is stdout).
+BufferedResultSink::BufferedResultSink(FILE* file) {
+   theFile = file;
+   theBuffer.reserve(2 * RESULT_BUFFER_THRESHOLD);
+   theWrittenByteCount = 0;
+}
+
+// Destructor declared in order to write out the buffer and close the file.
+BufferedResultSink::~BufferedResultSink() {
+   flush();
+   if (stdout != theFile) {
+      fclose(theFile);
+   }
+   else {
+      fflush(theFile);
+   }
+}
+
+// Appends formatted text to the buffer.
+void BufferedResultSink::appendFormat(const char* format, ...) {
+   char text[512];
+   va_list args;
+   va_start(args, format);
+   int length = vsnprintf(text, sizeof(text), format, args);
+   va_end(args);
+   
+   if (length > 0) {
+      theBuffer.append(text, std::min(static_cast<size_t>(length), sizeof(text) - 1));
+   }
+}
+
+// Appends raw bytes to the buffer.
+void BufferedResultSink::appendBytes(const void* bytes, size_t count) {
+   theBuffer.append(static_cast<const char*>(bytes), count);
+}
+
+// Writes out every result so far and returns the count of bytes written, for a checkpoint.
+uint64_t BufferedResultSink::markCheckpoint() {
+   flush();
+   fflush(theFile);
+   return theWrittenByteCount;
+}
+
+// Carries on from a checkpoint taken after byteCount bytes. The header the constructor buffered is already in the 
+// file, and anything written after the checkpoint is cut off. On stdout nothing can be taken back, so the results 
+// carry on after whatever was printed.
+bool BufferedResultSink::resumeFromCheckpoint(uint64_t byteCount) {
+   theBuffer.clear();
+   theWrittenByteCount = byteCount;
+   if (stdout == theFile) {
+      return true;
+   }
+   
+   if (0 != ftruncate(fileno(theFile), static_cast<off_t>(byteCount)) || 0 != fseek(theFile, 0, SEEK_END)) {
+      std::cout << "ERROR - failed to cut the results back to the checkpoint" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+// Writes the buffer out if it is past the threshold.
+void BufferedResultSink::flushIfFull() {
+   if (theBuffer.size() >= RESULT_BUFFER_THRESHOLD) {
+      flush();
+   }
+}
+
+// Writes the buffer out.
+void BufferedResultSink::flush() {
+   if (!theBuffer.empty() && theBuffer.size() != fwrite(theBuffer.data(), 1, theBuffer.size(), theFile)) {
+      std::cout << "ERROR - failed to write results" << std::endl;
+   }
+   theWrittenByteCount += theBuffer.size();
+   theBuffer.clear();
+}
+
+/**********************************************
+ * CsvResultSink
+ *******************/
+
+// CsvResultSink class constructor with args. Writes the header line.
+CsvResultSink::CsvResultSink(FILE* file) 
+   : BufferedResultSink(file) {
+   appendFormat("record,point,simulation,node");
+   for (int field = 0; field < METRIC_FIELD_COUNT; field++) {
+      appendFormat(",%s", METRIC_FIELD_NAMES[field]);
+   }
+   for (int field = 0; field < QUANTILE_FIELD_COUNT; field++) {
+      appendFormat(",%s", getQuantileFieldName(field).c_str());
+   }
+   appendFormat("\n");
+}
+
+// Writes the metrics of every node for one replication.
+void CsvResultSink::writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics) {
+   uint64_t fields[METRIC_FIELD_COUNT];
+   uint64_t quantileFields[QUANTILE_FIELD_COUNT];
+   for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+      getMetricFields(nodeMetrics[nodeIndex], fields);
+      getQuantileFields(nodeMetrics[nodeIndex], quantileFields);
+      appendFormat("replication,%u,%u,%u", pointIndex, simIndex, nodeIndex);
+      for (int field = 0; field < METRIC_FIELD_COUNT; field++) {
+         appendFormat(",%llu", static_cast<unsigned long long>(fields[field]));
+      }
+      for (int field = 0; field < QUANTILE_FIELD_COUNT; field++) {
+         appendFormat(",%llu", static_cast<unsigned long long>(quantileFields[field]));
+      }
+      appendFormat("\n");
+   }
+   flushIfFull();
+}
+
+// Writes the per-node averages over every replication of a point. The simulation column holds the count of 
+// simulations averaged, and the quantile columns the quantiles over the messages of every replication.
+void CsvResultSink::writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                    std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule) {
+   appendAverageRows("average", pointIndex, simCount, nodeTotalMetrics);
+   flushIfFull();
+   
+   // The confidence intervals are per point rather than per node, so they go to the console.
+   if (NULL != stoppingRule) {
+      CLog::write(CLog::METRICS, "- point %u -\n", pointIndex);
+      printConfidenceIntervals(*stoppingRule);
+   }
+}
+
+// Writes the per-channel averages over every replication of a point, the node column holding the channel.
+void CsvResultSink::writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, 
+                                           unsigned int simCount, std::vector<Metric>& channelTotalMetrics) {
+   appendAverageRows("channel", pointIndex, simCount, channelTotalMetrics);
+   flushIfFull();
+}
+
+// Appends one row of kind record per metric of totalMetrics, averaged over simCount simulations.
+void CsvResultSink::appendAverageRows(const char* record, unsigned int pointIndex, unsigned int simCount, 
+                                      std::vector<Metric>& totalMetrics) {
+   uint64_t fields[METRIC_FIELD_COUNT];
+   uint64_t quantileFields[QUANTILE_FIELD_COUNT];
+   for (unsigned int index = 0; index < totalMetrics.size(); index++) {
+      getMetricFields(totalMetrics[index], fields);
+      getQuantileFields(totalMetrics[index], quantileFields);
+      appendFormat("%s,%u,%u,%u", record, pointIndex, simCount, index);
+      for (int field = 0; field < METRIC_FIELD_COUNT; field++) {
+         appendFormat(",%.17g", static_cast<double>(fields[field]) / simCount);
+      }
+      for (int field = 0; field < QUANTILE_FIELD_COUNT; field++) {
+         appendFormat(",%llu", static_cast<unsigned long long>(quantileFields[field]));
+      }
+      appendFormat("\n");
+   }
+}
+
+/**********************************************
+ * JsonLinesResultSink
+ *******************/
+
+// JsonLinesResultSink class constructor with args.
+JsonLinesResultSink::JsonLinesResultSink(FILE* file) 
+   : BufferedResultSink(file) {
+}
+
+// Writes the metrics of every node for one replication.
+void JsonLinesResultSink::writeReplication(unsigned int pointIndex, unsigned int simIndex, 
+                                           std::vector<Metric>& nodeMetrics) {
+   uint64_t fields[METRIC_FIELD_COUNT];
+   for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+      getMetricFields(nodeMetrics[nodeIndex], fields);
+      appendFormat("{\"record\":\"replication\",\"point\":%u,\"simulation\":%u,\"node\":%u", 
+                   pointIndex, 
+                   simIndex, 
+                   nodeIndex);
+      for (int field = 0; field < METRIC_FIELD_COUNT; field++) {
+         appendFormat(",\"%s\":%llu", METRIC_FIELD_NAMES[field], static_cast<unsigned long long>(fields[field]));
+      }
+      appendQuantileFields(nodeMetrics[nodeIndex]);
+      appendFormat("}\n");
+   }
+   flushIfFull();
+}
+
+// Writes the per-node averages over every replication of a point.
+void JsonLinesResultSink::writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, 
+                                          unsigned int simCount, std::vector<Metric>& nodeTotalMetrics, 
+                                          StoppingRule* stoppingRule) {
+   appendAverageObjects("average", "node", pointIndex, simCount, nodeTotalMetrics);
+   
+   // One object per statistic of the stopping rule. The half-width is null until a statistic has two values.
+   if (NULL != stoppingRule) {
+      for (unsigned int statisticIndex = 0; statisticIndex < stoppingRule->getStatistics().size(); statisticIndex++) {
+         appendFormat("{\"record\":\"confidence\",\"point\":%u,\"simulations\":%u,\"statistic\":\"%s\","
+                      "\"confidence\":%g,\"mean\":%.17g,\"half_width\":", 
+                      pointIndex, 
+                      stoppingRule->getReplicationCount(), 
+                      StoppingRule::getStatisticName(stoppingRule->getStatistics()[statisticIndex]), 
+                      stoppingRule->getConfidence(), 
+                      stoppingRule->getMean(statisticIndex));
+         double halfWidth = stoppingRule->getHalfWidth(statisticIndex);
+         if (std::isfinite(halfWidth)) {
+            appendFormat("%.17g", halfWidth);
+         }
+         else {
+            appendFormat("null");
+         }
+         appendFormat(",\"target_met\":%s}\n", stoppingRule->isSatisfied() ? "true" : "false");
+      }
+   }
+   flushIfFull();
+}
+
+// Writes the per-channel averages over every replication of a point.
+void JsonLinesResultSink::writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, 
+                                                 unsigned int simCount, std::vector<Metric>& channelTotalMetrics) {
+   appendAverageObjects("channel", "channel", pointIndex, simCount, channelTotalMetrics);
+   flushIfFull();
+}
+
+// Appends one object of kind record per metric of totalMetrics, averaged over simCount simulations, with its index 
+// under indexKey.
+void JsonLinesResultSink::appendAverageObjects(const char* record, const char* indexKey, unsigned int pointIndex, 
+                                               unsigned int simCount, std::vector<Metric>& totalMetrics) {
+   uint64_t fields[METRIC_FIELD_COUNT];
+   for (unsigned int index = 0; index < totalMetrics.size(); index++) {
+      getMetricFields(totalMetrics[index], fields);
+      appendFormat("{\"record\":\"%s\",\"point\":%u,\"simulations\":%u,\"%s\":%u", 
+                   record, 
+                   pointIndex, 
+                   simCount, 
+                   indexKey, 
+                   index);
+      for (int field = 0; field < METRIC_FIELD_COUNT; field++) {
+         appendFormat(",\"%s\":%.17g", METRIC_FIELD_NAMES[field], static_cast<double>(fields[field]) / simCount);
+      }
+      appendQuantileFields(totalMetrics[index]);
+      appendFormat("}\n");
+   }
+}
+
+// Appends the quantiles of the message delays and retransmission counts of metric, over the messages it holds.
+void JsonLinesResultSink::appendQuantileFields(Metric& metric) {
+   uint64_t quantileFields[QUANTILE_FIELD_COUNT];
+   getQuantileFields(metric, quantileFields);
+   for (int field = 0; field < QUANTILE_FIELD_COUNT; field++) {
+      appendFormat(",\"%s\":%llu", 
+                   getQuantileFieldName(field).c_str(), 
+                   static_cast<unsigned long long>(quantileFields[field]));
+   }
+}
+
+/**********************************************
+ * BinaryResultSink
+ *******************/
+
+// BinaryResultSink class constructor with args. Writes the magic.
+BinaryResultSink::BinaryResultSink(FILE* file) 
+   : BufferedResultSink(file) {
+   appendBytes("CSMARES2", 8);
+}
+
+// Writes the metrics of every node for one replication.
+void BinaryResultSink::writeReplication(unsigned int pointIndex, unsigned int simIndex, 
+                                        std::vector<Metric>& nodeMetrics) {
+   uint64_t fields[METRIC_FIELD_COUNT];
+   uint64_t quantileFields[QUANTILE_FIELD_COUNT];
+   for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+      getMetricFields(nodeMetrics[nodeIndex], fields);
+      getQuantileFields(nodeMetrics[nodeIndex], quantileFields);
+      appendRecordHeader(1, pointIndex, simIndex, nodeIndex);
+      appendBytes(fields, sizeof(fields));
+      appendBytes(quantileFields, sizeof(quantileFields));
+   }
+   flushIfFull();
+}
+
+// Writes the per-node averages over every replication of a point.
+void BinaryResultSink::writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                       std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule) {
+   appendAverageRecords(2, pointIndex, simCount, nodeTotalMetrics);
+   flushIfFull();
+   
+   // The confidence intervals are per point rather than per node, so they go to the console.
+   if (NULL != stoppingRule) {
+      CLog::write(CLog::METRICS, "- point %u -\n", pointIndex);
+      printConfidenceIntervals(*stoppingRule);
+   }
+}
+
+// Writes the per-channel averages over every replication of a point.
+void BinaryResultSink::writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, 
+                                              unsigned int simCount, std::vector<Metric>& channelTotalMetrics) {
+   appendAverageRecords(3, pointIndex, simCount, channelTotalMetrics);
+   flushIfFull();
+}
+
+// Appends one record of kind kind per metric of totalMetrics, averaged over simCount simulations.
+void BinaryResultSink::appendAverageRecords(uint8_t kind, uint32_t pointIndex, uint32_t simCount, 
+                                            std::vector<Metric>& totalMetrics) {
+   uint64_t fields[METRIC_FIELD_COUNT];
+   uint64_t quantileFields[QUANTILE_FIELD_COUNT];
+   double averages[METRIC_FIELD_COUNT + QUANTILE_FIELD_COUNT];
+   for (unsigned int index = 0; index < totalMetrics.size(); index++) {
+      getMetricFields(totalMetrics[index], fields);
+      getQuantileFields(totalMetrics[index], quantileFields);
+      for (int field = 0; field < METRIC_FIELD_COUNT; field++) {
+         averages[field] = static_cast<double>(fields[field]) / simCount;
+      }
+      for (int field = 0; field < QUANTILE_FIELD_COUNT; field++) {
+         averages[METRIC_FIELD_COUNT + field] = static_cast<double>(quantileFields[field]);
+      }
+      appendRecordHeader(kind, pointIndex, simCount, index);
+      appendBytes(averages, sizeof(averages));
+   }
+}
+
+// Appends the record header.
+void BinaryResultSink::appendRecordHeader(uint8_t kind, uint32_t pointIndex, uint32_t simIndex, uint32_t nodeIndex) {
+   appendBytes(&kind, sizeof(kind));
+   appendBytes(&pointIndex, sizeof(pointIndex));
+   appendBytes(&simIndex, sizeof(simIndex));
+   appendBytes(&nodeIndex, sizeof(nodeIndex));
+}
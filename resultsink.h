@@ -0,0 +1,213 @@
+/*
+ * Declaration of the ResultSink classes. A result sink receives the metrics of every node for each replication, in 
+ * replication order, followed by the per-node aggregates over all replications and, with more than one channel, the 
+ * per-channel aggregates. Outside of a sweep the point index is always 0.
+ *
+ * TextResultSink prints the human-readable reports through CLog. The machine-readable sinks write every Metric field 
+ * at full precision through a large buffer:
+ *   CsvResultSink       - one row per node per replication ("replication"), per node of the aggregates ("average") 
+ *                         and per channel of the aggregates ("channel")
+ *   JsonLinesResultSink - the same rows as one JSON object per line
+ *   BinaryResultSink    - the same rows as packed native-endian records (see BinaryResultSink)
+ * Every row, as the text report, also carries the p50/p99/p99.9 quantiles of the message delays and retransmission 
+ * counts (delay_p50, delay_p99, delay_p999, retransmissions_p50, retransmissions_p99, retransmissions_p999, after the 
+ * Metric fields), over the messages of the replication or, for an average, of every replication. With a stopping 
+ * rule, the JSON lines also carry a "confidence" object per statistic; the text report prints the confidence intervals 
+ * after the averages (or as extra sweep row columns), and the CSV and binary sinks, whose rows are per node, print 
+ * them on the console.
+ *
+ * A channel row has the layout of an average, with the channel index in the node column (a "channel" key in the JSON 
+ * lines). A channel counts the slots it was sensed idle and busy (slots_idle, slots_transmitting), its transmission 
+ * attempts, collisions and messages transmitted; its other Metric fields and its quantiles are 0. The text report 
+ * prints the per-channel utilization and collisions after the averages, but not in a sweep, whose rows are per point.
+ *
+ * For checkpoints, a machine-readable sink reports how many bytes it has written out, and a resumed run cuts the 
+ * RESULT_FILE back to that length, dropping whatever was written after the checkpoint.
+ */
+
+#ifndef __RESULTSINK_H__
+#define __RESULTSINK_H__
+
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "helpers.h"
+#include "stopping.h"
+
+class ResultSink {
+   public:
+      // Destructor declared virtual since sinks are deleted through the base class.
+      virtual ~ResultSink() {}
+      
+      // Writes the metrics of every node for one replication.
+      virtual void writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics) = 0;
+      
+      // Writes the per-node aggregates over the simCount replications of a point, given the per-node totals, and the 
+      // confidence intervals reached by the point's stopping rule (NULL unless STOP_STATISTICS is configured). 
+      // simCount is less than the point's SIMULATION_COUNT when the stopping rule cut it short.
+      virtual void writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                   std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule) = 0;
+      
+      // Writes the per-channel aggregates over the simCount replications of a point, given the per-channel totals. 
+      // Only called when the point has more than one channel.
+      virtual void writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, 
+                                          unsigned int simCount, std::vector<Metric>& channelTotalMetrics) = 0;
+      
+      // Writes out every result so far and returns the count of bytes written, for a checkpoint. 0 for the text 
+      // reports, which are not resumed.
+      virtual uint64_t markCheckpoint() { return 0; }
+      
+      // Carries on from a checkpoint taken after byteCount bytes. Returns false if the RESULT_FILE cannot be cut 
+      // back to byteCount.
+      virtual bool resumeFromCheckpoint(uint64_t byteCount) { return true; }
+      
+      // Creates the sink selected by RESULT_FORMAT. Returns NULL if the RESULT_FILE cannot be opened. A resumed run 
+      // (isResuming) opens the existing RESULT_FILE rather than truncating it.
+      static ResultSink* createResultSink(Configuration* configObj, bool isResuming);
+};
+
+// Prints the same reports as always: per-node text, or one comma-separated row per point in a sweep.
+class TextResultSink : public ResultSink {
+   public:
+      // Constructor with args.
+      TextResultSink(bool isSweep);
+      
+      // Writes the metrics of every node for one replication.
+      void writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics);
+      
+      // Writes the per-node aggregates over every replication of a point, given the per-node totals.
+      void writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                           std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule);
+      
+      // Writes the per-channel aggregates over every replication of a point, given the per-channel totals.
+      void writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                  std::vector<Metric>& channelTotalMetrics);
+   
+   private:
+      // True if the run is a sweep.
+      bool theSweepEnabled;
+};
+
+// Common buffering of the machine-readable sinks. Output is appended to a buffer that is written out whenever it 
+// grows past a threshold, and when the sink is destroyed.
+class BufferedResultSink : public ResultSink {
+   public:
+      // Constructor with args. The sink takes ownership of file (unless it is stdout).
+      BufferedResultSink(FILE* file);
+      
+      // Destructor declared in order to write out the buffer and close the file.
+      virtual ~BufferedResultSink();
+   
+      // Writes out every result so far and returns the count of bytes written, for a checkpoint.
+      uint64_t markCheckpoint();
+      
+      // Carries on from a checkpoint taken after byteCount bytes.
+      bool resumeFromCheckpoint(uint64_t byteCount);
+   
+   protected:
+      // Appends formatted text to the buffer.
+      void appendFormat(const char* format, ...) __attribute__((format(printf, 2, 3)));
+      
+      // Appends raw bytes to the buffer.
+      void appendBytes(const void* bytes, size_t count);
+      
+      // Writes the buffer out if it is past the threshold.
+      void flushIfFull();
+   
+   private:
+      // Writes the buffer out.
+      void flush();
+      
+      // Destination of the results.
+      FILE* theFile;
+      
+      // Results not yet written out.
+      std::string theBuffer;
+      
+      // Count of bytes written out.
+      uint64_t theWrittenByteCount;
+};
+
+// Writes comma-separated rows with a header line.
+class CsvResultSink : public BufferedResultSink {
+   public:
+      // Constructor with args.
+      CsvResultSink(FILE* file);
+      
+      // Writes the metrics of every node for one replication.
+      void writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics);
+      
+      // Writes the per-node aggregates over every replication of a point, given the per-node totals.
+      void writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                           std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule);
+      
+      // Writes the per-channel aggregates over every replication of a point, given the per-channel totals.
+      void writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                  std::vector<Metric>& channelTotalMetrics);
+   
+   private:
+      // Appends one row of kind record per metric of totalMetrics, averaged over simCount simulations.
+      void appendAverageRows(const char* record, unsigned int pointIndex, unsigned int simCount, 
+                             std::vector<Metric>& totalMetrics);
+};
+
+// Writes one JSON object per line.
+class JsonLinesResultSink : public BufferedResultSink {
+   public:
+      // Constructor with args.
+      JsonLinesResultSink(FILE* file);
+      
+      // Writes the metrics of every node for one replication.
+      void writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics);
+      
+      // Writes the per-node aggregates over every replication of a point, given the per-node totals.
+      void writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                           std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule);
+      
+      // Writes the per-channel aggregates over every replication of a point, given the per-channel totals.
+      void writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                  std::vector<Metric>& channelTotalMetrics);
+   
+   private:
+      // Appends one object of kind record per metric of totalMetrics, averaged over simCount simulations, with its 
+      // index under indexKey.
+      void appendAverageObjects(const char* record, const char* indexKey, unsigned int pointIndex, 
+                                unsigned int simCount, std::vector<Metric>& totalMetrics);
+      
+      // Appends the quantiles of the message delays and retransmission counts of metric.
+      void appendQuantileFields(Metric& metric);
+};
+
+// Writes packed native-endian records after an 8-byte "CSMARES2" magic. Every record is a uint8 kind (1 for a 
+// replication, 2 for an average, 3 for a channel), a uint32 point, a uint32 simulation (the count of simulations for 
+// an average or a channel) and a uint32 node (the channel index for a channel), followed by the 9 Metric fields and 
+// the 6 quantile fields in the order of the CSV columns: uint64 values for a replication, doubles for an average or a 
+// channel (the Metric fields averaged over the simulations, the quantiles over the messages of every simulation).
+class BinaryResultSink : public BufferedResultSink {
+   public:
+      // Constructor with args.
+      BinaryResultSink(FILE* file);
+      
+      // Writes the metrics of every node for one replication.
+      void writeReplication(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics);
+      
+      // Writes the per-node aggregates over every replication of a point, given the per-node totals.
+      void writeAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                           std::vector<Metric>& nodeTotalMetrics, StoppingRule* stoppingRule);
+      
+      // Writes the per-channel aggregates over every replication of a point, given the per-channel totals.
+      void writeChannelAggregates(unsigned int pointIndex, Configuration* pointConfigObj, unsigned int simCount, 
+                                  std::vector<Metric>& channelTotalMetrics);
+   
+   private:
+      // Appends one record of kind kind per metric of totalMetrics, averaged over simCount simulations.
+      void appendAverageRecords(uint8_t kind, uint32_t pointIndex, uint32_t simCount, 
+                                std::vector<Metric>& totalMetrics);
+      
+      // Appends the record header.
+      void appendRecordHeader(uint8_t kind, uint32_t pointIndex, uint32_t simIndex, uint32_t nodeIndex);
+};
+
+#endif   // __RESULTSINK_H__
@@ -0,0 +1,227 @@
+/*
+ * Implementation of the batch draws of the CounterRng class. One Bernoulli draw per stream is computed several 
+ * streams at a time, with a kernel chosen at run time for the widest instruction set the CPU supports (SSE2, AVX2 or 
+ * AVX-512). Every kernel evaluates exactly the Philox bijection of CounterRng::philox(), so a batch draw always 
+ * equals the scalar draw of the same stream.
+ */
+
+#include <immintrin.h>
+
+#include "rng.h"
+
+// Signature shared by the batch kernels. Sets bit i of bits when stream (firstStream + i) succeeds, for the streams 
+// [firstStream, firstStream + count) with count a multiple of the kernel width. Bits of other streams are untouched.
+typedef void (*BernoulliKernel)(const uint32_t key[2], uint32_t counterHigh, uint64_t position, uint32_t threshold, 
+                                uint32_t firstStream, int count, uint64_t* bits);
+
+// Philox round constants.
+static const uint32_t PHILOX_M0 = 0xD2511F53u;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+static const uint32_t PHILOX_W0 = 0x9E3779B9u;
+static const uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+// Scalar kernel, one stream at a time.
+static void generateBernoulliScalar(const uint32_t key[2], uint32_t counterHigh, uint64_t position, uint32_t threshold, 
+                                    uint32_t firstStream, int count, uint64_t* bits) {
+   for (int lane = 0; lane < count; lane++) {
+      uint32_t counter[4] = { static_cast<uint32_t>(position), 
+                              static_cast<uint32_t>(position >> 32), 
+                              firstStream + lane, 
+                              counterHigh };
+      uint32_t words[4];
+      CounterRng::philox(counter, key, words);
+      uint64_t isSuccess = words[0] < threshold;
+      bits[(firstStream + lane) >> 6] |= isSuccess << ((firstStream + lane) & 63);
+   }
+}
+
+// SSE2 kernel, 4 streams at a time. _mm_mul_epu32 multiplies the even lanes, so the odd lanes are shifted down and 
+// multiplied separately before the low and high halves are put back together. There is no unsigned compare, so both 
+// sides are offset by 2^31 and compared signed.
+__attribute__((target("sse2")))
+static void generateBernoulliSse2(const uint32_t key[2], uint32_t counterHigh, uint64_t position, uint32_t threshold, 
+                                  uint32_t firstStream, int count, uint64_t* bits) {
+   const __m128i lowMask = _mm_set1_epi64x(0x00000000FFFFFFFFLL);
+   const __m128i highMask = _mm_set1_epi64x(static_cast<long long>(0xFFFFFFFF00000000ULL));
+   const __m128i multiplier0 = _mm_set1_epi32(PHILOX_M0);
+   const __m128i multiplier1 = _mm_set1_epi32(PHILOX_M1);
+   const __m128i signOffset = _mm_set1_epi32(0x80000000u);
+   const __m128i offsetThreshold = _mm_xor_si128(_mm_set1_epi32(threshold), signOffset);
+   
+   for (int lane = 0; lane < count; lane += 4) {
+      uint32_t stream = firstStream + lane;
+      __m128i c0 = _mm_set1_epi32(static_cast<uint32_t>(position));
+      __m128i c1 = _mm_set1_epi32(static_cast<uint32_t>(position >> 32));
+      __m128i c2 = _mm_setr_epi32(stream, stream + 1, stream + 2, stream + 3);
+      __m128i c3 = _mm_set1_epi32(counterHigh);
+      uint32_t k0 = key[0], k1 = key[1];
+      for (int round = 0; round < 10; round++) {
+         __m128i even0 = _mm_mul_epu32(c0, multiplier0);
+         __m128i odd0 = _mm_mul_epu32(_mm_srli_epi64(c0, 32), multiplier0);
+         __m128i even1 = _mm_mul_epu32(c2, multiplier1);
+         __m128i odd1 = _mm_mul_epu32(_mm_srli_epi64(c2, 32), multiplier1);
+         __m128i low0 = _mm_or_si128(_mm_and_si128(even0, lowMask), _mm_slli_epi64(odd0, 32));
+         __m128i high0 = _mm_or_si128(_mm_srli_epi64(even0, 32), _mm_and_si128(odd0, highMask));
+         __m128i low1 = _mm_or_si128(_mm_and_si128(even1, lowMask), _mm_slli_epi64(odd1, 32));
+         __m128i high1 = _mm_or_si128(_mm_srli_epi64(even1, 32), _mm_and_si128(odd1, highMask));
+         c0 = _mm_xor_si128(_mm_xor_si128(high1, c1), _mm_set1_epi32(k0));
+         c2 = _mm_xor_si128(_mm_xor_si128(high0, c3), _mm_set1_epi32(k1));
+         c1 = low1;
+         c3 = low0;
+         k0 += PHILOX_W0;
+         k1 += PHILOX_W1;
+      }
+      
+      __m128i isSuccess = _mm_cmplt_epi32(_mm_xor_si128(c0, signOffset), offsetThreshold);
+      uint64_t laneBits = _mm_movemask_ps(_mm_castsi128_ps(isSuccess));
+      bits[stream >> 6] |= laneBits << (stream & 63);
+   }
+}
+
+// AVX2 kernel, 8 streams at a time. Same steps as the SSE2 kernel on 256-bit registers.
+__attribute__((target("avx2")))
+static void generateBernoulliAvx2(const uint32_t key[2], uint32_t counterHigh, uint64_t position, uint32_t threshold, 
+                                  uint32_t firstStream, int count, uint64_t* bits) {
+   const __m256i lowMask = _mm256_set1_epi64x(0x00000000FFFFFFFFLL);
+   const __m256i highMask = _mm256_set1_epi64x(static_cast<long long>(0xFFFFFFFF00000000ULL));
+   const __m256i multiplier0 = _mm256_set1_epi32(PHILOX_M0);
+   const __m256i multiplier1 = _mm256_set1_epi32(PHILOX_M1);
+   const __m256i signOffset = _mm256_set1_epi32(0x80000000u);
+   const __m256i offsetThreshold = _mm256_xor_si256(_mm256_set1_epi32(threshold), signOffset);
+   const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+   
+   for (int lane = 0; lane < count; lane += 8) {
+      uint32_t stream = firstStream + lane;
+      __m256i c0 = _mm256_set1_epi32(static_cast<uint32_t>(position));
+      __m256i c1 = _mm256_set1_epi32(static_cast<uint32_t>(position >> 32));
+      __m256i c2 = _mm256_add_epi32(_mm256_set1_epi32(stream), laneOffsets);
+      __m256i c3 = _mm256_set1_epi32(counterHigh);
+      uint32_t k0 = key[0], k1 = key[1];
+      for (int round = 0; round < 10; round++) {
+         __m256i even0 = _mm256_mul_epu32(c0, multiplier0);
+         __m256i odd0 = _mm256_mul_epu32(_mm256_srli_epi64(c0, 32), multiplier0);
+         __m256i even1 = _mm256_mul_epu32(c2, multiplier1);
+         __m256i odd1 = _mm256_mul_epu32(_mm256_srli_epi64(c2, 32), multiplier1);
+         __m256i low0 = _mm256_or_si256(_mm256_and_si256(even0, lowMask), _mm256_slli_epi64(odd0, 32));
+         __m256i high0 = _mm256_or_si256(_mm256_srli_epi64(even0, 32), _mm256_and_si256(odd0, highMask));
+         __m256i low1 = _mm256_or_si256(_mm256_and_si256(even1, lowMask), _mm256_slli_epi64(odd1, 32));
+         __m256i high1 = _mm256_or_si256(_mm256_srli_epi64(even1, 32), _mm256_and_si256(odd1, highMask));
+         c0 = _mm256_xor_si256(_mm256_xor_si256(high1, c1), _mm256_set1_epi32(k0));
+         c2 = _mm256_xor_si256(_mm256_xor_si256(high0, c3), _mm256_set1_epi32(k1));
+         c1 = low1;
+         c3 = low0;
+         k0 += PHILOX_W0;
+         k1 += PHILOX_W1;
+      }
+      
+      __m256i isSuccess = _mm256_cmpgt_epi32(offsetThreshold, _mm256_xor_si256(c0, signOffset));
+      uint64_t laneBits = _mm256_movemask_ps(_mm256_castsi256_ps(isSuccess));
+      bits[stream >> 6] |= laneBits << (stream & 63);
+   }
+}
+
+// AVX-512 kernel, 16 streams at a time. AVX-512 has an unsigned compare straight into a mask register. When optimized, 
+// GCC 12 flags the placeholder operands inside its own AVX-512 intrinsics as maybe uninitialized, so that warning is 
+// off for this kernel.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static void generateBernoulliAvx512(const uint32_t key[2], uint32_t counterHigh, uint64_t position, uint32_t threshold, 
+                                    uint32_t firstStream, int count, uint64_t* bits) {
+   const __m512i lowMask = _mm512_set1_epi64(0x00000000FFFFFFFFLL);
+   const __m512i highMask = _mm512_set1_epi64(static_cast<long long>(0xFFFFFFFF00000000ULL));
+   const __m512i multiplier0 = _mm512_set1_epi32(PHILOX_M0);
+   const __m512i multiplier1 = _mm512_set1_epi32(PHILOX_M1);
+   const __m512i thresholds = _mm512_set1_epi32(threshold);
+   const __m512i laneOffsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+   
+   for (int lane = 0; lane < count; lane += 16) {
+      uint32_t stream = firstStream + lane;
+      __m512i c0 = _mm512_set1_epi32(static_cast<uint32_t>(position));
+      __m512i c1 = _mm512_set1_epi32(static_cast<uint32_t>(position >> 32));
+      __m512i c2 = _mm512_add_epi32(_mm512_set1_epi32(stream), laneOffsets);
+      __m512i c3 = _mm512_set1_epi32(counterHigh);
+      uint32_t k0 = key[0], k1 = key[1];
+      for (int round = 0; round < 10; round++) {
+         __m512i even0 = _mm512_mul_epu32(c0, multiplier0);
+         __m512i odd0 = _mm512_mul_epu32(_mm512_srli_epi64(c0, 32), multiplier0);
+         __m512i even1 = _mm512_mul_epu32(c2, multiplier1);
+         __m512i odd1 = _mm512_mul_epu32(_mm512_srli_epi64(c2, 32), multiplier1);
+         __m512i low0 = _mm512_or_si512(_mm512_and_si512(even0, lowMask), _mm512_slli_epi64(odd0, 32));
+         __m512i high0 = _mm512_or_si512(_mm512_srli_epi64(even0, 32), _mm512_and_si512(odd0, highMask));
+         __m512i low1 = _mm512_or_si512(_mm512_and_si512(even1, lowMask), _mm512_slli_epi64(odd1, 32));
+         __m512i high1 = _mm512_or_si512(_mm512_srli_epi64(even1, 32), _mm512_and_si512(odd1, highMask));
+         c0 = _mm512_xor_si512(_mm512_xor_si512(high1, c1), _mm512_set1_epi32(k0));
+         c2 = _mm512_xor_si512(_mm512_xor_si512(high0, c3), _mm512_set1_epi32(k1));
+         c1 = low1;
+         c3 = low0;
+         k0 += PHILOX_W0;
+         k1 += PHILOX_W1;
+      }
+      
+      uint64_t laneBits = _mm512_cmplt_epu32_mask(c0, thresholds);
+      bits[stream >> 6] |= laneBits << (stream & 63);
+   }
+}
+#pragma GCC diagnostic pop
+
+// Kernel and width picked for this CPU, resolved on first use.
+struct BatchKernel {
+   BernoulliKernel kernel;
+   int width;
+   const char* name;
+};
+
+// Returns the batch kernel for the widest instruction set the CPU supports.
+static BatchKernel determineBatchKernel() {
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f")) {
+      return BatchKernel{ generateBernoulliAvx512, 16, "AVX-512" };
+   }
+   else if (__builtin_cpu_supports("avx2")) {
+      return BatchKernel{ generateBernoulliAvx2, 8, "AVX2" };
+   }
+   else if (__builtin_cpu_supports("sse2")) {
+      return BatchKernel{ generateBernoulliSse2, 4, "SSE2" };
+   }
+   return BatchKernel{ generateBernoulliScalar, 1, "scalar" };
+}
+
+// Returns the batch kernel of this CPU. Determined once; thread-safe as a function-local static.
+static const BatchKernel& selectBatchKernel() {
+   static const BatchKernel selected = determineBatchKernel();
+   return selected;
+}
+
+// Sets bit i of bits (64 streams per word) to generateBernoulli(i, purpose, position, threshold) for the streams 
+// [0, count). The vector kernel covers whole groups of its width; the remaining streams are drawn one at a time.
+void CounterRng::generateBernoulliBatch(RNG_PURPOSE purpose, uint64_t position, uint64_t threshold, int count, 
+                                        uint64_t* bits) {
+   int wordCount = (count + 63) / 64;
+   for (int word = 0; word < wordCount; word++) {
+      bits[word] = 0;
+   }
+   
+   // Thresholds past 32 bits always succeed, a threshold of 0 never does.
+   if (threshold > 0xFFFFFFFFULL) {
+      for (int word = 0; word < wordCount; word++) {
+         int streamCount = count - (word << 6);
+         bits[word] = streamCount >= 64 ? ~0ULL : (1ULL << streamCount) - 1;
+      }
+      return;
+   }
+   else if (0 == threshold) {
+      return;
+   }
+   
+   const BatchKernel& batchKernel = selectBatchKernel();
+   uint32_t counterHigh = (theReplication << 4) | purpose;
+   int vectorCount = count - count % batchKernel.width;
+   batchKernel.kernel(theKey, counterHigh, position, threshold, 0, vectorCount, bits);
+   generateBernoulliScalar(theKey, counterHigh, position, threshold, vectorCount, count - vectorCount, bits);
+}
+
+// Returns the name of the instruction set used by generateBernoulliBatch().
+const char* CounterRng::getBatchInstructionSet() {
+   return selectBatchKernel().name;
+}
@@ -0,0 +1,127 @@
+/*
+ * Declaration of the CounterRng class. A counter-based (Philox4x32-10) random number generator. Rather than advancing 
+ * a hidden state, every draw is a pure function of the key (the SEED) and a counter built from the replication, the 
+ * node, the purpose of the draw and its position (normally the time slot). Any engine, thread or checkpoint that asks 
+ * for the same draw therefore gets the same bits, and jumping ahead to any position is free.
+ *
+ * The single draws are defined inline in the header since they sit in the per-slot loops. The batch draws, which run 
+ * one draw for every node on the widest vector instructions of the CPU, are in rng.cpp.
+ */
+
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stdint.h>
+
+// Enum representing what a random draw is used for. Draws for different purposes never share a counter.
+typedef enum RNG_PURPOSE {
+   RNG_ARRIVAL = 0,     // frame generation
+   RNG_PERSISTENCE,     // p-persistent transmit decision
+   RNG_BACKOFF,         // back-off duration
+   RNG_SHUFFLE,         // per-slot service order
+   RNG_CHANNEL,         // per-frame channel selection
+   RNG_RECEIVER,        // per-transmit receiver (TOPOLOGY only)
+   RNG_POSITION         // node coordinates of TOPOLOGY=geometric
+} RNG_PURPOSE;
+
+class CounterRng {
+   public:
+      // Overwrite the default constructor. Keyed to seed 0, replication 0 until setKey() is called.
+      CounterRng() { setKey(0, 0); }
+      
+      // Keys the generator to a seed and replication.
+      void setKey(uint64_t seed, uint32_t replication) {
+         theKey[0] = static_cast<uint32_t>(seed);
+         theKey[1] = static_cast<uint32_t>(seed >> 32);
+         theReplication = replication;
+      }
+      
+      // Returns the four random words of block (stream, purpose, position).
+      void generateBlock(uint32_t stream, RNG_PURPOSE purpose, uint64_t position, uint32_t words[4]) {
+         uint32_t counter[4] = { static_cast<uint32_t>(position), 
+                                 static_cast<uint32_t>(position >> 32), 
+                                 stream, 
+                                 (theReplication << 4) | purpose };
+         philox(counter, theKey, words);
+      }
+      
+      // Returns true with the probability encoded by threshold (see computeBernoulliThreshold()).
+      bool generateBernoulli(uint32_t stream, RNG_PURPOSE purpose, uint64_t position, uint64_t threshold) {
+         uint32_t words[4];
+         generateBlock(stream, purpose, position, words);
+         return words[0] < threshold;
+      }
+      
+      // Returns a uniformly distributed integer in [0, range), without the bias of a modulo. Lemire's multiply-shift 
+      // with rejection; each block supplies four candidates and further blocks are taken from positions 2^48 apart.
+      uint32_t generateBounded(uint32_t stream, RNG_PURPOSE purpose, uint64_t position, uint32_t range) {
+         uint32_t rejectBelow = static_cast<uint32_t>(-range) % range;
+         for (uint64_t attempt = 0; ; attempt++) {
+            uint32_t words[4];
+            generateBlock(stream, purpose, position + (attempt << 48), words);
+            for (int word = 0; word < 4; word++) {
+               uint64_t product = static_cast<uint64_t>(words[word]) * range;
+               if (static_cast<uint32_t>(product) >= rejectBelow) {
+                  return static_cast<uint32_t>(product >> 32);
+               }
+            }
+         }
+      }
+      
+      // Returns a uniformly distributed double in (0, 1], with 53 bits of precision.
+      double generateUnitInterval(uint32_t stream, RNG_PURPOSE purpose, uint64_t position) {
+         uint32_t words[4];
+         generateBlock(stream, purpose, position, words);
+         uint64_t bits = ((static_cast<uint64_t>(words[0]) << 32) | words[1]) >> 11;
+         return (static_cast<double>(bits) + 1.0) * (1.0 / 9007199254740992.0);
+      }
+      
+      // Sets bit i of bits (64 streams per word) to generateBernoulli(i, purpose, position, threshold) for the streams 
+      // [0, count). Computed with SSE2, AVX2 or AVX-512, whichever is the widest the CPU supports.
+      void generateBernoulliBatch(RNG_PURPOSE purpose, uint64_t position, uint64_t threshold, int count, uint64_t* bits);
+      
+      // Returns the name of the instruction set used by generateBernoulliBatch().
+      static const char* getBatchInstructionSet();
+      
+      // Returns the threshold for which generateBernoulli() succeeds with the given probability.
+      static uint64_t computeBernoulliThreshold(double probability) {
+         if (probability <= 0) {
+            return 0;
+         }
+         else if (probability >= 1) {
+            return 1ULL << 32;
+         }
+         return static_cast<uint64_t>(probability * 4294967296.0 + 0.5);
+      }
+      
+      // The Philox4x32 bijection with 10 rounds, mapping counter to words under key.
+      static void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t words[4]) {
+         uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+         uint32_t k0 = key[0], k1 = key[1];
+         for (int round = 0; round < 10; round++) {
+            uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+            uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+            uint32_t next0 = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ k0;
+            uint32_t next2 = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<uint32_t>(product1);
+            c3 = static_cast<uint32_t>(product0);
+            c0 = next0;
+            c2 = next2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+         }
+         words[0] = c0;
+         words[1] = c1;
+         words[2] = c2;
+         words[3] = c3;
+      }
+   
+   private:
+      // Key words, taken from the seed.
+      uint32_t theKey[2];
+      
+      // Replication the draws belong to.
+      uint32_t theReplication;
+};
+
+#endif   // __RNG_H__
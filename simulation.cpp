@@ -0,0 +1,128 @@
+/*
+ * Implementation of the Simulation class. A class used to execute the replications of the simulation, one at a time.
+ */
+
+#include "simulation.h"
+#include "nodestore.h"
+#include "alloccount.h"
+
+// Simulation class constructor with args. The node store is sized here, once, by the thread that will run the 
+// replications, so under a first-touch policy its pages are local to that thread's NUMA node.
+Simulation::Simulation(Configuration* configObj) 
+   : theNodeStore(configObj), theEventEngine(configObj) {
+   theConfigObj = configObj;
+   theSlotKernel = selectSlotKernel(configObj->getCsmaType());
+   
+   // Size the scratch buffers for the worst case up front so the slot loop never grows them.
+   theSlotScratch.serviceOrder.reserve(configObj->getNodeCount());
+   theSlotScratch.nodeIndexes.reserve(configObj->getNodeCount());
+   theSlotScratch.dueBits.assign((configObj->getNodeCount() + 63) / 64, 0);
+   theSlotScratch.waitingBits.assign((configObj->getNodeCount() + 63) / 64, 0);
+   theSlotScratch.arrivalBits.assign((configObj->getNodeCount() + 63) / 64, 0);
+   theSlotScratch.persistenceBits.assign((configObj->getNodeCount() + 63) / 64, 0);
+   theSlotScratch.isPersistenceDrawn = false;
+   
+   theCheckpointer = NULL;
+   theCheckpointGeneration = 0;
+}
+
+// Runs replication simIndex of the run keyed by seed, and copies each node's metrics into nodeMetrics (indexed by 
+// address) and each channel's into channelMetrics (see NodeStore::collectChannelMetrics()). Everything a replication 
+// touches belongs to this object, so that replications can execute concurrently, and is reset in place rather than 
+// recreated, so that a worker's replications after its first allocate nothing up front. With savedState, the store 
+// and engine are overwritten with the state saved in a checkpoint and the replication carries on from the time slot 
+// it had reached; every draw from there on is the same as in the uninterrupted run.
+void Simulation::runReplication(unsigned int simIndex, uint64_t seed, std::vector<Metric>& nodeMetrics, 
+                                std::vector<Metric>& channelMetrics, StateBuffer* savedState) {
+   // Key this thread's random draws to the run's seed and this replication.
+   seedRandomGenerator(seed, simIndex);
+   
+   // For a clean simulation, all of the node state is re-initialized each time (including the first frame arrivals).
+   NodeStore& nodeStore = theNodeStore;
+   nodeStore.reset();
+   
+   // Mark the start of the replication in the trace.
+   traceEvent(TRACE_REPLICATION, 0, simIndex, theConfigObj->getEngineType());
+   
+   // Restore the replication saved in a checkpoint.
+   unsigned long firstTimeIndex = 0;
+   if (NULL != savedState) {
+      bool isRestored = savedState->readValue(firstTimeIndex) && nodeStore.restoreState(*savedState);
+      if (EVENT_ENGINE == theConfigObj->getEngineType()) {
+         isRestored = isRestored && theEventEngine.restoreState(nodeStore, *savedState);
+      }
+      if (!isRestored) {
+         std::cout << "ERROR - invalid checkpoint state for simulation " << simIndex << std::endl;
+         exit(-1);
+      }
+   }
+   else if (EVENT_ENGINE == theConfigObj->getEngineType()) {
+      theEventEngine.start(nodeStore);
+   }
+   
+   // Allocations made while advancing the time slots (counted in the diagnostic build only).
+   unsigned long allocationCount = getThreadAllocationCount();
+   
+   if (EVENT_ENGINE == theConfigObj->getEngineType()) {
+      // Jump straight between the time slots in which something happens. The event engine does not track the time 
+      // slot reached, so the snapshots record 0.
+      do {
+         if (NULL != theCheckpointer && theCheckpointer->isSnapshotRequested(theCheckpointGeneration)) {
+            depositSnapshot(simIndex, 0);
+         }
+      } while (theEventEngine.processNextTimeSlot());
+      theEventEngine.finish();
+   }
+   else {
+      // Loop through all of the time-slots.
+      unsigned long timeSlots = theConfigObj->getTimeSlotCount();
+      for (unsigned long timeIndex = firstTimeIndex; timeIndex < timeSlots; timeIndex++) {
+         if (NULL != theCheckpointer && theCheckpointer->isSnapshotRequested(theCheckpointGeneration)) {
+            depositSnapshot(simIndex, timeIndex);
+         }
+         CLOG_WRITE(CLog::VERBOSE, "---- sim %u timeIndex: %lu ----\n", simIndex, timeIndex);
+         traceSlot(timeIndex);
+         theSlotKernel(nodeStore, timeIndex, theConfigObj, theSlotScratch);
+         CLOG_WRITE(CLog::VERBOSE, "\n");
+      }
+      nodeStore.settleIdleSlots();
+   }
+   
+   if (isAllocationCountingEnabled()) {
+      allocationCount = getThreadAllocationCount() - allocationCount;
+      CLog::write(CLog::METRICS, "simulation %u: %lu heap allocations in %lu time slots (%.6f per slot)%s\n", 
+                                 simIndex, 
+                                 allocationCount, 
+                                 theConfigObj->getTimeSlotCount(),
+                                 static_cast<double>(allocationCount) / theConfigObj->getTimeSlotCount(), 
+                                 nodeStore.areHistogramsPresized() ? "" 
+                                    : ", counting the growth of the delay histograms, too large to size up front");
+   }
+   
+   // Save off the metrics. They are copied, as the node views keep pointing into the store's.
+   nodeMetrics = nodeStore.getMetrics();
+   nodeStore.collectChannelMetrics(channelMetrics);
+}
+
+// Makes the replications save their state whenever checkpointer requests it (see checkpoint.h).
+void Simulation::setCheckpointer(Checkpointer* checkpointer) {
+   theCheckpointer = checkpointer;
+}
+
+// Tells the checkpointer that this object will run no more replications.
+void Simulation::retireFromCheckpoints() {
+   if (NULL != theCheckpointer) {
+      theCheckpointer->retireWorker(theCheckpointGeneration);
+   }
+}
+
+// Saves the replication simIndex, about to run time slot timeIndex, for the requested checkpoint.
+void Simulation::depositSnapshot(unsigned int simIndex, unsigned long timeIndex) {
+   StateBuffer state;
+   state.appendValue(timeIndex);
+   theNodeStore.saveState(state);
+   if (EVENT_ENGINE == theConfigObj->getEngineType()) {
+      theEventEngine.saveState(state);
+   }
+   theCheckpointer->depositSnapshot(theCheckpointGeneration, simIndex, state);
+}
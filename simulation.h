@@ -0,0 +1,62 @@
+/*
+ * Declaration of the Simulation class. A class used to execute the replications of the simulation, one at a time, 
+ * reusing one set of per-replication state sized from the configuration.
+ */
+
+#ifndef __SIMULATION_H__
+#define __SIMULATION_H__
+
+#include <vector>
+
+#include "helpers.h"
+#include "checkpoint.h"
+#include "eventengine.h"
+#include "nodestore.h"
+#include "protocol.h"
+
+class Simulation {
+   public:
+      // Constructor with args.
+      Simulation(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Runs replication simIndex of the run keyed by seed, and copies each node's metrics into nodeMetrics (indexed 
+      // by address) and each channel's into channelMetrics. With savedState (NULL otherwise), the replication resumes 
+      // from the state saved in a checkpoint.
+      void runReplication(unsigned int simIndex, uint64_t seed, std::vector<Metric>& nodeMetrics, 
+                          std::vector<Metric>& channelMetrics, StateBuffer* savedState);
+      
+      // Makes the replications save their state whenever checkpointer requests it (see checkpoint.h).
+      void setCheckpointer(Checkpointer* checkpointer);
+      
+      // Tells the checkpointer that this object will run no more replications.
+      void retireFromCheckpoints();
+   
+   private:
+      // Configuration shared (read-only) by every replication.
+      Configuration* theConfigObj;
+      
+      // Node state reused, and reset in place, by every replication this object runs.
+      NodeStore theNodeStore;
+      
+      // Scratch buffers reused by every time slot of every replication this object runs.
+      SlotScratch theSlotScratch;
+      
+      // determineNodeStates() for the configured protocol, selected once.
+      SlotKernel theSlotKernel;
+      
+      // Event engine reused by every replication this object runs (used when ENGINE=event).
+      EventEngine theEventEngine;
+      
+      // Coordinates the checkpoints, NULL unless CHECKPOINT_FILE is configured.
+      Checkpointer* theCheckpointer;
+      
+      // Count of checkpoint requests this object has answered.
+      unsigned int theCheckpointGeneration;
+      
+      // Saves the replication simIndex, about to run time slot timeIndex, for the requested checkpoint.
+      void depositSnapshot(unsigned int simIndex, unsigned long timeIndex);
+};
+
+#endif   // __SIMULATION_H__
@@ -0,0 +1,51 @@
+/*
+ * Implementation of the StateBuffer class. A flat buffer that the state of a run is serialized into.
+ */
+
+#include <algorithm>    // std::swap
+
+#include "statebuffer.h"
+
+// StateBuffer class constructor.
+StateBuffer::StateBuffer() {
+   theReadOffset = 0;
+}
+
+// Appends count bytes.
+void StateBuffer::appendBytes(const void* bytes, size_t count) {
+   theBytes.append(static_cast<const char*>(bytes), count);
+}
+
+// Reads count bytes. Returns false past the end of the buffer.
+bool StateBuffer::readBytes(void* bytes, size_t count) {
+   if (count > theBytes.size() - theReadOffset) {
+      return false;
+   }
+   if (0 != count) {
+      memcpy(bytes, theBytes.data() + theReadOffset, count);
+   }
+   theReadOffset += count;
+   return true;
+}
+
+// Reads count bytes into buffer, replacing its contents.
+bool StateBuffer::readBuffer(StateBuffer& buffer, uint64_t count) {
+   if (count > theBytes.size() - theReadOffset) {
+      return false;
+   }
+   buffer.theBytes.assign(theBytes, theReadOffset, count);
+   buffer.theReadOffset = 0;
+   theReadOffset += count;
+   return true;
+}
+
+// Returns the bytes appended.
+std::string& StateBuffer::getBytes() {
+   return theBytes;
+}
+
+// Swaps the contents with otherBuffer.
+void StateBuffer::swap(StateBuffer& otherBuffer) {
+   theBytes.swap(otherBuffer.theBytes);
+   std::swap(theReadOffset, otherBuffer.theReadOffset);
+}
@@ -0,0 +1,76 @@
+/*
+ * Declaration of the StateBuffer class. A flat buffer that the state of a run is serialized into for a checkpoint 
+ * (see checkpoint.h), and read back from on resume.
+ */
+
+#ifndef __STATEBUFFER_H__
+#define __STATEBUFFER_H__
+
+#include <cstring>      // memcpy
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Serialized state, appended to and read back in the same order. Only plain values and vectors of them are stored, 
+// in the native layout, so a checkpoint is only read back by the build that wrote it.
+class StateBuffer {
+   public:
+      // Overwrite the default constructor.
+      StateBuffer();
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Appends count bytes.
+      void appendBytes(const void* bytes, size_t count);
+      
+      // Appends a plain value.
+      template <class T>
+      void appendValue(const T& value) {
+         appendBytes(&value, sizeof(T));
+      }
+      
+      // Appends a vector of plain values, preceded by its size.
+      template <class T>
+      void appendVector(const std::vector<T>& values) {
+         appendValue<uint64_t>(values.size());
+         appendBytes(values.data(), values.size() * sizeof(T));
+      }
+      
+      // Reads count bytes. Returns false past the end of the buffer.
+      bool readBytes(void* bytes, size_t count);
+      
+      // Reads a plain value.
+      template <class T>
+      bool readValue(T& value) {
+         return readBytes(&value, sizeof(T));
+      }
+      
+      // Reads a vector of plain values, resizing it to the size stored.
+      template <class T>
+      bool readVector(std::vector<T>& values) {
+         uint64_t size = 0;
+         if (!readValue(size) || size > (theBytes.size() - theReadOffset) / sizeof(T)) {
+            return false;
+         }
+         values.resize(size);
+         return readBytes(values.data(), size * sizeof(T));
+      }
+      
+      // Reads count bytes into buffer, replacing its contents.
+      bool readBuffer(StateBuffer& buffer, uint64_t count);
+      
+      // Returns the bytes appended.
+      std::string& getBytes();
+      
+      // Swaps the contents with otherBuffer.
+      void swap(StateBuffer& otherBuffer);
+   
+   private:
+      // Serialized bytes.
+      std::string theBytes;
+      
+      // Offset of the next byte read.
+      size_t theReadOffset;
+};
+
+#endif   // __STATEBUFFER_H__
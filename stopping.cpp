@@ -0,0 +1,203 @@
+/*
+ * Implementation of the StoppingRule class. A class used to end the replications of a run early once the confidence 
+ * intervals of the chosen statistics are narrow enough.
+ */
+
+#include <cmath>        // erfc, exp, pow, sqrt
+#include <limits>       // std::numeric_limits
+
+#include "stopping.h"
+
+// Helper function that returns the quantile of the standard normal distribution at probability, by bisection.
+static double determineNormalQuantile(double probability) {
+   double low = -40.0, high = 40.0;
+   for (int iteration = 0; iteration < 200; iteration++) {
+      double middle = 0.5 * (low + high);
+      if (0.5 * erfc(-middle / sqrt(2.0)) < probability) {
+         low = middle;
+      }
+      else {
+         high = middle;
+      }
+   }
+   return 0.5 * (low + high);
+}
+
+// Helper function that returns the quantile t of Student's t distribution with degreeCount degrees of freedom such 
+// that |T| > t with probability twoTailProbability. Hill's approximation (CACM algorithm 396), good to about 6 digits.
+static double determineStudentQuantile(double twoTailProbability, unsigned int degreeCount) {
+   const double pi = 3.14159265358979323846;
+   double n = degreeCount;
+   double p = twoTailProbability;
+   if (1 == degreeCount) {
+      return cos(p * pi / 2) / sin(p * pi / 2);
+   }
+   else if (2 == degreeCount) {
+      return sqrt(2 / (p * (2 - p)) - 2);
+   }
+   
+   double a = 1 / (n - 0.5);
+   double b = 48 / (a * a);
+   double c = ((20700 * a / b - 98) * a - 16) * a + 96.36;
+   double d = ((94.5 / (b + c) - 3) / b + 1) * sqrt(a * pi / 2) * n;
+   double x = d * p;
+   double y = pow(x, 2 / n);
+   if (y > 0.05 + a) {
+      // Asymptotic inverse expansion about the normal quantile.
+      x = determineNormalQuantile(0.5 * p);
+      y = x * x;
+      if (degreeCount < 5) {
+         c += 0.3 * (n - 4.5) * (x + 0.6);
+      }
+      c = (((0.05 * d * x - 5) * x - 7) * x - 2) * x + b + c;
+      y = (((((0.4 * y + 6.3) * y + 36) * y + 94.5) / c - y - 3) / b + 1) * x;
+      y = a * y * y;
+      y = (y > 0.002) ? exp(y) - 1 : 0.5 * y * y + y;
+   }
+   else {
+      y = ((1 / (((n + 6) / (n * y) - 0.089 * d - 0.822) * (n + 2) * 3) + 0.5 / (n + 4)) * y - 1)
+        * (n + 1) / (n + 2) + 1 / y;
+   }
+   return sqrt(n * y);
+}
+
+// StoppingRule class constructor with args.
+StoppingRule::StoppingRule(Configuration* configObj) {
+   theStatistics = configObj->getStopStatistics();
+   theRelativeHalfWidth = configObj->getStopRelativeHalfWidth();
+   theConfidence = configObj->getStopConfidence();
+   theMinReplicationCount = configObj->getStopMinSimulationCount();
+   theReplicationCount = 0;
+   theValueCounts.assign(theStatistics.size(), 0);
+   theMeans.assign(theStatistics.size(), 0);
+   theSquaredDeviationSums.assign(theStatistics.size(), 0);
+}
+
+// Adds the statistics of one replication of pointConfigObj, given the metrics of its nodes. The statistics are those 
+// of printSweepRow(), for the one replication.
+void StoppingRule::addReplication(Configuration* pointConfigObj, std::vector<Metric>& nodeMetrics) {
+   double generated = 0, transmitted = 0, attempts = 0, collisions = 0, dropped = 0, waited = 0;
+   for (unsigned int nodeIndex = 0; nodeIndex < nodeMetrics.size(); nodeIndex++) {
+      generated += nodeMetrics[nodeIndex].getCountOfMessagesGenerated();
+      transmitted += nodeMetrics[nodeIndex].getCountOfMessagesTransmitted();
+      attempts += nodeMetrics[nodeIndex].getCountOfTransmissionAttempts();
+      collisions += nodeMetrics[nodeIndex].getCountOfCollisions();
+      dropped += nodeMetrics[nodeIndex].getCountOfMessagesDropped();
+      waited += nodeMetrics[nodeIndex].getTimeMessagesWaited();
+   }
+   
+   double slotCount = static_cast<double>(pointConfigObj->getTimeSlotCount());
+   int frameLength = pointConfigObj->getFrameLength();
+   for (unsigned int statisticIndex = 0; statisticIndex < theStatistics.size(); statisticIndex++) {
+      double value = 0;
+      switch (theStatistics[statisticIndex]) {
+         case OFFERED_LOAD_STATISTIC:
+            value = generated * frameLength / slotCount;
+            break;
+         case THROUGHPUT_STATISTIC:
+            value = transmitted * frameLength / slotCount;
+            break;
+         case MEAN_DELAY_STATISTIC:
+            if (0 == transmitted) {
+               continue;
+            }
+            value = waited / transmitted;
+            break;
+         case COLLISION_RATIO_STATISTIC:
+            if (0 == attempts) {
+               continue;
+            }
+            value = collisions / attempts;
+            break;
+         case DROP_RATIO_STATISTIC:
+            if (0 == generated) {
+               continue;
+            }
+            value = dropped / generated;
+            break;
+      }
+      
+      // Welford's update of the running mean and sum of squared deviations.
+      theValueCounts[statisticIndex]++;
+      double deviation = value - theMeans[statisticIndex];
+      theMeans[statisticIndex] += deviation / theValueCounts[statisticIndex];
+      theSquaredDeviationSums[statisticIndex] += deviation * (value - theMeans[statisticIndex]);
+   }
+   theReplicationCount++;
+}
+
+// Returns true if, after the minimum count of replications, the confidence interval of every statistic is within the 
+// relative half-width of its mean.
+bool StoppingRule::isSatisfied() {
+   if (theReplicationCount < theMinReplicationCount) {
+      return false;
+   }
+   
+   for (unsigned int statisticIndex = 0; statisticIndex < theStatistics.size(); statisticIndex++) {
+      if (getHalfWidth(statisticIndex) > theRelativeHalfWidth * fabs(theMeans[statisticIndex])) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Getter for theReplicationCount.
+unsigned int StoppingRule::getReplicationCount() {
+   return theReplicationCount;
+}
+
+// Getter for theStatistics.
+std::vector<STOP_STATISTIC>& StoppingRule::getStatistics() {
+   return theStatistics;
+}
+
+// Returns the mean of statistic statisticIndex.
+double StoppingRule::getMean(unsigned int statisticIndex) {
+   return theMeans[statisticIndex];
+}
+
+// Returns the half-width of the confidence interval of statistic statisticIndex: the Student t quantile times the 
+// standard error of the mean. Infinite with fewer than two values.
+double StoppingRule::getHalfWidth(unsigned int statisticIndex) {
+   unsigned int valueCount = theValueCounts[statisticIndex];
+   if (valueCount < 2) {
+      return std::numeric_limits<double>::infinity();
+   }
+   
+   double variance = theSquaredDeviationSums[statisticIndex] / (valueCount - 1);
+   return determineStudentQuantile(1 - theConfidence, valueCount - 1) * sqrt(variance / valueCount);
+}
+
+// Getter for theConfidence.
+double StoppingRule::getConfidence() {
+   return theConfidence;
+}
+
+// Getter for theRelativeHalfWidth.
+double StoppingRule::getRelativeHalfWidth() {
+   return theRelativeHalfWidth;
+}
+
+// Returns the name of statistic, as in the STOP_STATISTICS key and the sweep row columns.
+const char* StoppingRule::getStatisticName(STOP_STATISTIC statistic) {
+   const char* statisticNames[] = { 
+      "offered_load", "throughput", "mean_delay", "collisions_per_attempt", "drop_ratio" 
+   };
+   return statisticNames[statistic];
+}
+
+// Appends the running statistics to state, for a checkpoint.
+void StoppingRule::saveState(StateBuffer& state) {
+   state.appendValue(theReplicationCount);
+   state.appendVector(theValueCounts);
+   state.appendVector(theMeans);
+   state.appendVector(theSquaredDeviationSums);
+}
+
+// Reads back the running statistics saved by saveState(). Returns false if state is too short.
+bool StoppingRule::restoreState(StateBuffer& state) {
+   return state.readValue(theReplicationCount)
+       && state.readVector(theValueCounts)
+       && state.readVector(theMeans)
+       && state.readVector(theSquaredDeviationSums);
+}
@@ -0,0 +1,84 @@
+/*
+ * Declaration of the StoppingRule class. A class used to end the replications of a run (or of a sweep point) early, 
+ * once the confidence intervals of the chosen statistics (STOP_STATISTICS) are narrow enough.
+ *
+ * Each replication is reduced to one value per statistic, aggregated over its nodes exactly as in a sweep row. The 
+ * running mean and variance of those values (Welford's method) give a Student t confidence interval, and the rule is 
+ * satisfied once, after at least STOP_MIN_SIMULATIONS replications, every interval's half-width is within 
+ * STOP_RELATIVE_HALF_WIDTH of its mean. The runners feed the rule in replication order, so the count of replications 
+ * it stops at does not depend on the count of worker threads.
+ */
+
+#ifndef __STOPPING_H__
+#define __STOPPING_H__
+
+#include <vector>
+
+#include "helpers.h"
+#include "statebuffer.h"
+
+class StoppingRule {
+   public:
+      // Constructor with args.
+      StoppingRule(Configuration* configObj);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Adds the statistics of one replication of pointConfigObj, given the metrics of its nodes.
+      void addReplication(Configuration* pointConfigObj, std::vector<Metric>& nodeMetrics);
+      
+      // Returns true if the confidence intervals of every statistic meet the target.
+      bool isSatisfied();
+      
+      // Getter for theReplicationCount.
+      unsigned int getReplicationCount();
+      
+      // Getter for theStatistics.
+      std::vector<STOP_STATISTIC>& getStatistics();
+      
+      // Returns the mean of statistic statisticIndex (an index into getStatistics()).
+      double getMean(unsigned int statisticIndex);
+      
+      // Returns the half-width of the confidence interval of statistic statisticIndex. Infinite with fewer than two 
+      // values.
+      double getHalfWidth(unsigned int statisticIndex);
+      
+      // Getter for theConfidence.
+      double getConfidence();
+      
+      // Getter for theRelativeHalfWidth.
+      double getRelativeHalfWidth();
+      
+      // Returns the name of statistic, as in the STOP_STATISTICS key and the sweep row columns.
+      static const char* getStatisticName(STOP_STATISTIC statistic);
+      
+      // Appends the running statistics to state, for a checkpoint.
+      void saveState(StateBuffer& state);
+      
+      // Reads back the running statistics saved by saveState(). Returns false if state is too short.
+      bool restoreState(StateBuffer& state);
+   
+   private:
+      // Statistics tracked.
+      std::vector<STOP_STATISTIC> theStatistics;
+      
+      // Target half-width of the confidence intervals, relative to their means.
+      double theRelativeHalfWidth;
+      
+      // Confidence level of the intervals.
+      double theConfidence;
+      
+      // Count of replications added before the intervals are first checked.
+      unsigned int theMinReplicationCount;
+      
+      // Count of replications added.
+      unsigned int theReplicationCount;
+      
+      // Per statistic: count of values added (a ratio is left out of replications where it is undefined), running 
+      // mean and running sum of squared deviations from the mean.
+      std::vector<unsigned int> theValueCounts;
+      std::vector<double> theMeans;
+      std::vector<double> theSquaredDeviationSums;
+};
+
+#endif   // __STOPPING_H__
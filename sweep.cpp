@@ -0,0 +1,210 @@
+/*
+ * Implementation of the SweepRunner class. A class used to execute a parameter sweep on a shared work-stealing pool.
+ */
+
+#include <algorithm>    // std::min, std::max
+#include <thread>
+
+#include "sweep.h"
+#include "simulation.h"
+#include "report.h"
+
+// SweepRunner class constructor with args. Expands the sweep of configObj into its points; exits on an invalid swept 
+// value.
+SweepRunner::SweepRunner(Configuration* configObj, ResultSink* resultSink) {
+   theConfigObj = configObj;
+   theResultSink = resultSink;
+   theNextPointToReport = 0;
+   
+   if (!configObj->expandSweep(thePoints)) {
+      std::cout << "ERROR - failed to expand the sweep" << std::endl;
+      exit(-1);
+   }
+   
+   thePointResults.reserve(thePoints.size());
+   for (unsigned int pointIndex = 0; pointIndex < thePoints.size(); pointIndex++) {
+      thePointResults.push_back(PointResult(&thePoints[pointIndex]));
+      thePointResults[pointIndex].nodeTotalMetrics.assign(thePoints[pointIndex].getNodeCount(), Metric());
+      thePointResults[pointIndex].channelTotalMetrics.assign(thePoints[pointIndex].getChannelCount(), Metric());
+      thePointResults[pointIndex].nextSimToReduce = 0;
+      thePointResults[pointIndex].simLimit = configObj->getSimulationCount();
+   }
+}
+
+// Executes every job and returns once every point has been reported.
+void SweepRunner::run() {
+   unsigned int simCount = theConfigObj->getSimulationCount();
+   unsigned int workerCount = determineWorkerCount();
+   CLog::write(CLog::METRICS, "Running a sweep of %lu points x %s%u simulations on %u worker thread(s).\n", 
+                              thePoints.size(), 
+                              theConfigObj->isStoppingEnabled() ? "up to " : "", 
+                              simCount, 
+                              workerCount);
+   
+   // Deal the jobs out in contiguous blocks, so each worker starts on its own run of points.
+   unsigned long jobCount = thePoints.size() * simCount;
+   std::vector<WorkerQueue> workerQueues(workerCount);
+   theWorkerQueues.swap(workerQueues);
+   for (unsigned long jobIndex = 0; jobIndex < jobCount; jobIndex++) {
+      SweepJob job;
+      job.pointIndex = jobIndex / simCount;
+      job.simIndex = jobIndex % simCount;
+      theWorkerQueues[jobIndex * workerCount / jobCount].jobs.push_back(job);
+   }
+   
+   // The calling thread acts as the last worker.
+   std::vector<std::thread> workers;
+   for (unsigned int workerIndex = 1; workerIndex < workerCount; workerIndex++) {
+      workers.push_back(std::thread(&SweepRunner::workerLoop, this, workerIndex));
+   }
+   workerLoop(0);
+   
+   for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); it++) {
+      it->join();
+   }
+}
+
+// Returns the count of worker threads that run() will use.
+unsigned int SweepRunner::determineWorkerCount() {
+   // Verbose logging traces every time slot, which is only readable from a single worker.
+   if (theConfigObj->getVerboseEnabled()) {
+      return 1;
+   }
+   
+   unsigned int workerCount = theConfigObj->getThreadCount();
+   if (0 == workerCount) {
+      workerCount = std::thread::hardware_concurrency();
+   }
+   
+   // There is no use for more workers than jobs.
+   unsigned long jobCount = thePoints.size() * theConfigObj->getSimulationCount();
+   workerCount = std::min(static_cast<unsigned long>(workerCount), jobCount);
+   return std::max(workerCount, 1u);
+}
+
+// Body of worker workerIndex. Runs its own jobs, then steals from the other workers until none remain.
+void SweepRunner::workerLoop(unsigned int workerIndex) {
+   // The simulation state is sized for one point, so it is only rebuilt when the worker moves to another point.
+   Simulation* simulation = NULL;
+   unsigned int simulationPointIndex = 0;
+   std::vector<Metric> nodeMetrics;
+   std::vector<Metric> channelMetrics;
+   
+   SweepJob job;
+   while (takeJob(workerIndex, job)) {
+      if (!isJobNeeded(job)) {
+         continue;
+      }
+      
+      if (NULL == simulation || simulationPointIndex != job.pointIndex) {
+         delete simulation;
+         simulation = new Simulation(&thePoints[job.pointIndex]);
+         simulationPointIndex = job.pointIndex;
+      }
+      
+      // Replications are keyed by their index alone, so every point sees the same random streams.
+      simulation->runReplication(job.simIndex, theConfigObj->getSeed(), nodeMetrics, channelMetrics, NULL);
+      submitResults(job.pointIndex, job.simIndex, nodeMetrics, channelMetrics);
+   }
+   
+   delete simulation;
+}
+
+// Takes the next job for workerIndex, from its own queue or stolen from another. Returns false when every queue is 
+// empty. Jobs are never added once run() starts, so a full pass over empty queues means the sweep is drained.
+bool SweepRunner::takeJob(unsigned int workerIndex, SweepJob& job) {
+   {
+      WorkerQueue& ownQueue = theWorkerQueues[workerIndex];
+      std::lock_guard<std::mutex> lock(ownQueue.mutex);
+      if (!ownQueue.jobs.empty()) {
+         job = ownQueue.jobs.front();
+         ownQueue.jobs.pop_front();
+         return true;
+      }
+   }
+   
+   // Steal from the back of the next non-empty queue.
+   for (unsigned int offset = 1; offset < theWorkerQueues.size(); offset++) {
+      WorkerQueue& victimQueue = theWorkerQueues[(workerIndex + offset) % theWorkerQueues.size()];
+      std::lock_guard<std::mutex> lock(victimQueue.mutex);
+      if (!victimQueue.jobs.empty()) {
+         job = victimQueue.jobs.back();
+         victimQueue.jobs.pop_back();
+         return true;
+      }
+   }
+   return false;
+}
+
+// Returns false if the stopping rule of the job's point was satisfied by earlier replications.
+bool SweepRunner::isJobNeeded(SweepJob& job) {
+   std::lock_guard<std::mutex> lock(theResultMutex);
+   return job.simIndex < thePointResults[job.pointIndex].simLimit;
+}
+
+// Adds a finished replication to its point and reports, in point order, every point that is complete. Each point's 
+// replications are written and reduced in replication order.
+void SweepRunner::submitResults(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics, 
+                                std::vector<Metric>& channelMetrics) {
+   std::lock_guard<std::mutex> lock(theResultMutex);
+   PointResult& pointResult = thePointResults[pointIndex];
+   
+   // Drop replications that were already running when the point's stopping rule was satisfied.
+   if (simIndex >= pointResult.simLimit) {
+      return;
+   }
+   pointResult.pendingResults[simIndex].swap(nodeMetrics);
+   pointResult.pendingChannelResults[simIndex].swap(channelMetrics);
+   
+   // Reduce every replication of the point that is now next in line.
+   std::map<unsigned int, std::vector<Metric> >::iterator it = 
+      pointResult.pendingResults.find(pointResult.nextSimToReduce);
+   while (it != pointResult.pendingResults.end()) {
+      theResultSink->writeReplication(pointIndex, pointResult.nextSimToReduce, it->second);
+      copyMetrics(pointResult.nodeTotalMetrics, it->second);
+      copyMetrics(pointResult.channelTotalMetrics, pointResult.pendingChannelResults[pointResult.nextSimToReduce]);
+      
+      // Update the confidence intervals, and skip the point's remaining jobs once they are narrow enough.
+      if (theConfigObj->isStoppingEnabled()) {
+         pointResult.stoppingRule.addReplication(&thePoints[pointIndex], it->second);
+         if (pointResult.stoppingRule.isSatisfied()) {
+            pointResult.simLimit = pointResult.nextSimToReduce + 1;
+         }
+      }
+      
+      pointResult.pendingResults.erase(it);
+      pointResult.pendingChannelResults.erase(pointResult.nextSimToReduce);
+      if (++pointResult.nextSimToReduce >= pointResult.simLimit) {
+         pointResult.pendingResults.clear();
+         pointResult.pendingChannelResults.clear();
+         break;
+      }
+      it = pointResult.pendingResults.find(pointResult.nextSimToReduce);
+   }
+   
+   // Report every point that is now next in line.
+   while (theNextPointToReport < thePoints.size() 
+       && thePointResults[theNextPointToReport].nextSimToReduce == thePointResults[theNextPointToReport].simLimit) {
+      PointResult& reportedResult = thePointResults[theNextPointToReport];
+      StoppingRule* stoppingRule = theConfigObj->isStoppingEnabled() ? &reportedResult.stoppingRule : NULL;
+      
+      // The aggregates are averaged over the replications reduced, which the stopping rule may have cut short. The 
+      // point's configuration stays read-only, as workers may still be running its dropped replications.
+      theResultSink->writeAggregates(theNextPointToReport, 
+                                     &thePoints[theNextPointToReport], 
+                                     reportedResult.nextSimToReduce, 
+                                     reportedResult.nodeTotalMetrics, 
+                                     stoppingRule);
+      if (thePoints[theNextPointToReport].getChannelCount() > 1) {
+         theResultSink->writeChannelAggregates(theNextPointToReport, 
+                                               &thePoints[theNextPointToReport], 
+                                               reportedResult.nextSimToReduce, 
+                                               reportedResult.channelTotalMetrics);
+      }
+      
+      // The totals are no longer needed.
+      std::vector<Metric>().swap(reportedResult.nodeTotalMetrics);
+      std::vector<Metric>().swap(reportedResult.channelTotalMetrics);
+      theNextPointToReport++;
+   }
+}
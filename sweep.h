@@ -0,0 +1,102 @@
+/*
+ * Declaration of the SweepRunner class. A class used to execute a parameter sweep: every point of the grid declared 
+ * by the SWEEP_ keys is run for the configured count of replications, all (point x replication) jobs sharing one 
+ * work-stealing pool of worker threads, and each point is reduced to one result row. With STOP_STATISTICS configured, 
+ * each point has its own stopping rule and the rest of its jobs are skipped once the rule is satisfied.
+ */
+
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "helpers.h"
+#include "resultsink.h"
+#include "stopping.h"
+
+class SweepRunner {
+   public:
+      // Constructor with args. Expands the sweep of configObj into its points; exits on an invalid swept value.
+      SweepRunner(Configuration* configObj, ResultSink* resultSink);
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Executes every job and returns once every point has been reported.
+      void run();
+      
+      // Returns the count of worker threads that run() will use.
+      unsigned int determineWorkerCount();
+   
+   private:
+      // One replication of one point.
+      struct SweepJob {
+         unsigned int pointIndex;
+         unsigned int simIndex;
+      };
+      
+      // Jobs owned by one worker. The owner takes jobs from the front (in point order, so its simulation state is 
+      // reused); idle workers steal from the back.
+      struct WorkerQueue {
+         std::mutex mutex;
+         std::deque<SweepJob> jobs;
+      };
+      
+      // Per-point totals of the replications reduced so far. Replications are reduced in order, as in 
+      // ReplicationRunner, so that the point's stopping rule sees them in the same order whatever the worker count.
+      struct PointResult {
+         PointResult(Configuration* pointConfigObj) : stoppingRule(pointConfigObj) {}
+         
+         std::vector<Metric> nodeTotalMetrics;
+         std::vector<Metric> channelTotalMetrics;
+         StoppingRule stoppingRule;
+         
+         // Index of the next replication to be reduced, and count of replications needed (SIMULATION_COUNT until 
+         // the stopping rule is satisfied).
+         unsigned int nextSimToReduce;
+         unsigned int simLimit;
+         
+         // Finished replications waiting on an earlier replication of the point before being reduced.
+         std::map<unsigned int, std::vector<Metric> > pendingResults;
+         std::map<unsigned int, std::vector<Metric> > pendingChannelResults;
+      };
+      
+      // Body of worker workerIndex. Runs its own jobs, then steals from the other workers until none remain.
+      void workerLoop(unsigned int workerIndex);
+      
+      // Takes the next job for workerIndex, from its own queue or stolen from another. Returns false when every queue 
+      // is empty.
+      bool takeJob(unsigned int workerIndex, SweepJob& job);
+      
+      // Returns false if the stopping rule of the job's point was satisfied by earlier replications.
+      bool isJobNeeded(SweepJob& job);
+      
+      // Adds a finished replication to its point and reports, in point order, every point that is complete.
+      void submitResults(unsigned int pointIndex, unsigned int simIndex, std::vector<Metric>& nodeMetrics, 
+                         std::vector<Metric>& channelMetrics);
+      
+      // Base configuration (replications, time slots, engine and so on are shared by every point).
+      Configuration* theConfigObj;
+      
+      // Receives each replication's metrics and each point's aggregates. Only used while holding theResultMutex.
+      ResultSink* theResultSink;
+      
+      // Configuration of each point of the sweep.
+      std::vector<Configuration> thePoints;
+      
+      // Job queue of each worker.
+      std::vector<WorkerQueue> theWorkerQueues;
+      
+      // Guards the reduction state below.
+      std::mutex theResultMutex;
+      
+      // Totals of each point.
+      std::vector<PointResult> thePointResults;
+      
+      // Index of the next point to be reported.
+      unsigned int theNextPointToReport;
+};
+
+#endif   // __SWEEP_H__
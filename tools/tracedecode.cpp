@@ -0,0 +1,44 @@
+/*
+ * This file is the main driver file for trace_decode, which renders a binary event trace written by csma_sim 
+ * (TRACE_FILE) as the text of the verbose log. Usage: trace_decode <trace file> [output file]
+ */
+
+#include <cstdio>
+
+#include "trace.h"
+
+int main(int argc, char* argv[]) {
+   if (argc < 2 || argc > 3) {
+      fprintf(stderr, "Usage: %s <trace file> [output file]\n", argv[0]);
+      return 1;
+   }
+   
+   FILE* in = fopen(argv[1], "rb");
+   if (NULL == in) {
+      fprintf(stderr, "ERROR - failed to open trace file: %s\n", argv[1]);
+      return 1;
+   }
+   
+   FILE* out = stdout;
+   if (3 == argc) {
+      out = fopen(argv[2], "w");
+      if (NULL == out) {
+         fprintf(stderr, "ERROR - failed to open output file: %s\n", argv[2]);
+         fclose(in);
+         return 1;
+      }
+   }
+   
+   bool isDecoded = Tracer::decode(in, out);
+   
+   fclose(in);
+   if (stdout != out) {
+      fclose(out);
+   }
+   
+   if (!isDecoded) {
+      fprintf(stderr, "ERROR - malformed trace file: %s\n", argv[1]);
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Implementation of the Topology class. The carrier-sense graph of TOPOLOGY.
+ */
+
+#include <algorithm>    // std::max, std::min, std::sort, std::unique
+#include <cmath>        // ceil, floor, sqrt
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "rng.h"
+#include "topology.h"
+
+// Topology class constructor. The topology starts without nodes.
+Topology::Topology() {
+   theOffsets.assign(1, 0);
+}
+
+// Lays nodeCount nodes out row by row on a square grid with unit spacing, and links every two nodes at most range 
+// apart.
+void Topology::buildGrid(int nodeCount, double range) {
+   int width = std::max(1, static_cast<int>(ceil(sqrt(static_cast<double>(nodeCount)))));
+   std::vector<double> xs(nodeCount), ys(nodeCount);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      xs[nodeIndex] = nodeIndex % width;
+      ys[nodeIndex] = nodeIndex / width;
+   }
+   linkNearbyNodes(xs, ys, width, (nodeCount + width - 1) / width, range);
+}
+
+// Places nodeCount nodes uniformly at random in a square with one node per unit of area, and links every two nodes at 
+// most range apart. The coordinates are drawn from a generator of their own, keyed by seed, so every replication and 
+// every sweep point of a run shares the layout.
+void Topology::buildGeometric(int nodeCount, double range, uint64_t seed) {
+   CounterRng randomGenerator;
+   randomGenerator.setKey(seed, 0);
+   double side = sqrt(static_cast<double>(nodeCount));
+   std::vector<double> xs(nodeCount), ys(nodeCount);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      xs[nodeIndex] = side * (1.0 - randomGenerator.generateUnitInterval(nodeIndex, RNG_POSITION, 0));
+      ys[nodeIndex] = side * (1.0 - randomGenerator.generateUnitInterval(nodeIndex, RNG_POSITION, 1));
+   }
+   linkNearbyNodes(xs, ys, side, side, range);
+}
+
+// Reads the links of nodeCount nodes from fileName, one pair of node addresses per line ('#' starts a comment). A 
+// link is heard both ways whichever way round it is written; repeated links and links of a node to itself are 
+// dropped. Returns false if the file cannot be read or names a node outside [0, nodeCount).
+bool Topology::loadFile(std::string fileName, int nodeCount) {
+   std::ifstream fileStream(fileName.c_str());
+   if (!fileStream.good()) {
+      std::cout << "ERROR - failed to open TOPOLOGY_FILE: " << fileName << std::endl;
+      return false;
+   }
+   
+   // Read the links, keeping both directions of each.
+   std::vector<std::pair<int, int> > links;
+   std::string line;
+   for (unsigned long lineNumber = 1; std::getline(fileStream, line); lineNumber++) {
+      std::string::size_type commentStart = line.find('#');
+      if (std::string::npos != commentStart) {
+         line.erase(commentStart);
+      }
+      
+      std::istringstream lineStream(line);
+      long firstNode = 0, secondNode = 0;
+      std::string rest;
+      if (!(lineStream >> firstNode)) {
+         continue;
+      }
+      if (!(lineStream >> secondNode) || (lineStream >> rest)
+       || firstNode < 0 || firstNode >= nodeCount || secondNode < 0 || secondNode >= nodeCount) {
+         std::cout << "ERROR - invalid TOPOLOGY_FILE line " << lineNumber << ": " << line
+                   << "; expected two node addresses in [0, " << nodeCount << ")" << std::endl;
+         return false;
+      }
+      if (firstNode != secondNode) {
+         links.push_back(std::make_pair(static_cast<int>(firstNode), static_cast<int>(secondNode)));
+         links.push_back(std::make_pair(static_cast<int>(secondNode), static_cast<int>(firstNode)));
+      }
+   }
+   
+   // Sorted, the links are the rows of the graph in order.
+   std::sort(links.begin(), links.end());
+   links.erase(std::unique(links.begin(), links.end()), links.end());
+   theOffsets.assign(nodeCount + 1, 0);
+   theNeighbours.resize(links.size());
+   for (unsigned long linkIndex = 0; linkIndex < links.size(); linkIndex++) {
+      theOffsets[links[linkIndex].first + 1]++;
+      theNeighbours[linkIndex] = links[linkIndex].second;
+   }
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      theOffsets[nodeIndex + 1] += theOffsets[nodeIndex];
+   }
+   return true;
+}
+
+// Returns the largest count of neighbours of any node.
+int Topology::getMaxDegree() {
+   int maxDegree = 0;
+   for (int nodeIndex = 0; nodeIndex < getNodeCount(); nodeIndex++) {
+      maxDegree = std::max(maxDegree, getDegree(nodeIndex));
+   }
+   return maxDegree;
+}
+
+// Links every two nodes at most range apart, given their coordinates in a width x height area. The nodes are first 
+// bucketed into square cells at least range wide, so each node is only compared with the nodes of the 3 x 3 cells 
+// around its own; building the graph takes time in proportion to the count of links rather than to the square of the 
+// node count.
+void Topology::linkNearbyNodes(std::vector<double>& xs, std::vector<double>& ys, double width, double height,
+                               double range) {
+   // No more cells per side than the grid holds nodes per side, so that a short range cannot blow up the cell count.
+   int nodeCount = static_cast<int>(xs.size());
+   int maxCellsPerSide = static_cast<int>(ceil(sqrt(static_cast<double>(nodeCount))));
+   int columnCount = std::max(1, std::min(maxCellsPerSide, static_cast<int>(floor(width / range))));
+   int rowCount = std::max(1, std::min(maxCellsPerSide, static_cast<int>(floor(height / range))));
+   double cellWidth = width / columnCount;
+   double cellHeight = height / rowCount;
+   
+   // Bucket the nodes by cell (a counting sort, so each cell lists its nodes in ascending order).
+   std::vector<int> nodeCells(nodeCount);
+   std::vector<int> cellOffsets(static_cast<size_t>(columnCount) * rowCount + 1, 0);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      int column = std::min(columnCount - 1, static_cast<int>(xs[nodeIndex] / cellWidth));
+      int row = std::min(rowCount - 1, static_cast<int>(ys[nodeIndex] / cellHeight));
+      nodeCells[nodeIndex] = row * columnCount + column;
+      cellOffsets[nodeCells[nodeIndex] + 1]++;
+   }
+   for (unsigned int cell = 1; cell < cellOffsets.size(); cell++) {
+      cellOffsets[cell] += cellOffsets[cell - 1];
+   }
+   std::vector<int> cellNodes(nodeCount);
+   std::vector<int> cellFill(cellOffsets.begin(), cellOffsets.end() - 1);
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      cellNodes[cellFill[nodeCells[nodeIndex]]++] = nodeIndex;
+   }
+   
+   // Each node's row lists the nodes within range in the cells around its own.
+   double squaredRange = range * range;
+   theOffsets.assign(nodeCount + 1, 0);
+   theNeighbours.clear();
+   for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+      int column = nodeCells[nodeIndex] % columnCount;
+      int row = nodeCells[nodeIndex] / columnCount;
+      for (int otherRow = std::max(0, row - 1); otherRow <= std::min(rowCount - 1, row + 1); otherRow++) {
+         for (int otherColumn = std::max(0, column - 1); otherColumn <= std::min(columnCount - 1, column + 1);
+              otherColumn++) {
+            int cell = otherRow * columnCount + otherColumn;
+            for (int cellIndex = cellOffsets[cell]; cellIndex < cellOffsets[cell + 1]; cellIndex++) {
+               int otherIndex = cellNodes[cellIndex];
+               double deltaX = xs[otherIndex] - xs[nodeIndex];
+               double deltaY = ys[otherIndex] - ys[nodeIndex];
+               if (otherIndex != nodeIndex && deltaX * deltaX + deltaY * deltaY <= squaredRange) {
+                  theNeighbours.push_back(otherIndex);
+               }
+            }
+         }
+      }
+      std::sort(theNeighbours.begin() + theOffsets[nodeIndex], theNeighbours.end());
+      theOffsets[nodeIndex + 1] = theNeighbours.size();
+   }
+}
@@ -0,0 +1,65 @@
+/*
+ * Declaration of the Topology class. The carrier-sense graph of TOPOLOGY: which nodes hear (and so sense and 
+ * interfere with) which. Without a topology every node hears every other node; with one, a node only senses the 
+ * transmits of its neighbours and a frame is only lost if its receiver hears another transmitter while it lasts, so 
+ * two nodes that cannot hear each other (hidden terminals) can both transmit to a receiver between them.
+ *
+ * The graph is undirected and kept in compressed sparse row form: the neighbours of node i, in ascending order, are 
+ * theNeighbours[theOffsets[i], theOffsets[i + 1]). It is built once per run and shared read-only by every 
+ * replication, so it costs 8 bytes per node plus 4 per neighbour whatever the node count.
+ */
+
+#ifndef __TOPOLOGY_H__
+#define __TOPOLOGY_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class Topology {
+   public:
+      // Overwrite the default constructor. The topology starts without nodes.
+      Topology();
+      
+      // Destructor not declared since the default will suffice.
+      
+      // Lays nodeCount nodes out row by row on a square grid with unit spacing, and links every two nodes at most 
+      // range apart (1 links the 4 nearest nodes, 1.5 the 8 nearest).
+      void buildGrid(int nodeCount, double range);
+      
+      // Places nodeCount nodes uniformly at random (keyed by seed) in a square with one node per unit of area, and 
+      // links every two nodes at most range apart.
+      void buildGeometric(int nodeCount, double range, uint64_t seed);
+      
+      // Reads the links of nodeCount nodes from fileName, one pair of node addresses per line ('#' starts a comment). 
+      // Returns false if the file cannot be read or names a node outside [0, nodeCount).
+      bool loadFile(std::string fileName, int nodeCount);
+      
+      // Returns the count of nodes.
+      int getNodeCount() { return static_cast<int>(theOffsets.size()) - 1; }
+      
+      // Returns the count of links (each counted once).
+      uint64_t getLinkCount() { return theNeighbours.size() / 2; }
+      
+      // Returns the largest count of neighbours of any node.
+      int getMaxDegree();
+      
+      // Returns the count of neighbours of a node. Defined inline, with getNeighbours(), as they sit in the per- 
+      // transmit loops.
+      int getDegree(int index) { return static_cast<int>(theOffsets[index + 1] - theOffsets[index]); }
+      
+      // Returns the neighbours of a node, in ascending order.
+      const int* getNeighbours(int index) { return theNeighbours.data() + theOffsets[index]; }
+   
+   private:
+      // Links every two nodes at most range apart, given their coordinates in a width x height area.
+      void linkNearbyNodes(std::vector<double>& xs, std::vector<double>& ys, double width, double height, double range);
+      
+      // Start of each node's neighbours in theNeighbours, with the total count of neighbours last.
+      std::vector<uint64_t> theOffsets;
+      
+      // Neighbours of every node, node by node.
+      std::vector<int> theNeighbours;
+};
+
+#endif   // __TOPOLOGY_H__
@@ -0,0 +1,310 @@
+/*
+ * Implementation of the Tracer class. An asynchronous binary event trace.
+ */
+
+#include <chrono>
+#include <cstring>      // memcmp
+#include <iostream>
+
+#include "trace.h"
+
+// Count of records in each thread's ring.
+static const unsigned int TRACE_RING_CAPACITY = 1 << 16;
+
+// Size past which the writer thread writes its encoded bytes out.
+static const size_t TRACE_BUFFER_THRESHOLD = 1 << 20;
+
+// Magic at the start of every trace file.
+static const char TRACE_MAGIC[8] = { 'C', 'S', 'M', 'A', 'T', 'R', 'C', '1' };
+
+// Verbose log text of each kind of record, given the node, arg0 and arg1.
+static const char* TRACE_FORMATS[TRACE_EVENT_COUNT] = {
+   "",
+   "node %d generating a message\n",
+   "node %d is transmitting\n",
+   "node %d is backed-off\n",
+   "now is node %d's next attempted transmit time\n",
+   "medium is idle for retransmit attempt\n",
+   "medium is NOT idle for retransmit attempt\n",
+   "medium is idle for retransmit attempt and p-persistent node %d will attempt to transmit\n",
+   "p-persistance node %d will wait until next time cycle and try again\n",
+   "medium is idle for transmit so node will transmit\n",
+   "medium is NOT idle for retransmit attempt\n",
+   "collision occurred for node %d, next transmit at time %lld\n",
+   "node %d starting transmit with completion time set to: %lld\n",
+   "node %d completed message transmission\n",
+   "node %d will back-off, reattempting transmission at time %lld, new retransmit attempt counter: %u\n",
+   "node %d dropped a message\n"
+};
+
+bool Tracer::theEnabled = false;
+thread_local uint64_t Tracer::theCurrentSlot = 0;
+thread_local TraceRing* Tracer::theThreadRing = NULL;
+std::vector<uint64_t> Tracer::theNodeFilterBits;
+uint64_t Tracer::theFirstSlot = 0;
+uint64_t Tracer::theLastSlot = 0;
+std::vector<TraceRing*> Tracer::theRings;
+std::mutex Tracer::theRingMutex;
+FILE* Tracer::theFile = NULL;
+std::vector<uint8_t> Tracer::theEncodeBuffer;
+std::thread Tracer::theWriterThread;
+std::atomic<bool> Tracer::theStopRequested(false);
+
+// Helper function that appends value as a varint (7 bits per byte, low bits first).
+static void appendVarint(std::vector<uint8_t>& buffer, uint64_t value) {
+   while (value >= 0x80) {
+      buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+   }
+   buffer.push_back(static_cast<uint8_t>(value));
+}
+
+// Helper function that appends a signed value as a zigzag varint, so that small negative values stay short.
+static void appendSignedVarint(std::vector<uint8_t>& buffer, int64_t value) {
+   appendVarint(buffer, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+// Helper function that reads a varint from in. Returns false at the end of the file.
+static bool readVarint(FILE* in, uint64_t& value) {
+   value = 0;
+   for (int shift = 0; shift < 64; shift += 7) {
+      int byte = fgetc(in);
+      if (EOF == byte) {
+         return false;
+      }
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (0 == (byte & 0x80)) {
+         return true;
+      }
+   }
+   return false;
+}
+
+// Helper function that reads a zigzag varint from in. Returns false at the end of the file.
+static bool readSignedVarint(FILE* in, int64_t& value) {
+   uint64_t encoded = 0;
+   if (!readVarint(in, encoded)) {
+      return false;
+   }
+   value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+   return true;
+}
+
+// Starts tracing to fileName, keeping only the events of nodes in nodeFilter (every node if empty) within 
+// [firstSlot, lastSlot]. Returns false if the file cannot be opened.
+bool Tracer::start(std::string fileName, std::vector<int> nodeFilter, uint64_t firstSlot, uint64_t lastSlot) {
+   theFile = fopen(fileName.c_str(), "wb");
+   if (NULL == theFile) {
+      std::cout << "ERROR - failed to open TRACE_FILE: " << fileName << std::endl;
+      return false;
+   }
+   fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), theFile);
+   
+   theNodeFilterBits.clear();
+   for (unsigned int index = 0; index < nodeFilter.size(); index++) {
+      unsigned int word = nodeFilter[index] >> 6;
+      if (word >= theNodeFilterBits.size()) {
+         theNodeFilterBits.resize(word + 1, 0);
+      }
+      theNodeFilterBits[word] |= 1ULL << (nodeFilter[index] & 63);
+   }
+   theFirstSlot = firstSlot;
+   theLastSlot = lastSlot;
+   theEncodeBuffer.reserve(2 * TRACE_BUFFER_THRESHOLD);
+   
+   theStopRequested = false;
+   theEnabled = true;
+   theWriterThread = std::thread(&Tracer::writerLoop);
+   return true;
+}
+
+// Drains every ring, stops the writer thread and closes the file. The simulation threads must be done by now.
+void Tracer::stop() {
+   if (!theEnabled) {
+      return;
+   }
+   
+   theStopRequested = true;
+   theWriterThread.join();
+   theEnabled = false;
+   fclose(theFile);
+   theFile = NULL;
+   
+   for (unsigned int ringIndex = 0; ringIndex < theRings.size(); ringIndex++) {
+      delete theRings[ringIndex];
+   }
+   theRings.clear();
+}
+
+// Records an event of the calling thread, if it passes the filters. Replication markers always pass. When the ring is 
+// full the thread waits on the writer rather than losing the event.
+void Tracer::record(TRACE_EVENT type, int node, int64_t arg0, uint32_t arg1) {
+   if (TRACE_REPLICATION != type) {
+      if (theCurrentSlot < theFirstSlot || theCurrentSlot > theLastSlot) {
+         return;
+      }
+      if (!theNodeFilterBits.empty() 
+       && ((static_cast<unsigned int>(node >> 6) >= theNodeFilterBits.size()) 
+        || 0 == ((theNodeFilterBits[node >> 6] >> (node & 63)) & 1))) {
+         return;
+      }
+   }
+   
+   TraceRing* ring = getThreadRing();
+   uint64_t head = ring->head.load(std::memory_order_relaxed);
+   while (head - ring->tail.load(std::memory_order_acquire) >= ring->records.size()) {
+      std::this_thread::yield();
+   }
+   
+   TraceRecord& traceRecord = ring->records[head & (ring->records.size() - 1)];
+   traceRecord.slot = theCurrentSlot;
+   traceRecord.node = node;
+   traceRecord.type = type;
+   traceRecord.arg0 = arg0;
+   traceRecord.arg1 = arg1;
+   ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Returns the calling thread's ring, creating and registering it on first use.
+TraceRing* Tracer::getThreadRing() {
+   if (NULL == theThreadRing) {
+      theThreadRing = new TraceRing(TRACE_RING_CAPACITY);
+      std::lock_guard<std::mutex> lock(theRingMutex);
+      theRings.push_back(theThreadRing);
+   }
+   return theThreadRing;
+}
+
+// Body of the writer thread. Drains the rings until stopped, sleeping briefly whenever they are empty.
+void Tracer::writerLoop() {
+   while (!theStopRequested.load(std::memory_order_acquire)) {
+      if (0 == drainRings()) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+   }
+   
+   // The producers are done; pick up whatever they left.
+   drainRings();
+   fwrite(theEncodeBuffer.data(), 1, theEncodeBuffer.size(), theFile);
+   theEncodeBuffer.clear();
+}
+
+// Encodes and writes out the records available in every ring. Returns the count of records encoded.
+unsigned long Tracer::drainRings() {
+   std::vector<TraceRing*> rings;
+   {
+      std::lock_guard<std::mutex> lock(theRingMutex);
+      rings = theRings;
+   }
+   
+   unsigned long recordCount = 0;
+   for (unsigned int ringIndex = 0; ringIndex < rings.size(); ringIndex++) {
+      TraceRing* ring = rings[ringIndex];
+      uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      if (head == tail) {
+         continue;
+      }
+      
+      appendVarint(theEncodeBuffer, ringIndex);
+      appendVarint(theEncodeBuffer, head - tail);
+      for (uint64_t position = tail; position < head; position++) {
+         const TraceRecord& traceRecord = ring->records[position & (ring->records.size() - 1)];
+         appendSignedVarint(theEncodeBuffer, static_cast<int64_t>(traceRecord.slot - ring->lastSlot));
+         appendVarint(theEncodeBuffer, traceRecord.node);
+         theEncodeBuffer.push_back(static_cast<uint8_t>(traceRecord.type));
+         appendSignedVarint(theEncodeBuffer, traceRecord.arg0 - static_cast<int64_t>(traceRecord.slot));
+         appendVarint(theEncodeBuffer, traceRecord.arg1);
+         ring->lastSlot = traceRecord.slot;
+      }
+      ring->tail.store(head, std::memory_order_release);
+      recordCount += head - tail;
+   }
+   
+   if (theEncodeBuffer.size() >= TRACE_BUFFER_THRESHOLD) {
+      fwrite(theEncodeBuffer.data(), 1, theEncodeBuffer.size(), theFile);
+      theEncodeBuffer.clear();
+   }
+   return recordCount;
+}
+
+// Renders the trace in file in as the verbose log's text, to out. A time slot header is written whenever the ring or 
+// the time slot changes. Returns false on a malformed trace.
+bool Tracer::decode(FILE* in, FILE* out) {
+   char magic[sizeof(TRACE_MAGIC)];
+   if (sizeof(magic) != fread(magic, 1, sizeof(magic), in) || 0 != memcmp(magic, TRACE_MAGIC, sizeof(magic))) {
+      return false;
+   }
+   
+   // Per-ring decoding state: last slot, replication and engine.
+   std::vector<uint64_t> lastSlots;
+   std::vector<uint64_t> replications;
+   std::vector<uint32_t> engines;
+   
+   // Ring and slot of the last header written.
+   bool isSlotOpen = false;
+   uint64_t openRing = 0, openSlot = 0;
+   
+   uint64_t ringIndex = 0, recordCount = 0;
+   while (readVarint(in, ringIndex)) {
+      if (!readVarint(in, recordCount)) {
+         return false;
+      }
+      if (ringIndex >= lastSlots.size()) {
+         lastSlots.resize(ringIndex + 1, 0);
+         replications.resize(ringIndex + 1, 0);
+         engines.resize(ringIndex + 1, 0);
+      }
+      
+      for (uint64_t recordIndex = 0; recordIndex < recordCount; recordIndex++) {
+         int64_t slotDelta = 0, argDelta = 0;
+         uint64_t node = 0, arg1 = 0;
+         int type = 0;
+         if (!readSignedVarint(in, slotDelta) || !readVarint(in, node) || EOF == (type = fgetc(in)) 
+          || !readSignedVarint(in, argDelta) || !readVarint(in, arg1) || type >= TRACE_EVENT_COUNT) {
+            return false;
+         }
+         uint64_t slot = lastSlots[ringIndex] + slotDelta;
+         int64_t arg0 = argDelta + static_cast<int64_t>(slot);
+         lastSlots[ringIndex] = slot;
+         
+         if (TRACE_REPLICATION == type) {
+            replications[ringIndex] = arg0;
+            engines[ringIndex] = arg1;
+            if (isSlotOpen && ringIndex == openRing) {
+               isSlotOpen = false;
+               if (0 == engines[openRing]) {
+                  fputs("\n", out);
+               }
+            }
+            continue;
+         }
+         
+         // Start a new time slot section.
+         if (!isSlotOpen || ringIndex != openRing || slot != openSlot) {
+            if (isSlotOpen && 0 == engines[openRing]) {
+               fputs("\n", out);
+            }
+            if (0 == engines[ringIndex]) {
+               fprintf(out, "---- sim %llu timeIndex: %llu ----\n", 
+                            static_cast<unsigned long long>(replications[ringIndex]), 
+                            static_cast<unsigned long long>(slot));
+            }
+            else {
+               fprintf(out, "---- event timeIndex: %llu ----\n", static_cast<unsigned long long>(slot));
+            }
+            isSlotOpen = true;
+            openRing = ringIndex;
+            openSlot = slot;
+         }
+         
+         fprintf(out, TRACE_FORMATS[type], static_cast<int>(node), static_cast<long long>(arg0), 
+                 static_cast<unsigned int>(arg1));
+      }
+   }
+   
+   if (isSlotOpen && 0 == engines[openRing]) {
+      fputs("\n", out);
+   }
+   return true;
+}
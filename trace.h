@@ -0,0 +1,144 @@
+/*
+ * Declaration of the Tracer class. An asynchronous binary event trace, the low-overhead alternative to verbose 
+ * logging for long runs.
+ *
+ * Each simulation thread appends fixed-size TraceRecords to its own lock-free single-producer/single-consumer ring. A 
+ * background writer thread drains the rings and writes them delta/varint encoded, so tracing never blocks on I/O 
+ * unless a ring fills up. Records outside the configured node set or slot window are rejected before they are 
+ * queued. tools/tracedecode.cpp renders a trace file back into the verbose log's text.
+ *
+ * File layout: the 8-byte magic "CSMATRC1", then chunks of [varint ring][varint record count][records]. Per ring, a 
+ * record is [zigzag varint slot delta][varint node][type byte][zigzag varint (arg0 - slot)][varint arg1], the slot 
+ * delta being relative to the ring's previous record.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Enum representing the kind of a trace record. Every kind matches one verbose log line.
+typedef enum TRACE_EVENT {
+   TRACE_REPLICATION = 0,     // start of a replication; arg0 is the replication index, arg1 the engine
+   TRACE_GENERATE,            // node generated a message
+   TRACE_TRANSMITTING,        // node is transmitting
+   TRACE_BACKED_OFF,          // node is backed-off
+   TRACE_ATTEMPT_DUE,         // node's next attempted transmit time is now
+   TRACE_RETRANSMIT_IDLE,     // medium is idle for the node's retransmit attempt
+   TRACE_RETRANSMIT_BUSY,     // medium is busy for the node's retransmit attempt
+   TRACE_PERSIST_ATTEMPT,     // p-persistent node will attempt to transmit
+   TRACE_PERSIST_WAIT,        // p-persistent node waits until the next time slot
+   TRACE_TRANSMIT_IDLE,       // medium is idle for the node's transmit
+   TRACE_TRANSMIT_BUSY,       // medium is busy for the node's transmit
+   TRACE_COLLISION,           // node collided; arg0 is the next attempted transmit time
+   TRACE_TRANSMIT_START,      // node started a transmit; arg0 is the time of completion
+   TRACE_TRANSMIT_COMPLETE,   // node completed a transmit
+   TRACE_BACKOFF,             // node backed-off; arg0 is the next attempted transmit time, arg1 the retransmit count
+   TRACE_DROP,                // node dropped a message
+   TRACE_EVENT_COUNT
+} TRACE_EVENT;
+
+// One traced event.
+struct TraceRecord {
+   uint64_t slot;
+   uint32_t node;
+   uint32_t type;
+   int64_t arg0;
+   uint32_t arg1;
+};
+
+// Single-producer/single-consumer ring of trace records. The producer is the simulation thread that owns it, the 
+// consumer the writer thread.
+struct TraceRing {
+   // Constructor with args. capacity must be a power of 2.
+   TraceRing(unsigned int capacity) : records(capacity), head(0), tail(0), lastSlot(0) {}
+   
+   std::vector<TraceRecord> records;
+   
+   // Count of records ever pushed (written by the producer) and popped (written by the consumer).
+   std::atomic<uint64_t> head;
+   std::atomic<uint64_t> tail;
+   
+   // Slot of the last record encoded from this ring (writer thread only).
+   uint64_t lastSlot;
+};
+
+class Tracer {
+   public:
+      // Starts tracing to fileName, keeping only the events of nodes in nodeFilter (every node if empty) within 
+      // [firstSlot, lastSlot]. Returns false if the file cannot be opened.
+      static bool start(std::string fileName, std::vector<int> nodeFilter, uint64_t firstSlot, uint64_t lastSlot);
+      
+      // Drains every ring, stops the writer thread and closes the file.
+      static void stop();
+      
+      // Returns true while tracing.
+      static bool isEnabled() { return theEnabled; }
+      
+      // Sets the time slot of the calling thread's following events.
+      static void setSlot(uint64_t slot) { theCurrentSlot = slot; }
+      
+      // Records an event of the calling thread, if it passes the filters.
+      static void record(TRACE_EVENT type, int node, int64_t arg0, uint32_t arg1);
+      
+      // Renders the trace in file in as the verbose log's text, to out. Returns false on a malformed trace.
+      static bool decode(FILE* in, FILE* out);
+   
+   private:
+      // Body of the writer thread. Drains the rings until stopped.
+      static void writerLoop();
+      
+      // Encodes and writes out the records available in every ring. Returns the count of records written.
+      static unsigned long drainRings();
+      
+      // Returns the calling thread's ring, creating and registering it on first use.
+      static TraceRing* getThreadRing();
+      
+      // True while tracing.
+      static bool theEnabled;
+      
+      // Time slot of the calling thread's events.
+      static thread_local uint64_t theCurrentSlot;
+      
+      // Ring of the calling thread.
+      static thread_local TraceRing* theThreadRing;
+      
+      // Node filter, one bit per node (every node if empty), and slot window.
+      static std::vector<uint64_t> theNodeFilterBits;
+      static uint64_t theFirstSlot;
+      static uint64_t theLastSlot;
+      
+      // Every ring created, in creation order (a ring's index is its id in the file). Guarded by theRingMutex.
+      static std::vector<TraceRing*> theRings;
+      static std::mutex theRingMutex;
+      
+      // Destination of the trace, and the encoded bytes not yet written to it (writer thread only).
+      static FILE* theFile;
+      static std::vector<uint8_t> theEncodeBuffer;
+      
+      // Writer thread and its stop request.
+      static std::thread theWriterThread;
+      static std::atomic<bool> theStopRequested;
+};
+
+// Records an event in the trace. Inline so that it costs a single test when tracing is off.
+inline void traceEvent(TRACE_EVENT type, int node, int64_t arg0 = 0, uint32_t arg1 = 0) {
+   if (Tracer::isEnabled()) {
+      Tracer::record(type, node, arg0, arg1);
+   }
+}
+
+// Sets the time slot of the calling thread's following trace events.
+inline void traceSlot(uint64_t slot) {
+   if (Tracer::isEnabled()) {
+      Tracer::setSlot(slot);
+   }
+}
+
+#endif   // __TRACE_H__